@@ -53,6 +53,7 @@
 #include <gsl/gsl_statistics_double.h>
 #include <gsl/gsl_cdf.h>
 #include <search.h>
+#include <pthread.h>
 
 #ifdef LS_DISTANCE_LONGINT
 #  include <gsl/gsl_sort_long.h>
@@ -85,8 +86,8 @@ inline int
 LSA_segment_length(LS_List *solPtr,int node1, int node2)
 {
   int n=solPtr->no_cities,k=0,i=-1,j=-1;
-  i=solPtr->position_array[node1];
-  j=solPtr->position_array[node2];
+  i=LS_POSITION(solPtr,node1);
+  j=LS_POSITION(solPtr,node2);
   //printf("pos:%d\t%d\n",i,j);
 
   if(j==i)
@@ -108,7 +109,6 @@ LSA_2opt_delta_sample_estimate(LS_List *solPtr,
   long int delta = 0;
   int j;
   struct LS_city *this;
-  const LS_DISTANCE **D = solPtr->distances;
   int window_length=0;
   int imp_flag;
   double correction=1.0;
@@ -128,7 +128,7 @@ LSA_2opt_delta_sample_estimate(LS_List *solPtr,
         {
           if(imp_flag && importance_sampling)
             {
-              if (this->two_opt_biased_realizations[j])
+              if (LS_REALIZATION_TEST(this->two_opt_biased_realizations,j))
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[1];
@@ -138,15 +138,15 @@ LSA_2opt_delta_sample_estimate(LS_List *solPtr,
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[0];
-                  this = this->next;
+                  this = LS_NEXT_CITY(solPtr,this);
                 }
             }
           else
             {
               imp_flag=0;
-              if (this->realizations[j])
+              if (LS_REALIZATION_TEST(this->realizations,j))
                 break;
-              this = this->next;
+              this = LS_NEXT_CITY(solPtr,this);
             }
 #ifdef LS_EXTRA_STATS_OUTPUT
           solPtr->two_opt_scans_made++;
@@ -170,7 +170,7 @@ LSA_2opt_delta_sample_estimate(LS_List *solPtr,
         {
           if(imp_flag && importance_sampling )
             {
-              if (this->two_opt_biased_realizations[j])
+              if (LS_REALIZATION_TEST(this->two_opt_biased_realizations,j))
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[1];
@@ -180,15 +180,15 @@ LSA_2opt_delta_sample_estimate(LS_List *solPtr,
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[0];
-                  this = this->prev;
+                  this = LS_PREV_CITY(solPtr,this);
                 }
             }
           else
             {
               imp_flag=0;
-              if (this->realizations[j])
+              if (LS_REALIZATION_TEST(this->realizations,j))
                 break;
-              this = this->prev;
+              this = LS_PREV_CITY(solPtr,this);
             }
 #ifdef LS_EXTRA_STATS_OUTPUT
           solPtr->two_opt_scans_made++;
@@ -213,7 +213,7 @@ LSA_2opt_delta_sample_estimate(LS_List *solPtr,
         {
           if(imp_flag && importance_sampling  )
             {
-              if (this->two_opt_biased_realizations[j])
+              if (LS_REALIZATION_TEST(this->two_opt_biased_realizations,j))
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[1];
@@ -223,15 +223,15 @@ LSA_2opt_delta_sample_estimate(LS_List *solPtr,
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[0];
-                  this = this->next;
+                  this = LS_NEXT_CITY(solPtr,this);
                 }
             }
           else
             {
               imp_flag=0;
-              if (this->realizations[j])
+              if (LS_REALIZATION_TEST(this->realizations,j))
                 break;
-              this = this->next;
+              this = LS_NEXT_CITY(solPtr,this);
             }
 #ifdef LS_EXTRA_STATS_OUTPUT
           solPtr->two_opt_scans_made++;
@@ -254,7 +254,7 @@ LSA_2opt_delta_sample_estimate(LS_List *solPtr,
 
           if( imp_flag && importance_sampling )
             {
-              if (this->two_opt_biased_realizations[j])
+              if (LS_REALIZATION_TEST(this->two_opt_biased_realizations,j))
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[1];
@@ -264,16 +264,16 @@ LSA_2opt_delta_sample_estimate(LS_List *solPtr,
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[0];
-                  this = this->prev;
+                  this = LS_PREV_CITY(solPtr,this);
                 }
 
             }
           else
             {
               imp_flag=0;
-              if (this->realizations[j])
+              if (LS_REALIZATION_TEST(this->realizations,j))
                 break;
-              this = this->prev;
+              this = LS_PREV_CITY(solPtr,this);
             }
 
 #ifdef LS_EXTRA_STATS_OUTPUT
@@ -286,10 +286,10 @@ LSA_2opt_delta_sample_estimate(LS_List *solPtr,
         return 0.0;
       cover1fst = this->city;
 
-      delta =-D[cover0fst][cover0snd]
-             -D[cover1fst][cover1snd]
-             +D[cover0fst][cover1fst]
-             +D[cover1snd][cover0snd];
+      delta =-LS_DIST(solPtr,cover0fst,cover0snd)
+             -LS_DIST(solPtr,cover1fst,cover1snd)
+             +LS_DIST(solPtr,cover0fst,cover1fst)
+             +LS_DIST(solPtr,cover1snd,cover0snd);
     }
 
 
@@ -307,7 +307,6 @@ LSA_2hopt_delta_sample_estimate(LS_List *solPtr,
   long int sum_delta = 0;
   int j;
   struct LS_city *this=NULL;
-  const LS_DISTANCE **D = solPtr->distances;
 
   double correction=1.0;
   int imp_flag;
@@ -317,7 +316,7 @@ LSA_2hopt_delta_sample_estimate(LS_List *solPtr,
     {
       if(importance_sampling)
         {
-          if (!(solPtr->array[node].two_h_opt_biased_realizations[j]))
+          if (!(LS_REALIZATION_TEST(solPtr->array[node].two_h_opt_biased_realizations,j)))
             {
               return 0.0;
             }
@@ -326,7 +325,7 @@ LSA_2hopt_delta_sample_estimate(LS_List *solPtr,
         }
       else
         {
-          if (!solPtr->array[node].realizations[j])
+          if (!LS_REALIZATION_TEST(solPtr->array[node].realizations,j))
             {
               return 0.0;
             }
@@ -349,7 +348,7 @@ LSA_2hopt_delta_sample_estimate(LS_List *solPtr,
         {
           if(imp_flag && importance_sampling)
             {
-              if (this->two_opt_biased_realizations[j])
+              if (LS_REALIZATION_TEST(this->two_opt_biased_realizations,j))
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[1];
@@ -359,15 +358,15 @@ LSA_2hopt_delta_sample_estimate(LS_List *solPtr,
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[0];
-                  this = this->next;
+                  this = LS_NEXT_CITY(solPtr,this);
                 }
             }
           else
             {
               imp_flag=0;
-              if (this->realizations[j])
+              if (LS_REALIZATION_TEST(this->realizations,j))
                 break;
-              this = this->next;
+              this = LS_NEXT_CITY(solPtr,this);
             }
 #ifdef LS_EXTRA_STATS_OUTPUT
           solPtr->two_opt_scans_made++;
@@ -393,7 +392,7 @@ LSA_2hopt_delta_sample_estimate(LS_List *solPtr,
         {
           if(imp_flag && importance_sampling)
             {
-              if (this->two_opt_biased_realizations[j])
+              if (LS_REALIZATION_TEST(this->two_opt_biased_realizations,j))
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[1];
@@ -403,15 +402,15 @@ LSA_2hopt_delta_sample_estimate(LS_List *solPtr,
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[0];
-                  this = this->prev;
+                  this = LS_PREV_CITY(solPtr,this);
                 }
             }
           else
             {
               imp_flag=0;
-              if (this->realizations[j])
+              if (LS_REALIZATION_TEST(this->realizations,j))
                 break;
-              this = this->prev;
+              this = LS_PREV_CITY(solPtr,this);
             }
 #ifdef LS_EXTRA_STATS_OUTPUT
           solPtr->two_opt_scans_made++;
@@ -438,7 +437,7 @@ LSA_2hopt_delta_sample_estimate(LS_List *solPtr,
         {
           if(imp_flag && importance_sampling )
             {
-              if (this->two_opt_biased_realizations[j])
+              if (LS_REALIZATION_TEST(this->two_opt_biased_realizations,j))
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[1];
@@ -448,15 +447,15 @@ LSA_2hopt_delta_sample_estimate(LS_List *solPtr,
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[0];
-                  this = this->next;
+                  this = LS_NEXT_CITY(solPtr,this);
                 }
             }
           else
             {
               imp_flag=0;
-              if (this->realizations[j])
+              if (LS_REALIZATION_TEST(this->realizations,j))
                 break;
-              this = this->next;
+              this = LS_NEXT_CITY(solPtr,this);
             }
 #ifdef LS_EXTRA_STATS_OUTPUT
           solPtr->two_opt_scans_made++;
@@ -483,7 +482,7 @@ LSA_2hopt_delta_sample_estimate(LS_List *solPtr,
 
           if( imp_flag && importance_sampling )
             {
-              if (this->two_opt_biased_realizations[j])
+              if (LS_REALIZATION_TEST(this->two_opt_biased_realizations,j))
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[1];
@@ -493,16 +492,16 @@ LSA_2hopt_delta_sample_estimate(LS_List *solPtr,
                 {
                   imp_flag=0;
                   correction*=this->correction_two_opt[0];
-                  this = this->prev;
+                  this = LS_PREV_CITY(solPtr,this);
                 }
 
             }
           else
             {
               imp_flag=0;
-              if (this->realizations[j])
+              if (LS_REALIZATION_TEST(this->realizations,j))
                 break;
-              this = this->prev;
+              this = LS_PREV_CITY(solPtr,this);
             }
 
 #ifdef LS_EXTRA_STATS_OUTPUT
@@ -516,12 +515,12 @@ LSA_2hopt_delta_sample_estimate(LS_List *solPtr,
       cover1fst = this->city;
 
 
-      sum_delta +=-D[cover0fst][cover0snd]
-                  -D[cover1fst][node]
-                  -D[node][cover1snd]
-                  +D[cover0fst][node]
-                  +D[node][cover0snd]
-                  +D[cover1fst][cover1snd];
+      sum_delta +=-LS_DIST(solPtr,cover0fst,cover0snd)
+                  -LS_DIST(solPtr,cover1fst,node)
+                  -LS_DIST(solPtr,node,cover1snd)
+                  +LS_DIST(solPtr,cover0fst,node)
+                  +LS_DIST(solPtr,node,cover0snd)
+                  +LS_DIST(solPtr,cover1fst,cover1snd);
     }
 
 
@@ -543,7 +542,8 @@ LSA_solution_add_realization(LS_List solution,
 
   for (i=0;i<solution.no_cities;i++)
     {
-      solution.array[i].realizations[realization_number] = realization[i];
+      LS_REALIZATION_ASSIGN(solution.array[i].realizations,
+                            realization_number,realization[i]);
     }
   free(realization);
 }
@@ -570,9 +570,13 @@ LS_delta(LS_List *solPtr,
       if(opt==0)
         delta= LSA_2opt_delta_sample_estimate(solPtr,edge0fst, edge0snd,
                                               edge1fst, edge1snd,index_realization, 0);
-      else
+      else if(opt==1)
         delta= LSA_2hopt_delta_sample_estimate(solPtr,edge0fst, edge0snd,node,
                                                edge1fst, edge1snd,index_realization, 0);
+      else
+        delta= LSA_oropt_delta_sample_estimate(solPtr,edge0fst,edge0snd,node,
+                                               edge1fst,edge1snd,opt==LSA_OR_OPT_REVERSED,
+                                               index_realization);
       sum_delta +=delta;
       index_realization++;
     }
@@ -591,22 +595,10 @@ LS_delta(LS_List *solPtr,
 }
 
 
-double
-LSA_delta_adaptive_sample(LS_List *solPtr,
-                          int edge0fst, int edge0snd, int node,int edge1fst, int edge1snd,
-                          gsl_rng *r, int opt)
+int
+LSA_alpha_index(double alpha)
 {
-  long int sum_delta = 0;
-  double delta=0.0;
-  double mean_delta=0.0;
-  double sd_delta=0.0;
-  double sd_estimator_delta=0.0;
-  double sum_delta_sqr=0.0;
-  int index_realization=0;
-  int realization=0;
-  double chebyshev_k=0.0;
   int alpha_index=0;
-  double alpha=solPtr->alpha;
 
   if(!gsl_fcmp(alpha,0.10,0.0000001))
     {
@@ -626,9 +618,266 @@ LSA_delta_adaptive_sample(LS_List *solPtr,
     }
   else
     {
-      printf("wrong alpha type\n");
-      exit(0);
+      alpha_index=-1;
     }
+  return alpha_index;
+}
+
+
+/* The t-test of the adaptive sampling: whether the mean of no_samples
+   deltas, of sum sum_delta and sum of squares sum_delta_sqr, is
+   significantly different from 0 at the level of alpha_index, see
+   LSA_alpha_index. The mean is stored in mean_delta. */
+static inline int
+LSA_t_test(double sum_delta, double sum_delta_sqr, int no_samples,
+           int alpha_index, double *mean_delta)
+{
+  double sd_delta, sd_estimator_delta, chebyshev_k;
+
+  *mean_delta=sum_delta/(double)no_samples;
+  sd_delta=sqrt((sum_delta_sqr
+                 +no_samples*pow(*mean_delta,2)
+                 -2*(*mean_delta)*sum_delta)
+                /(double)(no_samples-1));
+  sd_estimator_delta=sd_delta/sqrt(no_samples);
+
+  chebyshev_k=percentage_points_t_distribution[121][alpha_index];
+
+  return fabs(*mean_delta) >= ((sd_estimator_delta * chebyshev_k));
+}
+
+
+/* Delta of a move on one realization, as estimated by the adaptive
+   sampling */
+static double
+LSA_realization_delta(LS_List *solPtr,
+                      int edge0fst, int edge0snd, int node,
+                      int edge1fst, int edge1snd, int realization, int opt)
+{
+  if(opt==0)
+    {
+      if(solPtr->importance_sampling_flag==0)
+        return LSA_2opt_delta_sample_estimate(solPtr,edge0fst, edge0snd,
+                                              edge1fst, edge1snd, realization,0);
+      else
+        return LSA_2opt_delta_sample_estimate_window(solPtr,edge0fst, edge0snd,
+               edge1fst, edge1snd, realization,solPtr->importance_sampling_flag);
+    }
+  else if(opt==1)
+    {
+      if(solPtr->importance_sampling_flag==0)
+        return LSA_2hopt_delta_sample_estimate(solPtr,edge0fst,edge0snd,node,
+                                               edge1fst, edge1snd, realization,0);
+      else
+        return LSA_2hopt_delta_sample_estimate_window(solPtr,edge0fst,edge0snd,node,
+               edge1fst, edge1snd, realization,solPtr->importance_sampling_flag);
+    }
+  else
+    return LSA_oropt_delta_sample_estimate(solPtr,edge0fst,edge0snd,node,
+                                           edge1fst,edge1snd,opt==LSA_OR_OPT_REVERSED,
+                                           realization);
+}
+
+
+/* Threads computing the deltas of a move on a chunk of realizations
+   at once, see LSA_solution_set_realization_threads. The calling
+   thread is one of them. */
+struct LSA_realization_pool
+  {
+    int no_threads;
+    int chunk;
+    pthread_t *threads;
+    pthread_mutex_t busy;            /* held while evaluating a move */
+    pthread_mutex_t lock;
+    pthread_cond_t start, done;
+    unsigned int generation;         /* of the chunk being evaluated */
+    int pending;                     /* threads still evaluating it */
+    int quit;
+
+    /* The chunk */
+    int edge0fst, edge0snd, node, edge1fst, edge1snd, opt;
+    const int *realization;
+    int no_realizations;
+    int next;                        /* next realization to be taken */
+    double *delta;
+    LS_List *view;                   /* what each thread evaluates on */
+  };
+
+static void
+LSA_evaluate_realizations(struct LSA_realization_pool *pool, int t)
+{
+  int k;
+
+  while ((k = __sync_fetch_and_add(&pool->next,1)) < pool->no_realizations)
+    pool->delta[k] = LSA_realization_delta(&pool->view[t],pool->edge0fst,pool->edge0snd,
+                                           pool->node,pool->edge1fst,pool->edge1snd,
+                                           pool->realization[k],pool->opt);
+}
+
+static void
+*LSA_realization_worker(void *arg)
+{
+  struct LSA_realization_pool *pool = ((LS_List *)arg)->realization_pool;
+  int t = (LS_List *)arg - pool->view;
+  unsigned int generation = 0;
+
+  pthread_mutex_lock(&pool->lock);
+  for (;;)
+    {
+      while (pool->generation == generation && !pool->quit)
+        pthread_cond_wait(&pool->start,&pool->lock);
+      if (pool->quit)
+        break;
+      generation = pool->generation;
+      pthread_mutex_unlock(&pool->lock);
+
+      LSA_evaluate_realizations(pool,t);
+
+      pthread_mutex_lock(&pool->lock);
+      if (--pool->pending == 0)
+        pthread_cond_signal(&pool->done);
+    }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+/* Compute in pool->delta the deltas of the move on the realizations
+   begin to end-1 of the realization order */
+static void
+LSA_evaluate_chunk(LS_List *solPtr, struct LSA_realization_pool *pool,
+                   int edge0fst, int edge0snd, int node,
+                   int edge1fst, int edge1snd, int opt, int begin, int end)
+{
+  int t;
+#ifdef LS_EXTRA_STATS_OUTPUT
+  int two_opt_scans_made, two_h_opt_scans_made;
+#endif
+
+  pool->edge0fst = edge0fst;
+  pool->edge0snd = edge0snd;
+  pool->node = node;
+  pool->edge1fst = edge1fst;
+  pool->edge1snd = edge1snd;
+  pool->opt = opt;
+  pool->realization = solPtr->realization_order + begin;
+  pool->no_realizations = end - begin;
+  pool->next = 0;
+  for (t=0; t<pool->no_threads; t++)
+    {
+      pool->view[t] = *solPtr;
+      pool->view[t].realization_pool = pool;
+    }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->generation++;
+  pool->pending = pool->no_threads-1;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+  LSA_evaluate_realizations(pool,0);
+  pthread_mutex_lock(&pool->lock);
+  while (pool->pending)
+    pthread_cond_wait(&pool->done,&pool->lock);
+  pthread_mutex_unlock(&pool->lock);
+
+#ifdef LS_EXTRA_STATS_OUTPUT
+  two_opt_scans_made = solPtr->two_opt_scans_made;
+  two_h_opt_scans_made = solPtr->two_h_opt_scans_made;
+  for (t=0; t<pool->no_threads; t++)
+    {
+      solPtr->two_opt_scans_made += pool->view[t].two_opt_scans_made - two_opt_scans_made;
+      solPtr->two_h_opt_scans_made += pool->view[t].two_h_opt_scans_made - two_h_opt_scans_made;
+    }
+#endif
+}
+
+
+void
+LSA_solution_set_realization_threads(LS_List *solPtr, int no_threads, int chunk)
+{
+  struct LSA_realization_pool *pool;
+  int t;
+
+  assert(!solPtr->realization_pool);
+  if (no_threads <= 1)
+    return;
+  pool = malloc(sizeof(struct LSA_realization_pool));
+  if (!pool)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  pool->no_threads = 1;
+  pool->chunk = GSL_MAX(chunk,1);
+  pool->generation = 0;
+  pool->pending = 0;
+  pool->quit = FALSE;
+  pool->threads = malloc(no_threads*sizeof(pthread_t));
+  pool->delta = malloc(pool->chunk*sizeof(double));
+  pool->view = malloc(no_threads*sizeof(LS_List));
+  if (!pool->threads || !pool->delta || !pool->view)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  pthread_mutex_init(&pool->busy,NULL);
+  pthread_mutex_init(&pool->lock,NULL);
+  pthread_cond_init(&pool->start,NULL);
+  pthread_cond_init(&pool->done,NULL);
+  solPtr->realization_pool = pool;
+  for (t=0; t<no_threads; t++)
+    pool->view[t].realization_pool = pool;
+  /* With fewer threads than asked for, the chunks are just evaluated
+     by fewer of them */
+  for (t=1; t<no_threads; t++)
+    {
+      if (pthread_create(&pool->threads[t],NULL,LSA_realization_worker,&pool->view[t]))
+        break;
+      pool->no_threads++;
+    }
+}
+
+
+void
+LSA_realization_pool_free(struct LSA_realization_pool *pool)
+{
+  int t;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->quit = TRUE;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+  for (t=1; t<pool->no_threads; t++)
+    pthread_join(pool->threads[t],NULL);
+  pthread_mutex_destroy(&pool->busy);
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->start);
+  pthread_cond_destroy(&pool->done);
+  free(pool->threads);
+  free(pool->delta);
+  free(pool->view);
+  free(pool);
+}
+
+
+double
+LSA_delta_adaptive_sample(LS_List *solPtr,
+                          int edge0fst, int edge0snd, int node,int edge1fst, int edge1snd,
+                          gsl_rng *r, int opt)
+{
+  long int sum_delta = 0;
+  double delta=0.0;
+  double mean_delta=0.0;
+  double sum_delta_sqr=0.0;
+  int index_realization=0;
+  int realization=0;
+  int alpha_index=0;
+  double alpha=solPtr->alpha;
+  struct LSA_realization_pool *pool=solPtr->realization_pool;
+  int chunk_begin=0, chunk_end=0;
+
+  alpha_index=LSA_alpha_index(alpha);
+  if (alpha_index<0)
+    error(EXIT_FAILURE,0,"Illegal alpha %g for the t-test",alpha);
+
+  /* The pool serves one move at a time: the moves evaluated meanwhile
+     by other threads, see LS_solution_set_evaluation_threads, do
+     without it */
+  if (pool && pthread_mutex_trylock(&pool->busy))
+    pool=NULL;
 
   solPtr->move_status=FALSE;
 
@@ -640,50 +889,38 @@ LSA_delta_adaptive_sample(LS_List *solPtr,
       solPtr->samples_used++;
 #endif
 
-      realization=solPtr->realization_order[index_realization];
-      if(opt==0)
+      if (pool)
         {
-          if(solPtr->importance_sampling_flag==0)
-            delta=LSA_2opt_delta_sample_estimate(solPtr,edge0fst, edge0snd,
-                                                 edge1fst, edge1snd, realization,0);
-          else
-            delta=LSA_2opt_delta_sample_estimate_window(solPtr,edge0fst, edge0snd,
-                  edge1fst, edge1snd, realization,solPtr->importance_sampling_flag);
+          /* The deltas of the chunk are computed at once, and then
+             taken in order as if computed one by one */
+          if (index_realization == chunk_end)
+            {
+              chunk_begin = index_realization;
+              chunk_end = GSL_MIN(chunk_begin+pool->chunk,solPtr->maximum_realizations);
+              LSA_evaluate_chunk(solPtr,pool,edge0fst,edge0snd,node,edge1fst,edge1snd,
+                                 opt,chunk_begin,chunk_end);
+            }
+          delta=pool->delta[index_realization-chunk_begin];
         }
       else
         {
-          if(solPtr->importance_sampling_flag==0)
-            delta=LSA_2hopt_delta_sample_estimate(solPtr,edge0fst,edge0snd,node,
-                                                  edge1fst, edge1snd, realization,0);
-          else
-            delta=LSA_2hopt_delta_sample_estimate_window(solPtr,edge0fst,edge0snd,node,
-                  edge1fst, edge1snd, realization,solPtr->importance_sampling_flag);
+          realization=solPtr->realization_order[index_realization];
+          delta=LSA_realization_delta(solPtr,edge0fst,edge0snd,node,
+                                      edge1fst,edge1snd,realization,opt);
         }
 
       sum_delta +=delta;
       sum_delta_sqr+=pow(delta,2);
 
-      if(index_realization > solPtr->minimum_realizations-1)
-        {
-          mean_delta=sum_delta/(double)(index_realization+1);
-          sd_delta=sqrt((sum_delta_sqr
-                         +(index_realization+1)*pow(mean_delta,2)
-                         -2*mean_delta*sum_delta)
-                        /(double)(index_realization));
-
-          sd_estimator_delta=sd_delta/sqrt(index_realization+1);
-
-
-          chebyshev_k=percentage_points_t_distribution[121][alpha_index];
-
-          if(fabs(mean_delta) >= ((sd_estimator_delta * chebyshev_k)))
-            {
-              break;
-            }
-        }
+      if(index_realization > solPtr->minimum_realizations-1 &&
+         LSA_t_test(sum_delta,sum_delta_sqr,index_realization+1,alpha_index,&mean_delta))
+        break;
     }
 
 
+  if (pool)
+    pthread_mutex_unlock(&pool->busy);
+
   if (mean_delta < 0.0 )
     solPtr->move_status=TRUE;
 
@@ -707,7 +944,6 @@ LSA_2opt_delta_sample_estimate_window(LS_List *solPtr,
   long int delta = 0;
   int k,j;
   struct LS_city *this;
-  const LS_DISTANCE **D = solPtr->distances;
   int window_size=solPtr->window_size;
   int no_nodes_inside_window;
   int window_length=0;
@@ -732,7 +968,7 @@ LSA_2opt_delta_sample_estimate_window(LS_List *solPtr,
           k=0;
           if((window_length < window_size) && (k < no_nodes_inside_window))
             {
-              if (this->two_opt_biased_realizations[j])
+              if (LS_REALIZATION_TEST(this->two_opt_biased_realizations,j))
                 {
                   correction*=this->correction_two_opt[1];
                   break;
@@ -740,15 +976,15 @@ LSA_2opt_delta_sample_estimate_window(LS_List *solPtr,
               else
                 {
                   correction*=this->correction_two_opt[0];
-                  this = this->next;
+                  this = LS_NEXT_CITY(solPtr,this);
                 }
               k++;
             }
           else
             {
-              if (this->realizations[j])
+              if (LS_REALIZATION_TEST(this->realizations,j))
                 break;
-              this = this->next;
+              this = LS_NEXT_CITY(solPtr,this);
             }
 #ifdef LS_EXTRA_STATS_OUTPUT
           solPtr->two_opt_scans_made++;
@@ -772,7 +1008,7 @@ LSA_2opt_delta_sample_estimate_window(LS_List *solPtr,
           k=0;
           if((window_length < window_size) && (k < no_nodes_inside_window))
             {
-              if (this->two_opt_biased_realizations[j])
+              if (LS_REALIZATION_TEST(this->two_opt_biased_realizations,j))
                 {
                   correction*=this->correction_two_opt[1];
                   break;
@@ -780,15 +1016,15 @@ LSA_2opt_delta_sample_estimate_window(LS_List *solPtr,
               else
                 {
                   correction*=this->correction_two_opt[0];
-                  this = this->prev;
+                  this = LS_PREV_CITY(solPtr,this);
                 }
               k++;
             }
           else
             {
-              if (this->realizations[j])
+              if (LS_REALIZATION_TEST(this->realizations,j))
                 break;
-              this = this->prev;
+              this = LS_PREV_CITY(solPtr,this);
             }
 #ifdef LS_EXTRA_STATS_OUTPUT
           solPtr->two_opt_scans_made++;
@@ -814,7 +1050,7 @@ LSA_2opt_delta_sample_estimate_window(LS_List *solPtr,
           k=0;
           if((window_length < window_size) && (k < no_nodes_inside_window))
             {
-              if (this->two_opt_biased_realizations[j])
+              if (LS_REALIZATION_TEST(this->two_opt_biased_realizations,j))
                 {
                   correction*=this->correction_two_opt[1];
                   break;
@@ -822,16 +1058,16 @@ LSA_2opt_delta_sample_estimate_window(LS_List *solPtr,
               else
                 {
                   correction*=this->correction_two_opt[0];
-                  this = this->next;
+                  this = LS_NEXT_CITY(solPtr,this);
                 }
               k++;
             }
           else
             {
               imp_flag=0;
-              if (this->realizations[j])
+              if (LS_REALIZATION_TEST(this->realizations,j))
                 break;
-              this = this->next;
+              this = LS_NEXT_CITY(solPtr,this);
             }
 #ifdef LS_EXTRA_STATS_OUTPUT
           solPtr->two_opt_scans_made++;
@@ -855,7 +1091,7 @@ LSA_2opt_delta_sample_estimate_window(LS_List *solPtr,
           k=0;
           if((window_length < window_size) && (k < no_nodes_inside_window))
             {
-              if (this->two_opt_biased_realizations[j])
+              if (LS_REALIZATION_TEST(this->two_opt_biased_realizations,j))
                 {
                   correction*=this->correction_two_opt[1];
                   break;
@@ -863,16 +1099,16 @@ LSA_2opt_delta_sample_estimate_window(LS_List *solPtr,
               else
                 {
                   correction*=this->correction_two_opt[0];
-                  this = this->prev;
+                  this = LS_PREV_CITY(solPtr,this);
                 }
 
               k++;
             }
           else
             {
-              if (this->realizations[j])
+              if (LS_REALIZATION_TEST(this->realizations,j))
                 break;
-              this = this->prev;
+              this = LS_PREV_CITY(solPtr,this);
             }
 
 #ifdef LS_EXTRA_STATS_OUTPUT
@@ -885,10 +1121,10 @@ LSA_2opt_delta_sample_estimate_window(LS_List *solPtr,
         return 0.0;
       cover1fst = this->city;
 
-      delta =-D[cover0fst][cover0snd]
-             -D[cover1fst][cover1snd]
-             +D[cover0fst][cover1fst]
-             +D[cover1snd][cover0snd];
+      delta =-LS_DIST(solPtr,cover0fst,cover0snd)
+             -LS_DIST(solPtr,cover1fst,cover1snd)
+             +LS_DIST(solPtr,cover0fst,cover1fst)
+             +LS_DIST(solPtr,cover1snd,cover0snd);
     }
 
 
@@ -908,7 +1144,6 @@ LSA_2hopt_delta_sample_estimate_window(LS_List *solPtr,
   long int sum_delta = 0;
   int j;
   struct LS_city *this=NULL;
-  const LS_DISTANCE **D = solPtr->distances;
 
   //	int window_size=solPtr->window_size;
   double correction=1.0;
@@ -918,7 +1153,7 @@ LSA_2hopt_delta_sample_estimate_window(LS_List *solPtr,
     {
       if(importance_sampling)
         {
-          if (!(solPtr->array[node].two_h_opt_biased_realizations[j]))
+          if (!(LS_REALIZATION_TEST(solPtr->array[node].two_h_opt_biased_realizations,j)))
             {
 
               return 0.0;
@@ -928,7 +1163,7 @@ LSA_2hopt_delta_sample_estimate_window(LS_List *solPtr,
         }
       else
         {
-          if (!solPtr->array[node].realizations[j])
+          if (!LS_REALIZATION_TEST(solPtr->array[node].realizations,j))
             {
               return 0.0;
             }
@@ -944,9 +1179,9 @@ LSA_2hopt_delta_sample_estimate_window(LS_List *solPtr,
       while (this->city != edge1snd)
         {
 
-          if (this->realizations[j])
+          if (LS_REALIZATION_TEST(this->realizations,j))
             break;
-          this = this->next;
+          this = LS_NEXT_CITY(solPtr,this);
 #ifdef LS_EXTRA_STATS_OUTPUT
 
           solPtr->two_opt_scans_made++;
@@ -964,9 +1199,9 @@ LSA_2hopt_delta_sample_estimate_window(LS_List *solPtr,
 
       while (this->city != edge1fst)
         {
-          if (this->realizations[j])
+          if (LS_REALIZATION_TEST(this->realizations,j))
             break;
-          this = this->prev;
+          this = LS_PREV_CITY(solPtr,this);
 #ifdef LS_EXTRA_STATS_OUTPUT
 
           solPtr->two_opt_scans_made++;
@@ -989,9 +1224,9 @@ LSA_2hopt_delta_sample_estimate_window(LS_List *solPtr,
 
       while (this->city != edge0snd)
         {
-          if (this->realizations[j])
+          if (LS_REALIZATION_TEST(this->realizations,j))
             break;
-          this = this->next;
+          this = LS_NEXT_CITY(solPtr,this);
 #ifdef LS_EXTRA_STATS_OUTPUT
 
           solPtr->two_opt_scans_made++;
@@ -1009,9 +1244,9 @@ LSA_2hopt_delta_sample_estimate_window(LS_List *solPtr,
       while (this->city != edge0fst)
         {
 
-          if (this->realizations[j])
+          if (LS_REALIZATION_TEST(this->realizations,j))
             break;
-          this = this->prev;
+          this = LS_PREV_CITY(solPtr,this);
 #ifdef LS_EXTRA_STATS_OUTPUT
 
           solPtr->two_opt_scans_made++;
@@ -1024,12 +1259,12 @@ LSA_2hopt_delta_sample_estimate_window(LS_List *solPtr,
       cover1fst = this->city;
 
 
-      sum_delta +=-D[cover0fst][cover0snd]
-                  -D[cover1fst][node]
-                  -D[node][cover1snd]
-                  +D[cover0fst][node]
-                  +D[node][cover0snd]
-                  +D[cover1fst][cover1snd];
+      sum_delta +=-LS_DIST(solPtr,cover0fst,cover0snd)
+                  -LS_DIST(solPtr,cover1fst,node)
+                  -LS_DIST(solPtr,node,cover1snd)
+                  +LS_DIST(solPtr,cover0fst,node)
+                  +LS_DIST(solPtr,node,cover0snd)
+                  +LS_DIST(solPtr,cover1fst,cover1snd);
     }
 
 
@@ -1048,3 +1283,546 @@ LSA_2hopt_delta_sample_estimate_window(LS_List *solPtr,
 
 
 
+
+
+
+/* First city present in realization j on the path from start to
+   stop, stop excluded, following next if forward; -1 if there is none */
+static inline int
+LSA_realization_search(LS_List *solPtr, int start, int stop, int forward, int j)
+{
+  struct LS_city *this = &solPtr->array[start];
+
+  while (this->city != stop)
+    {
+      if (LS_REALIZATION_TEST(this->realizations,j))
+        return this->city;
+      this = forward ? LS_NEXT_CITY(solPtr,this) : LS_PREV_CITY(solPtr,this);
+#ifdef LS_EXTRA_STATS_OUTPUT
+      solPtr->two_opt_scans_made++;
+#endif
+    }
+  return -1;
+}
+
+/* The Or-opt move moves the segment from node to the city before
+   edge1snd between edge0fst and edge0snd. In a realization, only the
+   cities present in the segment are moved, from between the present
+   cities around it to between those around the insertion point. The
+   paths from edge0snd to edge1fst and from edge1snd to edge0fst are
+   searched for them; if one of the two has no city present, the
+   segment is moved along the same edge of the realization. */
+double
+LSA_oropt_delta_sample_estimate(LS_List *solPtr,
+                                int edge0fst, int edge0snd, int node,
+                                int edge1fst, int edge1snd, int reversed,
+                                int j)
+{
+  int first = -1, last = -1, segment_last = node;
+  int inserted_first, inserted_last;
+  int cover0fst, cover0snd, cover1fst, cover1snd;
+  long int delta;
+  struct LS_city *this;
+
+  /* The present cities of the segment */
+  for (this = &solPtr->array[node]; this->city != edge1snd;
+       this = LS_NEXT_CITY(solPtr,this))
+    {
+      if (LS_REALIZATION_TEST(this->realizations,j))
+        {
+          if (first < 0)
+            first = this->city;
+          last = this->city;
+        }
+      segment_last = this->city;
+    }
+  if (first < 0)
+    return 0.0;
+
+  /* Around the insertion point and around the segment */
+  cover0snd = LSA_realization_search(solPtr,edge0snd,node,TRUE,j);
+  cover1fst = cover0snd < 0 ? -1 : LSA_realization_search(solPtr,edge1fst,edge0fst,FALSE,j);
+  cover0fst = LSA_realization_search(solPtr,edge0fst,segment_last,FALSE,j);
+  cover1snd = cover0fst < 0 ? -1 : LSA_realization_search(solPtr,edge1snd,edge0snd,TRUE,j);
+  if (cover0snd < 0 && cover0fst < 0)
+    return 0.0;
+  if (cover0snd < 0)
+    {
+      cover0snd = cover1snd;
+      cover1fst = cover0fst;
+    }
+  else if (cover0fst < 0)
+    {
+      cover0fst = cover1fst;
+      cover1snd = cover0snd;
+    }
+
+  /* The ends of the segment next to cover0fst and to cover0snd */
+  if (reversed)
+    {
+      inserted_first = last;
+      inserted_last = first;
+    }
+  else
+    {
+      inserted_first = first;
+      inserted_last = last;
+    }
+  delta = -LS_DIST(solPtr,cover0fst,cover0snd)
+          -LS_DIST(solPtr,cover1fst,first)
+          -LS_DIST(solPtr,last,cover1snd)
+          +LS_DIST(solPtr,cover0fst,inserted_first)
+          +LS_DIST(solPtr,inserted_last,cover0snd)
+          +LS_DIST(solPtr,cover1fst,cover1snd);
+  return (double)delta;
+}
+
+
+/* Lanes of a block of realizations that are actually generated */
+static inline LS_REALIZATION_WORD
+LSA_block_lanes(LS_List *solPtr, int block)
+{
+  int remaining=solPtr->maximum_realizations-block*LS_REALIZATION_WORD_BITS;
+
+  if (remaining>=LS_REALIZATION_WORD_BITS)
+    return ~((LS_REALIZATION_WORD)0);
+  return (((LS_REALIZATION_WORD)1)<<remaining)-1;
+}
+
+/* The k lowest lanes of a mask */
+static inline LS_REALIZATION_WORD
+LSA_block_lowest_lanes(LS_REALIZATION_WORD lanes, int k)
+{
+  LS_REALIZATION_WORD lowest=0, lane;
+
+  while (lanes && k--)
+    {
+      lane = lanes & -lanes;
+      lowest |= lane;
+      lanes &= ~lane;
+    }
+  return lowest;
+}
+
+/* Biased realizations are used on a side of a 2-exchange move if the
+   side is shorter than the window (see the _window estimators) */
+static inline int
+LSA_block_biased(LS_List *solPtr, int node1, int node2)
+{
+  int no_nodes_inside_window;
+
+  if (!solPtr->importance_sampling_flag)
+    return FALSE;
+  no_nodes_inside_window=(int)((solPtr->window_size*solPtr->no_nodes_inside_window_percentage/100.0)+0.5);
+  return (LSA_segment_length(solPtr,node1,node2) < solPtr->window_size)
+         && (no_nodes_inside_window > 0);
+}
+
+/* Walk the tour from `start' towards `stop' and record, for each lane
+   in `searching', the first city that is present in that realization.
+   Lanes for which no city is found before `stop' are dropped from the
+   returned mask.  With biased realizations, the correction of each lane
+   is the product of the corrections of the cities skipped and found. */
+static inline LS_REALIZATION_WORD
+LSA_block_search(LS_List *solPtr, int start, int stop, int forward,
+                 int block, LS_REALIZATION_WORD searching, int biased,
+                 int *cover, double *correction)
+{
+  struct LS_city *this = &solPtr->array[start];
+  LS_REALIZATION_WORD alive = searching;
+  LS_REALIZATION_WORD present, found;
+  double skipped=1.0;
+  int lane;
+
+  while (searching && this->city != stop)
+    {
+      if (biased)
+        present = this->two_opt_biased_realizations[block];
+      else
+        present = this->realizations[block];
+
+      found = searching & present;
+      searching &= ~present;
+
+      while (found)
+        {
+          lane = __builtin_ctzll(found);
+          found &= found-1;
+          cover[lane] = this->city;
+          if (biased)
+            correction[lane] *= skipped*this->correction_two_opt[1];
+        }
+
+      if (biased)
+        skipped *= this->correction_two_opt[0];
+
+      this = forward ? LS_NEXT_CITY(solPtr,this) : LS_PREV_CITY(solPtr,this);
+#ifdef LS_EXTRA_STATS_OUTPUT
+      solPtr->two_opt_scans_made++;
+#endif
+    }
+
+  return alive & ~searching;
+}
+
+
+int
+LSA_2opt_delta_block_estimate(LS_List *solPtr,
+                              int edge0fst, int edge0snd,
+                              int edge1fst, int edge1snd,
+                              int block, LS_REALIZATION_WORD lanes,
+                              double *delta)
+{
+  int cover0fst[LS_REALIZATION_WORD_BITS], cover0snd[LS_REALIZATION_WORD_BITS];
+  int cover1fst[LS_REALIZATION_WORD_BITS], cover1snd[LS_REALIZATION_WORD_BITS];
+  double correction[LS_REALIZATION_WORD_BITS];
+  LS_REALIZATION_WORD alive = lanes;
+  long int lane_delta;
+  int lane;
+
+  for (lane=0; lane<LS_REALIZATION_WORD_BITS; lane++)
+    {
+      correction[lane]=1.0;
+      delta[lane]=0.0;
+    }
+
+  /* Search to the right of insertion point 0 */
+  alive = LSA_block_search(solPtr,edge0snd,edge1snd,TRUE,block,alive,
+                           LSA_block_biased(solPtr,edge0snd,edge1snd),
+                           cover0snd,correction);
+  /* Search to the left of insertion point 0 */
+  alive = LSA_block_search(solPtr,edge0fst,edge1fst,FALSE,block,alive,
+                           LSA_block_biased(solPtr,edge1fst,edge0fst),
+                           cover0fst,correction);
+  /* Search to the right of insertion point 1 */
+  alive = LSA_block_search(solPtr,edge1snd,edge0snd,TRUE,block,alive,
+                           LSA_block_biased(solPtr,edge1snd,edge0snd),
+                           cover1snd,correction);
+  /* Search to the left of insertion point 1 */
+  alive = LSA_block_search(solPtr,edge1fst,edge0fst,FALSE,block,alive,
+                           LSA_block_biased(solPtr,edge0fst,edge1fst),
+                           cover1fst,correction);
+
+  while (alive)
+    {
+      lane = __builtin_ctzll(alive);
+      alive &= alive-1;
+      lane_delta = -LS_DIST(solPtr,cover0fst[lane],cover0snd[lane])
+                   -LS_DIST(solPtr,cover1fst[lane],cover1snd[lane])
+                   +LS_DIST(solPtr,cover0fst[lane],cover1fst[lane])
+                   +LS_DIST(solPtr,cover1snd[lane],cover0snd[lane]);
+      delta[lane] = correction[lane]*(double)lane_delta;
+    }
+
+  return __builtin_popcountll(lanes);
+}
+
+
+int
+LSA_2hopt_delta_block_estimate(LS_List *solPtr,
+                               int edge0fst, int edge0snd, int node,
+                               int edge1fst, int edge1snd,
+                               int block, LS_REALIZATION_WORD lanes,
+                               double *delta)
+{
+  int cover0fst[LS_REALIZATION_WORD_BITS], cover0snd[LS_REALIZATION_WORD_BITS];
+  int cover1fst[LS_REALIZATION_WORD_BITS], cover1snd[LS_REALIZATION_WORD_BITS];
+  double correction[LS_REALIZATION_WORD_BITS];
+  LS_REALIZATION_WORD alive;
+  double node_correction=1.0;
+  long int lane_delta;
+  int lane;
+
+  for (lane=0; lane<LS_REALIZATION_WORD_BITS; lane++)
+    {
+      correction[lane]=1.0;
+      delta[lane]=0.0;
+    }
+
+  /* Only the realizations in which the inserted node is present
+     contribute to the delta */
+  if (solPtr->importance_sampling_flag)
+    {
+      alive = lanes & solPtr->array[node].two_h_opt_biased_realizations[block];
+      node_correction = solPtr->array[node].correction_two_h_opt;
+    }
+  else
+    alive = lanes & solPtr->array[node].realizations[block];
+
+  alive = LSA_block_search(solPtr,edge0snd,edge1snd,TRUE,block,alive,FALSE,
+                           cover0snd,correction);
+  alive = LSA_block_search(solPtr,edge0fst,edge1fst,FALSE,block,alive,FALSE,
+                           cover0fst,correction);
+  alive = LSA_block_search(solPtr,edge1snd,edge0snd,TRUE,block,alive,FALSE,
+                           cover1snd,correction);
+  alive = LSA_block_search(solPtr,edge1fst,edge0fst,FALSE,block,alive,FALSE,
+                           cover1fst,correction);
+
+  while (alive)
+    {
+      lane = __builtin_ctzll(alive);
+      alive &= alive-1;
+      lane_delta = -LS_DIST(solPtr,cover0fst[lane],cover0snd[lane])
+                   -LS_DIST(solPtr,cover1fst[lane],node)
+                   -LS_DIST(solPtr,node,cover1snd[lane])
+                   +LS_DIST(solPtr,cover0fst[lane],node)
+                   +LS_DIST(solPtr,node,cover0snd[lane])
+                   +LS_DIST(solPtr,cover1fst[lane],cover1snd[lane]);
+      delta[lane] = node_correction*(double)lane_delta;
+    }
+
+  return __builtin_popcountll(lanes);
+}
+
+
+int
+LSA_oropt_delta_block_estimate(LS_List *solPtr,
+                               int edge0fst, int edge0snd, int node,
+                               int edge1fst, int edge1snd, int reversed,
+                               int block, LS_REALIZATION_WORD lanes,
+                               double *delta)
+{
+  int cover0fst[LS_REALIZATION_WORD_BITS], cover0snd[LS_REALIZATION_WORD_BITS];
+  int cover1fst[LS_REALIZATION_WORD_BITS], cover1snd[LS_REALIZATION_WORD_BITS];
+  int first[LS_REALIZATION_WORD_BITS], last[LS_REALIZATION_WORD_BITS];
+  double correction[LS_REALIZATION_WORD_BITS];
+  LS_REALIZATION_WORD alive = 0, present, inner, outer, pending;
+  long int lane_delta;
+  int lane, segment_last = node;
+  struct LS_city *this;
+
+  for (lane=0; lane<LS_REALIZATION_WORD_BITS; lane++)
+    {
+      correction[lane]=1.0;
+      delta[lane]=0.0;
+    }
+
+  /* The present cities of the segment, see LSA_oropt_delta_sample_estimate */
+  for (this = &solPtr->array[node]; this->city != edge1snd;
+       this = LS_NEXT_CITY(solPtr,this))
+    {
+      present = lanes & this->realizations[block];
+      for (pending = present & ~alive; pending; pending &= pending-1)
+        first[__builtin_ctzll(pending)] = this->city;
+      for (pending = present; pending; pending &= pending-1)
+        last[__builtin_ctzll(pending)] = this->city;
+      alive |= present;
+      segment_last = this->city;
+    }
+
+  inner = LSA_block_search(solPtr,edge0snd,node,TRUE,block,alive,FALSE,
+                           cover0snd,correction);
+  LSA_block_search(solPtr,edge1fst,edge0fst,FALSE,block,inner,FALSE,
+                   cover1fst,correction);
+  outer = LSA_block_search(solPtr,edge0fst,segment_last,FALSE,block,alive,FALSE,
+                           cover0fst,correction);
+  LSA_block_search(solPtr,edge1snd,edge0snd,TRUE,block,outer,FALSE,
+                   cover1snd,correction);
+
+  for (alive = inner | outer; alive; alive &= alive-1)
+    {
+      lane = __builtin_ctzll(alive);
+      if (!((inner>>lane)&1))
+        {
+          cover0snd[lane] = cover1snd[lane];
+          cover1fst[lane] = cover0fst[lane];
+        }
+      else if (!((outer>>lane)&1))
+        {
+          cover0fst[lane] = cover1fst[lane];
+          cover1snd[lane] = cover0snd[lane];
+        }
+      lane_delta = -LS_DIST(solPtr,cover0fst[lane],cover0snd[lane])
+                   -LS_DIST(solPtr,cover1fst[lane],first[lane])
+                   -LS_DIST(solPtr,last[lane],cover1snd[lane])
+                   +LS_DIST(solPtr,cover0fst[lane],reversed ? last[lane] : first[lane])
+                   +LS_DIST(solPtr,reversed ? first[lane] : last[lane],cover0snd[lane])
+                   +LS_DIST(solPtr,cover1fst[lane],cover1snd[lane]);
+      delta[lane] = (double)lane_delta;
+    }
+
+  return __builtin_popcountll(lanes);
+}
+
+
+double
+LSA_delta_adaptive_sample_block(LS_List *solPtr,
+                                int edge0fst, int edge0snd, int node,
+                                int edge1fst, int edge1snd,
+                                gsl_rng *r, int opt)
+{
+  double delta[LS_REALIZATION_WORD_BITS];
+  long int sum_delta=0;
+  double sum_delta_sqr=0.0;
+  double mean_delta=0.0;
+  int alpha_index=LSA_alpha_index(solPtr->alpha);
+  int no_samples=0;
+  int significant=FALSE;
+  int index_block, block, lane;
+  LS_REALIZATION_WORD pending, lanes;
+
+  if (alpha_index<0)
+    error(EXIT_FAILURE,0,"Illegal alpha %g for the t-test",solPtr->alpha);
+  solPtr->move_status=FALSE;
+
+  for (index_block=0; !significant && index_block<solPtr->realization_words; index_block++)
+    {
+      block=solPtr->block_order[index_block];
+      pending=LSA_block_lanes(solPtr,block);
+
+      while (!significant && pending)
+        {
+          /* The first test is done, as in LSA_delta_adaptive_sample,
+             after minimum_realizations+1 samples; the following ones
+             at the end of each block */
+          if (no_samples <= solPtr->minimum_realizations)
+            lanes=LSA_block_lowest_lanes(pending,solPtr->minimum_realizations+1-no_samples);
+          else
+            lanes=pending;
+          pending &= ~lanes;
+
+          if (opt==0)
+            LSA_2opt_delta_block_estimate(solPtr,edge0fst,edge0snd,
+                                          edge1fst,edge1snd,block,lanes,delta);
+          else if (opt==1)
+            LSA_2hopt_delta_block_estimate(solPtr,edge0fst,edge0snd,node,
+                                           edge1fst,edge1snd,block,lanes,delta);
+          else
+            LSA_oropt_delta_block_estimate(solPtr,edge0fst,edge0snd,node,
+                                           edge1fst,edge1snd,opt==LSA_OR_OPT_REVERSED,
+                                           block,lanes,delta);
+
+          while (lanes)
+            {
+              lane = __builtin_ctzll(lanes);
+              lanes &= lanes-1;
+              sum_delta += delta[lane];
+              sum_delta_sqr += pow(delta[lane],2);
+              no_samples++;
+            }
+
+          if (no_samples > solPtr->minimum_realizations)
+            significant=LSA_t_test(sum_delta,sum_delta_sqr,no_samples,
+                                   alpha_index,&mean_delta);
+        }
+    }
+
+  if (mean_delta < 0.0 )
+    solPtr->move_status=TRUE;
+
+#ifdef LS_EXTRA_STATS_OUTPUT
+  solPtr->samples_used += no_samples;
+  solPtr->solutions_explored++;
+#endif
+
+  return (((double)sum_delta)/(double)no_samples);
+}
+
+
+/* Lanes of the index_block-th block of realizations, in the order of
+   block_order, that are among the first no_realizations */
+static inline LS_REALIZATION_WORD
+LSA_chain_lanes(const LS_List *solPtr, int index_block, int no_realizations)
+{
+  int remaining=no_realizations-solPtr->block_order[index_block]*LS_REALIZATION_WORD_BITS;
+
+  if (remaining<=0)
+    return 0;
+  if (remaining>=LS_REALIZATION_WORD_BITS)
+    return ~((LS_REALIZATION_WORD)0);
+  return (((LS_REALIZATION_WORD)1)<<remaining)-1;
+}
+
+
+void
+LSA_2opt_chain_delta(LS_List *solPtr,
+                     int edge0fst, int edge0snd,
+                     int edge1fst, int edge1snd, int no_realizations,
+                     int from_block, int to_block, double *delta)
+{
+  int cover0fst[LS_REALIZATION_WORD_BITS], cover0snd[LS_REALIZATION_WORD_BITS];
+  int cover1fst[LS_REALIZATION_WORD_BITS], cover1snd[LS_REALIZATION_WORD_BITS];
+  double correction[LS_REALIZATION_WORD_BITS];
+  LS_REALIZATION_WORD alive;
+  long int lane_delta;
+  int index_block, block, lane;
+
+  for (index_block=from_block; index_block<to_block; index_block++)
+    {
+      block=solPtr->block_order[index_block];
+      alive=LSA_chain_lanes(solPtr,index_block,no_realizations);
+#ifdef LS_EXTRA_STATS_OUTPUT
+      solPtr->samples_used += __builtin_popcountll(alive);
+#endif
+
+      alive = LSA_block_search(solPtr,edge0snd,edge1snd,TRUE,block,alive,FALSE,
+                               cover0snd,correction);
+      alive = LSA_block_search(solPtr,edge0fst,edge1fst,FALSE,block,alive,FALSE,
+                               cover0fst,correction);
+      alive = LSA_block_search(solPtr,edge1snd,edge0snd,TRUE,block,alive,FALSE,
+                               cover1snd,correction);
+      alive = LSA_block_search(solPtr,edge1fst,edge0fst,FALSE,block,alive,FALSE,
+                               cover1fst,correction);
+
+      while (alive)
+        {
+          lane = __builtin_ctzll(alive);
+          alive &= alive-1;
+          lane_delta = -LS_DIST(solPtr,cover0fst[lane],cover0snd[lane])
+                       -LS_DIST(solPtr,cover1fst[lane],cover1snd[lane])
+                       +LS_DIST(solPtr,cover0fst[lane],cover1fst[lane])
+                       +LS_DIST(solPtr,cover1snd[lane],cover0snd[lane]);
+          delta[index_block*LS_REALIZATION_WORD_BITS+lane] += (double)lane_delta;
+        }
+    }
+
+#ifdef LS_EXTRA_STATS_OUTPUT
+  solPtr->solutions_explored++;
+#endif
+}
+
+
+int
+LSA_chain_test(const LS_List *solPtr, const double *delta,
+               int no_realizations, int no_blocks, int adaptive,
+               double *mean)
+{
+  double sum_delta=0.0;
+  double sum_delta_sqr=0.0;
+  double mean_delta=0.0;
+  int alpha_index=LSA_alpha_index(solPtr->alpha);
+  int no_samples=0;
+  int index_block, lane;
+  LS_REALIZATION_WORD lanes;
+
+  if (adaptive && alpha_index<0)
+    error(EXIT_FAILURE,0,"Illegal alpha %g for the t-test",solPtr->alpha);
+
+  for (index_block=0; index_block<no_blocks; index_block++)
+    {
+      lanes=LSA_chain_lanes(solPtr,index_block,no_realizations);
+      while (lanes)
+        {
+          lane = __builtin_ctzll(lanes);
+          lanes &= lanes-1;
+          sum_delta += delta[index_block*LS_REALIZATION_WORD_BITS+lane];
+          sum_delta_sqr += pow(delta[index_block*LS_REALIZATION_WORD_BITS+lane],2);
+          no_samples++;
+
+          if (adaptive && no_samples > solPtr->minimum_realizations &&
+              LSA_t_test(sum_delta,sum_delta_sqr,no_samples,alpha_index,&mean_delta))
+            {
+              *mean=mean_delta;
+              return mean_delta < 0.0;
+            }
+        }
+    }
+
+  if (no_samples)
+    mean_delta=sum_delta/(double)no_samples;
+  *mean=mean_delta;
+  if (adaptive &&
+      no_blocks < LS_REALIZATION_NO_WORDS(no_realizations))
+    return -1;
+  return mean_delta < 0.0;
+}
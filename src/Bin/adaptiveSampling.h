@@ -42,10 +42,21 @@
 
 *****************************************************************************************/
 
-double
-(*delta_evaluation)(LS_List *solPtr,
-                    int edge0fst, int edge0snd, int node,
-                    int edge1fst, int edge1snd, gsl_rng *r, int opt);  /* function pointer */
+/* Functions evaluating the delta of a move, one for each type of
+   sampling: LS_delta, LSA_delta_adaptive_sample and
+   LSA_delta_adaptive_sample_block, and LSX_delta for the approximation.
+   The move is given by opt: 0 for the 2-exchange of the edges
+   (edge0fst,edge0snd) and (edge1fst,edge1snd), 1 for the insertion of
+   node, which is between edge1fst and edge1snd, between edge0fst and
+   edge0snd, and LSA_OR_OPT or LSA_OR_OPT_REVERSED for the insertion
+   there of the segment of the tour from node to the city before
+   edge1snd, as it is or reversed. */
+#define LSA_OR_OPT 2
+#define LSA_OR_OPT_REVERSED 3
+typedef double
+(*LSA_delta_function)(LS_List *solPtr,
+                      int edge0fst, int edge0snd, int node,
+                      int edge1fst, int edge1snd, gsl_rng *r, int opt);
 
 double
 LSA_2opt_delta_sample_estimate(LS_List *solPtr,
@@ -55,10 +66,27 @@ double
 LSA_2hopt_delta_sample_estimate(LS_List *solPtr, int edge0fst, int edge0snd, int node,
                                 int edge1fst, int edge1snd, int realization_index,int importance_sampling);
 
+/* Estimate of an Or-opt move on a realization, see LSA_delta_function.
+   There is no importance sampling: weighting the realizations by the
+   likelihood ratios of the cities of the segment, even of its two ends
+   only, lets the t-test accept moves that worsen the expected cost, the
+   realizations with large weights being seldom drawn. */
+double
+LSA_oropt_delta_sample_estimate(LS_List *solPtr,
+                                int edge0fst, int edge0snd, int node,
+                                int edge1fst, int edge1snd, int reversed,
+                                int index_realization);
+
 void
 LSA_solution_add_realization(LS_List solution,
                              int realization_number, gsl_rng *r);
 
+/* Column of the table of the t distribution for the significance
+   level alpha, one of 0.10, 0.05, 0.02 and 0.01; -1 for any other
+   value */
+int
+LSA_alpha_index(double alpha);
+
 double
 LS_delta(LS_List *solPtr,
          int edge0fst, int edge0snd, int node,
@@ -70,6 +98,20 @@ LSA_delta_adaptive_sample(LS_List *solPtr,
                           int edge0fst, int edge0snd, int node,
                           int edge1fst, int edge1snd, gsl_rng *r, int opt);
 
+/* Let LSA_delta_adaptive_sample compute the deltas of a move on the
+   solution in chunks of `chunk' realizations, each spread over
+   no_threads threads, the calling one included. The t-test is still
+   made after each realization, in the same order, so the result is
+   the same as on one thread; the deltas of a chunk after the one where
+   the test stops are computed in vain. */
+void
+LSA_solution_set_realization_threads(LS_List *solPtr, int no_threads, int chunk);
+
+/* Stop the threads of LSA_solution_set_realization_threads; called
+   by LS_solution_free */
+void
+LSA_realization_pool_free(struct LSA_realization_pool *pool);
+
 double
 LSA_2opt_delta_sample_estimate_window(LS_List *solPtr,
                                       int edge0fst, int edge0snd,
@@ -77,3 +119,59 @@ LSA_2opt_delta_sample_estimate_window(LS_List *solPtr,
 double
 LSA_2hopt_delta_sample_estimate_window(LS_List *solPtr, int edge0fst, int edge0snd, int node,
                                        int edge1fst, int edge1snd, int realization_index,int importance_sampling);
+
+/* Estimates of a move on the realizations `lanes' of the block of 64
+   realizations stored in the word `block' of the realization bitsets,
+   computed in a single walk of the tour.  The delta of realization
+   64*block+i is written in delta[i]; the number of lanes is returned. */
+int
+LSA_2opt_delta_block_estimate(LS_List *solPtr,
+                              int edge0fst, int edge0snd,
+                              int edge1fst, int edge1snd,
+                              int block, LS_REALIZATION_WORD lanes,
+                              double *delta);
+int
+LSA_2hopt_delta_block_estimate(LS_List *solPtr,
+                               int edge0fst, int edge0snd, int node,
+                               int edge1fst, int edge1snd,
+                               int block, LS_REALIZATION_WORD lanes,
+                               double *delta);
+
+int
+LSA_oropt_delta_block_estimate(LS_List *solPtr,
+                               int edge0fst, int edge0snd, int node,
+                               int edge1fst, int edge1snd, int reversed,
+                               int block, LS_REALIZATION_WORD lanes,
+                               double *delta);
+
+double
+LSA_delta_adaptive_sample_block(LS_List *solPtr,
+                                int edge0fst, int edge0snd, int node,
+                                int edge1fst, int edge1snd, gsl_rng *r, int opt);
+
+/* A chain of 2-exchange moves made one after the other, as in the
+   variable-depth search of LS_lk_search, is estimated on the first
+   no_realizations realizations, block by block in the order of
+   block_order: the deltas of its moves on a lane of a block are added
+   up in delta[index_block*LS_REALIZATION_WORD_BITS+lane]. The moves
+   are not biased by importance sampling, each one of the chain being
+   biased differently. */
+
+/* Add the deltas of the 2-exchange of (edge0fst,edge0snd) and
+   (edge1fst,edge1snd) on the blocks from from_block to to_block-1 */
+void
+LSA_2opt_chain_delta(LS_List *solPtr,
+                     int edge0fst, int edge0snd,
+                     int edge1fst, int edge1snd, int no_realizations,
+                     int from_block, int to_block, double *delta);
+
+/* Whether a chain whose deltas are known on the first no_blocks
+   blocks improves the solution, setting *mean to its mean delta. If
+   adaptive, the deltas are taken one by one until their mean is
+   significant for the t-test of LSA_delta_adaptive_sample, and -1 is
+   returned if there are not enough of them yet; otherwise it improves
+   if its mean on all the realizations is negative. */
+int
+LSA_chain_test(const LS_List *solPtr, const double *delta,
+               int no_realizations, int no_blocks, int adaptive,
+               double *mean);
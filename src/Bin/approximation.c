@@ -0,0 +1,237 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    approximation.c
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Analytic delta of the moves, truncated to a depth
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#include <stdlib.h>
+#include <error.h>
+#include <math.h>
+#include <gsl/gsl_math.h>
+
+#include "approximation.h"
+#include "adaptiveSampling.h"
+
+/* A part of a tour that is a path of the current tour, from first to
+   last following next if forward, prev otherwise */
+struct LSX_run
+  {
+    int first, last;
+    int forward;
+    int length;
+  };
+
+#define LSX_STEP(solPtr,c,forward) \
+  ((forward) ? LS_NEXT((solPtr),(c)) : LS_PREV((solPtr),(c)))
+
+/* Sum of the terms of the pairs whose path along the tour made of the
+   runs crosses first the edge from run k to run k+1: the first city
+   of the pair is in run k, the path may cross other edges afterwards */
+static double
+LSX_edge_terms(const LS_List *solPtr, const struct LSX_run *run, int no_runs,
+               int k, int depth)
+{
+  int right[LSX_MAX_DEPTH];
+  double right_absent[LSX_MAX_DEPTH];  /* of the cities of right before j */
+  int no_right, i, j, m, l, c, left;
+  double absent, left_absent, sum = 0.0;
+
+  /* The second cities of the pairs, past the edge */
+  no_right = 0;
+  absent = 1.0;
+  for (m = (k+1)%no_runs; no_right < depth; m = (m+1)%no_runs)
+    for (l = 0, c = run[m].first; l < run[m].length && no_right < depth; l++)
+      {
+        if (!solPtr->depth && absent < LSX_EPSILON)
+          goto right_done;
+        right[no_right] = c;
+        right_absent[no_right++] = absent;
+        absent *= 1.0 - solPtr->array[c].probability;
+        c = LSX_STEP(solPtr,c,run[m].forward);
+      }
+right_done:
+
+  /* The first cities, back from the edge */
+  left_absent = 1.0;
+  for (i = 0, left = run[k].last; i < run[k].length && i < depth; i++)
+    {
+      if (!solPtr->depth && left_absent < LSX_EPSILON)
+        break;
+      for (j = 0; j < no_right && i+j < depth; j++)
+        {
+          if (!solPtr->depth && left_absent*right_absent[j] < LSX_EPSILON)
+            break;
+          sum += LS_DIST(solPtr,left,right[j])
+                 * solPtr->array[left].probability * solPtr->array[right[j]].probability
+                 * left_absent * right_absent[j];
+        }
+      left_absent *= 1.0 - solPtr->array[left].probability;
+      left = LSX_STEP(solPtr,left,!run[k].forward);
+    }
+  return sum;
+}
+
+/* As LSX_edge_terms, with the same probability p for all the cities:
+   the product over the cities in between is a power of 1-p */
+static double
+LSX_homogeneous_edge_terms(const LS_List *solPtr, const struct LSX_run *run,
+                           int no_runs, int k, int depth)
+{
+  int right[LSX_MAX_DEPTH];
+  const double *absent = solPtr->absent_power;
+  int no_right, i, j, m, l, c, left;
+  double p = solPtr->array[0].probability, sum = 0.0;
+
+  no_right = 0;
+  for (m = (k+1)%no_runs; no_right < depth; m = (m+1)%no_runs)
+    for (l = 0, c = run[m].first; l < run[m].length && no_right < depth; l++)
+      {
+        right[no_right++] = c;
+        c = LSX_STEP(solPtr,c,run[m].forward);
+      }
+
+  for (i = 0, left = run[k].last; i < run[k].length && i < depth; i++)
+    {
+      for (j = 0; j < no_right && i+j < depth; j++)
+        sum += LS_DIST(solPtr,left,right[j]) * absent[i+j];
+      left = LSX_STEP(solPtr,left,!run[k].forward);
+    }
+  return p * p * sum;
+}
+
+/* Sum of the terms of the pairs whose path crosses any of the edges
+   between the runs, each pair being counted at the first one */
+static double
+LSX_tour_terms(const LS_List *solPtr, const struct LSX_run *run, int no_runs,
+               int depth)
+{
+  int k;
+  double sum = 0.0;
+
+  for (k = 0; k < no_runs; k++)
+    sum += solPtr->absent_power
+           ? LSX_homogeneous_edge_terms(solPtr,run,no_runs,k,depth)
+           : LSX_edge_terms(solPtr,run,no_runs,k,depth);
+  return sum;
+}
+
+
+double
+LSX_delta(LS_List *solPtr,
+          int edge0fst, int edge0snd, int node,
+          int edge1fst, int edge1snd, gsl_rng *r, int opt)
+{
+  struct LSX_run before[3], after[3];
+  int n = solPtr->no_cities, no_runs, inner, outer, last, length;
+  int depth = solPtr->depth ? GSL_MIN(solPtr->depth,n-1) : n-1;
+  double delta;
+
+  depth = GSL_MIN(depth,LSX_MAX_DEPTH);
+  /* The terms truncated at LSX_EPSILON are those of the pairs more than
+     log(LSX_EPSILON)/log(1-p) steps apart */
+  if (solPtr->absent_power && !solPtr->depth &&
+      solPtr->array[0].probability > 0.0)
+    depth = GSL_MIN(depth,floor(log(LSX_EPSILON)/
+                                log(1.0 - solPtr->array[0].probability)) + 1);
+  /* The cities from edge0snd to edge1fst along the tour */
+  inner = (LS_POSITION(solPtr,edge1fst) - LS_POSITION(solPtr,edge0snd) + n)%n + 1;
+
+  if (opt==0)
+    {
+      /* edge0fst edge0snd ... edge1fst edge1snd ... becomes
+         edge0fst edge1fst ... edge0snd edge1snd ... */
+      outer = n - inner;
+      no_runs = 2;
+      before[0] = (struct LSX_run) {edge0snd, edge1fst, 1, inner};
+      before[1] = (struct LSX_run) {edge1snd, edge0fst, 1, outer};
+      after[0] = (struct LSX_run) {edge1fst, edge0snd, 0, inner};
+      after[1] = before[1];
+    }
+  else
+    {
+      /* edge0fst edge0snd ... edge1fst node ... last edge1snd ... becomes
+         edge0fst node ... last edge0snd ... edge1fst edge1snd ..., with
+         the segment from node to last reversed for LSA_OR_OPT_REVERSED */
+      last = LS_PREV(solPtr,edge1snd);
+      length = (LS_POSITION(solPtr,last) - LS_POSITION(solPtr,node) + n)%n + 1;
+      outer = n - inner - length;
+      no_runs = 3;
+      before[0] = (struct LSX_run) {edge0snd, edge1fst, 1, inner};
+      before[1] = (struct LSX_run) {node, last, 1, length};
+      before[2] = (struct LSX_run) {edge1snd, edge0fst, 1, outer};
+      if (opt==LSA_OR_OPT_REVERSED)
+        after[0] = (struct LSX_run) {last, node, 0, length};
+      else
+        after[0] = before[1];
+      after[1] = before[0];
+      after[2] = before[2];
+    }
+
+  delta = LSX_tour_terms(solPtr,after,no_runs,depth)
+          - LSX_tour_terms(solPtr,before,no_runs,depth);
+  solPtr->move_status = (delta < -LSX_MIN_IMPROVEMENT);
+
+#ifdef LS_EXTRA_STATS_OUTPUT
+  solPtr->solutions_explored++;
+#endif
+  return delta;
+}
+
+
+int
+LSX_solution_set_homogeneous(LS_List *solPtr)
+{
+  int i;
+  double p = solPtr->array[0].probability;
+
+  for (i = 1; i < solPtr->no_cities; i++)
+    if (solPtr->array[i].probability != p)
+      return 0;
+
+  free(solPtr->absent_power);
+  solPtr->absent_power = malloc(LSX_MAX_DEPTH*sizeof(double));
+  if (!solPtr->absent_power)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  solPtr->absent_power[0] = 1.0;
+  for (i = 1; i < LSX_MAX_DEPTH; i++)
+    solPtr->absent_power[i] = solPtr->absent_power[i-1] * (1.0 - p);
+  return 1;
+}
@@ -0,0 +1,87 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    approximation.h
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Analytic delta of the moves, truncated to a depth
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#ifndef LSX_APPROXIMATION
+#define LSX_APPROXIMATION
+
+#include <gsl/gsl_rng.h>
+#include "sampleLS.h"
+
+/* Type of sampling given to the local search for evaluating the moves
+   through LSX_delta instead of realizations */
+#define LSX_SAMPLING_TYPE 3
+
+/* Below this the delta of a move is taken as rounding error */
+#define LSX_MIN_IMPROVEMENT 1e-9
+
+/* Largest depth of the approximation */
+#define LSX_MAX_DEPTH 1000
+
+/* With depth 0, the terms of the cost are truncated where the
+   probability that the cities in between are all absent falls below
+   this value */
+#define LSX_EPSILON 1e-6
+
+/* Delta of a move in the expected cost of the tour, computed from the
+   closed-form cost of the PTSP: the sum over the pairs of cities i, j
+   at most depth steps apart along the tour of the distance between
+   them times p_i p_j and the product of (1-p_k) over the cities k in
+   between. Only the pairs whose path crosses an edge changed by the
+   move are summed up. With solPtr->depth at least no_cities-1 the delta
+   is exact; with depth 0 it stops at LSX_EPSILON, and at LSX_MAX_DEPTH.
+   The arguments are those of LSA_delta_function; r is not used. */
+double
+LSX_delta(LS_List *solPtr,
+          int edge0fst, int edge0snd, int node,
+          int edge1fst, int edge1snd, gsl_rng *r, int opt);
+
+/* If all the cities have the same probability p, store the powers of
+   1-p in solPtr, so that LSX_delta weights the distance between two
+   cities k steps apart with p^2 (1-p)^(k-1) from a table, and does not
+   multiply the probabilities of the cities in between. Returns 1 if the
+   probabilities are the same, 0 otherwise. */
+int
+LSX_solution_set_homogeneous(LS_List *solPtr);
+
+#endif /* LSX_APPROXIMATION */
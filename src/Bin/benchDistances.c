@@ -0,0 +1,162 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    benchDistances.c
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Benchmark of the storage of the distance matrix
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+/* Usage: benchDistances INSTANCE [MOVES]
+
+   Compares the full distance matrix with the packed lower triangle
+   used by compute_distances: memory, time for computing the matrix,
+   and throughput of the 2-opt and 2.5-opt delta expressions of the
+   local search on MOVES random moves. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <error.h>
+#include <sys/time.h>
+#include <gsl/gsl_rng.h>
+
+#include "readFile.h"
+
+#define BENCH_DEFAULT_MOVES 10000000
+
+#define FULL_INDEX(i,j,n) ((size_t)(i)*(n)+(j))
+#define TRIANGULAR_INDEX(i,j,n) LS_triangular_index((i),(j))
+
+static double
+bench_clock(void)
+{
+  struct timeval t;
+
+  gettimeofday(&t,NULL);
+  return t.tv_sec + t.tv_usec/1e6;
+}
+
+/* Computes the matrix with the given index, columns 0 to end-1 of
+   each row i, and the delta of moves of the local search on the tour
+   0,1,...,n-1: 2-opt of the edges (a,a+1) and (c,c+1), and 2.5-opt
+   moving v between them. Returns the sum of the deltas, so that both
+   layouts can be checked against each other. */
+#define BENCH_LAYOUT(name,INDEX,size,end)                                 \
+static double                                                             \
+bench_##name(problem *insPtr, const int *moves, long int no_moves,        \
+             double *build_time, double *delta_time)                      \
+{                                                                         \
+  long int i, j, k, n = insPtr->n;                                        \
+  LS_DISTANCE *D;                                                         \
+  double start, sum = 0.0;                                                \
+                                                                          \
+  start = bench_clock();                                                  \
+  if (posix_memalign((void **)&D, 64, (size)*sizeof(LS_DISTANCE)))        \
+    error(EXIT_FAILURE,0,"Cannot allocate memory");                       \
+  for (i = 0; i < n; i++)                                                 \
+    for (j = 0; j < (end); j++)                                           \
+      D[INDEX(i,j,n)] = insPtr->distance_function(i,j,insPtr);            \
+  *build_time = bench_clock() - start;                                    \
+                                                                          \
+  start = bench_clock();                                                  \
+  for (k = 0; k < no_moves; k++)                                          \
+    {                                                                     \
+      int a = moves[3*k], c = moves[3*k+1], v = moves[3*k+2];             \
+      int b = (a+1)%n, e = (c+1)%n;                                       \
+      long int two_opt, two_h_opt;                                        \
+                                                                          \
+      two_opt = - D[INDEX(a,b,n)] - D[INDEX(c,e,n)]                       \
+                + D[INDEX(a,c,n)] + D[INDEX(b,e,n)];                      \
+      two_h_opt = - D[INDEX(a,b,n)] - D[INDEX(c,v,n)] - D[INDEX(v,e,n)]   \
+                  + D[INDEX(a,v,n)] + D[INDEX(v,b,n)] + D[INDEX(c,e,n)];  \
+      sum += two_opt + two_h_opt;                                         \
+    }                                                                     \
+  *delta_time = bench_clock() - start;                                    \
+                                                                          \
+  free(D);                                                                \
+  return sum;                                                             \
+}
+
+BENCH_LAYOUT(full,FULL_INDEX,(size_t)n*n,n)
+BENCH_LAYOUT(triangular,TRIANGULAR_INDEX,(size_t)n*(n+1)/2,i+1)
+
+
+int
+main(int argc, char **argv)
+{
+  problem instance;
+  long int k, no_moves = BENCH_DEFAULT_MOVES;
+  int *moves;
+  gsl_rng *R;
+  double build_full, build_tri, delta_full, delta_tri;
+  double sum_full, sum_tri;
+
+  if (argc < 2)
+    error(EXIT_FAILURE,0,"Usage: %s INSTANCE [MOVES]",argv[0]);
+  if (argc > 2)
+    no_moves = atol(argv[2]);
+
+  instance.name = argv[1];
+  instance.nodeptr = read_ptsp(argv[1],&instance);
+
+  moves = malloc(3*no_moves*sizeof(int));
+  if (!moves)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  R = gsl_rng_alloc(gsl_rng_taus);
+  gsl_rng_set(R,0);
+  for (k = 0; k < 3*no_moves; k++)
+    moves[k] = gsl_rng_uniform_int(R,instance.n);
+
+  sum_full = bench_full(&instance,moves,no_moves,&build_full,&delta_full);
+  sum_tri = bench_triangular(&instance,moves,no_moves,&build_tri,&delta_tri);
+  if (sum_full != sum_tri)
+    error(EXIT_FAILURE,0,"The two layouts give different deltas");
+
+  printf("%-12s%12s%12s%16s\n","layout","MB","build [s]","Mmoves/s");
+  printf("%-12s%12.1f%12.3f%16.2f\n","full",
+         (double)instance.n*instance.n*sizeof(LS_DISTANCE)/1048576.0,
+         build_full,no_moves/delta_full/1e6);
+  printf("%-12s%12.1f%12.3f%16.2f\n","triangular",
+         (double)instance.n*(instance.n+1)/2*sizeof(LS_DISTANCE)/1048576.0,
+         build_tri,no_moves/delta_tri/1e6);
+
+  gsl_rng_free(R);
+  free(moves);
+  free(instance.nodeptr);
+  return 0;
+}
@@ -0,0 +1,232 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    benchLibrary.c
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Benchmark of the library against running ptspls
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+/* Usage: benchLibrary INSTANCE [CALLS [STEPS]]
+
+   Compares the two ways a program can run the local search: calling
+   ELS_solve on a libelsptsp context that holds the instance, and
+   spawning ptspls (found next to benchLibrary) and reading its tour.
+   Each of the CALLS searches has its own seed and stops after STEPS
+   steps; both ways must give the same tours. The first call, which
+   builds the initial solution and the neighbor lists, is reported
+   apart from the following ones. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <error.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include "readFile.h"
+#include "elsptsp.h"
+
+#define BENCH_DEFAULT_CALLS 20
+#define BENCH_DEFAULT_STEPS 20
+#define BENCH_MEMORY_BUDGET 4096.0   /* default of ptspls */
+
+extern char **environ;
+
+static double
+bench_clock(void)
+{
+  struct timeval t;
+
+  gettimeofday(&t,NULL);
+  return t.tv_sec + t.tv_usec/1e6;
+}
+
+/* Run ptspls on the instance and read the tour of its last step */
+static void
+bench_spawn(char *ptspls, char *instance, unsigned long int seed,
+            int steps, int *tour, int n)
+{
+  char seed_arg[32], steps_arg[32];
+  char *argv[] = {ptspls, instance, seed_arg, steps_arg, NULL};
+  posix_spawn_file_actions_t actions;
+  char *output = NULL, *s, *next, *end;
+  size_t size = 0, length = 0;
+  ssize_t r;
+  int fd[2], status, i;
+  pid_t pid;
+
+  sprintf(seed_arg,"--seed=%lu",seed);
+  sprintf(steps_arg,"--steps=%d",steps);
+  if (pipe(fd))
+    error(EXIT_FAILURE,errno,"Cannot create a pipe");
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions,fd[1],STDOUT_FILENO);
+  posix_spawn_file_actions_addclose(&actions,fd[0]);
+  posix_spawn_file_actions_addclose(&actions,fd[1]);
+  errno = posix_spawn(&pid,ptspls,&actions,NULL,argv,environ);
+  if (errno)
+    error(EXIT_FAILURE,errno,"Cannot run %s",ptspls);
+  posix_spawn_file_actions_destroy(&actions);
+  close(fd[1]);
+
+  do
+    {
+      if (length + 1 >= size)
+        {
+          size = 2*size + 65536;
+          output = realloc(output,size);
+          if (!output)
+            error(EXIT_FAILURE,0,"Cannot allocate memory");
+        }
+      r = read(fd[0],output + length,size - length - 1);
+      if (r > 0)
+        length += r;
+    }
+  while (r > 0 || (r < 0 && errno == EINTR));
+  close(fd[0]);
+  if (waitpid(pid,&status,0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status))
+    error(EXIT_FAILURE,0,"%s failed",ptspls);
+  output[length] = 0;
+
+  s = NULL;
+  for (next = strstr(output,"Tour\t"); next; next = strstr(next+1,"Tour\t"))
+    s = next + 5;
+  if (!s)
+    error(EXIT_FAILURE,0,"No tour in the output of %s",ptspls);
+  for (i = 0; i < n; i++)
+    {
+      tour[i] = strtol(s,&end,10);
+      if (end == s)
+        error(EXIT_FAILURE,0,"Truncated tour in the output of %s",ptspls);
+      s = end;
+    }
+  free(output);
+}
+
+
+int
+main(int argc, char **argv)
+{
+  static const char *edge_weight_type[] = {"EUC_2D","CEIL_2D","GEO","ATT"};
+  problem instance;
+  ELS_context *context;
+  ELS_config config;
+  ELS_status status;
+  ELS_distance_type type;
+  double *x, *y, *p;
+  double start, time[2][2] = {{0.0,0.0},{0.0,0.0}};
+  int *tour, calls = BENCH_DEFAULT_CALLS, steps = BENCH_DEFAULT_STEPS;
+  int i, k, n;
+  char *ptspls, *slash;
+
+  if (argc < 2)
+    error(EXIT_FAILURE,0,"Usage: %s INSTANCE [CALLS [STEPS]]",argv[0]);
+  if (argc > 2)
+    calls = atoi(argv[2]);
+  if (argc > 3)
+    steps = atoi(argv[3]);
+  if (calls < 1 || steps < 1)
+    error(EXIT_FAILURE,0,"Illegal number of calls or steps");
+
+  ptspls = malloc(strlen(argv[0]) + sizeof("ptspls"));
+  if (!ptspls)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  strcpy(ptspls,argv[0]);
+  slash = strrchr(ptspls,'/');
+  strcpy(slash ? slash+1 : ptspls,"ptspls");
+
+  instance.nodeptr = read_ptsp(argv[1],&instance);
+  n = instance.n;
+  for (type = ELS_EUC_2D; type < ELS_ATT; type++)
+    if (!strcmp(instance.edge_weight_type,edge_weight_type[type]))
+      break;
+  x = malloc(n*sizeof(double));
+  y = malloc(n*sizeof(double));
+  p = malloc(n*sizeof(double));
+  tour = malloc(n*sizeof(int));
+  if (!x || !y || !p || !tour)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (i = 0; i < n; i++)
+    {
+      x[i] = instance.nodeptr[i].x;
+      y[i] = instance.nodeptr[i].y;
+      p[i] = instance.nodeptr[i].prob;
+    }
+
+  if ((status = ELS_context_create(&context)) ||
+      (status = ELS_set_instance(context,n,x,y,p,type,BENCH_MEMORY_BUDGET)))
+    error(EXIT_FAILURE,0,"%s",ELS_status_string(status));
+  ELS_config_default(&config);
+  config.steps = steps;
+
+  for (k = 0; k < calls; k++)
+    {
+      config.seed = k + 1;
+      start = bench_clock();
+      if ((status = ELS_configure(context,&config)) ||
+          (status = ELS_solve(context,NULL)))
+        error(EXIT_FAILURE,0,"%s",ELS_status_string(status));
+      time[0][k > 0] += bench_clock() - start;
+
+      start = bench_clock();
+      bench_spawn(ptspls,argv[1],config.seed,steps,tour,n);
+      time[1][k > 0] += bench_clock() - start;
+
+      if (memcmp(tour,ELS_tour(context),n*sizeof(int)))
+        error(EXIT_FAILURE,0,"Seed %lu: the library and ptspls give different tours",
+              config.seed);
+    }
+
+  printf("%-12s%16s%16s\n","","first [ms]","per call [ms]");
+  for (i = 0; i < 2; i++)
+    printf("%-12s%16.3f%16.3f\n",i ? "process" : "library",1e3*time[i][0],
+           calls > 1 ? 1e3*time[i][1]/(calls-1) : 1e3*time[i][0]);
+
+  ELS_context_free(context);
+  free(tour);
+  free(x);
+  free(y);
+  free(p);
+  free(ptspls);
+  free(instance.nodeptr);
+  return 0;
+}
@@ -0,0 +1,226 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    buildCache.c
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Builds the instance cache read by ptspls and evaluate
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <error.h>
+#include <argp.h>
+#include <sys/stat.h>
+
+#include "readFile.h"
+#include "instanceCache.h"
+
+/* Lists of the default exploration of ptspls */
+#define LS_CACHE_DEFAULT_NEIGHBORS 40
+
+#define LS_LONGOPTIONONLY_NO_MATRIX 1
+
+const char *argp_program_version = "ptspcache 0.0";
+const char *argp_program_bug_address = "<prasanna@iridia.ulb.ac.be,prasannaprakash@gmail.com>";
+
+static char doc[] = "ptspcache -- Build the instance cache of a PTSP instance, "
+  "which ptspls and evaluate read in place of the instance.  "
+  "Nothing is done if the cache is up to date.";
+static char args_doc[] = "INSTANCE CACHE";
+
+static struct argp_option options[] =
+    {
+      {"neighbors",
+       'n',
+       "N",
+       0,
+       "Store the nearest-neighbor lists of N neighbors.  Can be repeated."},
+      {"quadrant-neighbors",
+       'q',
+       "N",
+       0,
+       "Store the quadrant-nearest-neighbor lists of N neighbors, a multiple of 4.  "
+       "Can be repeated.  Without any -n or -q, the lists of the default "
+       "exploration of ptspls are stored."},
+      {"no-matrix",
+       LS_LONGOPTIONONLY_NO_MATRIX,
+       0,
+       0,
+       "Do not store the distance matrix"},
+      {"force",
+       'f',
+       0,
+       0,
+       "Build the cache even if it is up to date"},
+      {0}
+    };
+
+struct arguments
+  {
+    char *instance;
+    char *cache;
+    int with_matrix;
+    int force;
+    int kind[LS_CACHE_MAX_LISTS];
+    int nn[LS_CACHE_MAX_LISTS];
+    int no_lists;
+  };
+
+static error_t
+parse_opt (int key, char *arg, struct argp_state *state)
+{
+  struct arguments *arguments = (struct arguments*)state->input;
+  int nn;
+
+  switch (key)
+    {
+    case 'n':
+    case 'q':
+      nn = atoi(arg);
+      if (nn < 1 || (key == 'q' && nn%4 != 0))
+        argp_error(state,"Illegal number of neighbors");
+      if (arguments->no_lists == LS_CACHE_MAX_LISTS)
+        argp_error(state,"Too many neighbor lists");
+      arguments->kind[arguments->no_lists] =
+        (key == 'n') ? LS_CACHE_NN_LISTS : LS_CACHE_QNN_LISTS;
+      arguments->nn[arguments->no_lists] = nn;
+      arguments->no_lists++;
+      break;
+    case LS_LONGOPTIONONLY_NO_MATRIX:
+      arguments->with_matrix = 0;
+      break;
+    case 'f':
+      arguments->force = 1;
+      break;
+    case ARGP_KEY_ARG:
+      if (state->arg_num == 0)
+        arguments->instance = arg;
+      else if (state->arg_num == 1)
+        arguments->cache = arg;
+      else
+        argp_usage(state);
+      break;
+    case ARGP_KEY_END:
+      if (state->arg_num < 2)
+        argp_usage(state);
+      break;
+    default:
+      return ARGP_ERR_UNKNOWN;
+    }
+  return 0;
+}
+
+static struct argp argp = { options, parse_opt, args_doc, doc };
+
+
+/* Whether the cache has been built from the current content of the
+   instance, with all that is asked for */
+static int
+cache_is_current(const struct arguments *arguments)
+{
+  LS_cache_header header;
+  struct stat status;
+  uint64_t hash, size;
+  uint32_t l;
+  int i, found;
+  FILE *file = fopen(arguments->cache,"rb");
+
+  if (!file)
+    return 0;
+  found = fread(&header,sizeof(header),1,file) == 1 &&
+          fstat(fileno(file),&status) == 0;
+  fclose(file);
+  if (!found ||
+      memcmp(header.magic,LS_CACHE_MAGIC,sizeof(header.magic)) != 0 ||
+      header.version != LS_CACHE_VERSION ||
+      header.byte_order != LS_CACHE_BYTE_ORDER ||
+      header.file_size != (uint64_t)status.st_size ||
+      (arguments->with_matrix &&
+       (header.distance_size != sizeof(LS_DISTANCE) ||
+        header.distance_flags != LS_cache_distance_flags())))
+    return 0;
+
+  for (i = 0; i < arguments->no_lists; i++)
+    {
+      found = 0;
+      for (l = 0; l < header.no_lists; l++)
+        found |= header.list[l].kind == (uint32_t)arguments->kind[i] &&
+                 header.list[l].nn == (uint32_t)arguments->nn[i];
+      if (!found)
+        return 0;
+    }
+
+  if (!LS_cache_hash_file(arguments->instance,&hash,&size))
+    error(EXIT_FAILURE,0,"Cannot read %s",arguments->instance);
+  return hash == header.source_hash && size == header.source_size;
+}
+
+
+int
+main(int argc, char **argv)
+{
+  struct arguments arguments;
+  problem instance;
+
+  memset(&arguments,0,sizeof(arguments));
+  arguments.with_matrix = 1;
+  argp_parse(&argp,argc,argv,0,0,&arguments);
+  if (!arguments.no_lists)
+    {
+      arguments.kind[0] = LS_CACHE_QNN_LISTS;
+      arguments.nn[0] = LS_CACHE_DEFAULT_NEIGHBORS;
+      arguments.no_lists = 1;
+    }
+
+  if (!arguments.force && cache_is_current(&arguments))
+    {
+      printf("%s is up to date\n",arguments.cache);
+      return 0;
+    }
+
+  instance.name = arguments.instance;
+  instance.nodeptr = read_ptsp(arguments.instance,&instance);
+  LS_cache_write(arguments.cache,arguments.instance,&instance,
+                 arguments.with_matrix,arguments.kind,arguments.nn,
+                 arguments.no_lists);
+  free_distances(&instance);
+  free(instance.nodeptr);
+  return 0;
+}
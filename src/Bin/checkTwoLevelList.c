@@ -0,0 +1,220 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    checkTwoLevelList.c
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Randomized check of the two-level list against an array
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+/* Usage: checkTwoLevelList [CITIES [MOVES [SEED]]]
+
+   Reverses MOVES random paths of a random tour of CITIES cities, kept
+   both in a two-level list and in an array, and checks after each one
+   the segments, the cities after and before each city, its position,
+   and LST_between on random triples. Without CITIES, a few sizes are
+   checked, from the smallest tour on. The number of reversals which
+   moved cities between segments, and of those which left the segments
+   as LST_tour_set builds them, as the rebalancing does, are printed, so
+   that the runs can be seen to go through all the paths of
+   LST_reverse. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <error.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+
+#include "twoLevelList.h"
+
+#define CHECK_DEFAULT_MOVES 20000
+#define CHECK_BETWEEN_TRIPLES 16
+
+static const int check_sizes[] = {3, 4, 5, 7, 16, 17, 50, 101, 1000};
+
+/* The structure of the segments, and the tour against the array */
+static void
+check_tour(const LST_tour *tour, const int *city, const int *position,
+           long int move)
+{
+  int n = tour->no_cities, no_cities = 0, no_segments = 0;
+  int s = 0, c, k;
+
+  do
+    {
+      const struct LST_segment *segment = &tour->segment[s];
+
+      if (segment->size < 1 || tour->segment[segment->next].prev != s)
+        error(EXIT_FAILURE,0,"Move %ld: segment %d is not linked",move,s);
+      for (k = 0, c = segment->first; c >= 0; k++, c = tour->succ[c])
+        if (tour->parent[c] != s || tour->rank[c] != tour->rank[segment->first] + k ||
+            (c != segment->first && tour->succ[tour->pred[c]] != c) ||
+            (tour->succ[c] < 0 && c != segment->last))
+          error(EXIT_FAILURE,0,"Move %ld: city %d is not linked in segment %d",
+                move,c,s);
+      if (k != segment->size)
+        error(EXIT_FAILURE,0,"Move %ld: segment %d has %d cities, not %d",
+              move,s,k,segment->size);
+      no_cities += k;
+      no_segments++;
+      s = segment->next;
+    }
+  while (s != 0 && no_segments <= tour->no_segments);
+  if (no_segments != tour->no_segments || no_cities != n)
+    error(EXIT_FAILURE,0,"Move %ld: the segments do not hold the tour",move);
+  if (tour->unbalanced)
+    error(EXIT_FAILURE,0,"Move %ld: the segments were not built again",move);
+
+  for (c = 0; c < n; c++)
+    if (LST_position(tour,c) != position[c] ||
+        LST_next(tour,c) != city[(position[c] + 1) % n] ||
+        LST_prev(tour,c) != city[(position[c] + n - 1) % n])
+      error(EXIT_FAILURE,0,"Move %ld: city %d differs from the array",move,c);
+}
+
+/* Whether the segments are those built by LST_tour_set */
+static int
+check_built(const LST_tour *tour)
+{
+  int s;
+
+  for (s = 0; s < tour->no_segments; s++)
+    if (tour->segment[s].reversed || tour->segment[s].position != s*tour->group ||
+        tour->segment[s].next != (s + 1) % tour->no_segments)
+      return 0;
+  return 1;
+}
+
+static void
+check_size(int n, long int no_moves, gsl_rng *R)
+{
+  LST_tour *tour = LST_tour_allocate(n);
+  int *city = malloc(n*sizeof(int)), *position = malloc(n*sizeof(int));
+  int *size = malloc(tour->no_segments*sizeof(int));
+  long int move, no_split = 0, no_built = 0;
+  int i, j, k, l, a, b, c, t;
+
+  if (!city || !position || !size)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (i = 0; i < n; i++)
+    city[i] = i;
+  gsl_ran_shuffle(R,city,n,sizeof(int));
+  for (i = 0; i < n; i++)
+    position[city[i]] = i;
+  LST_tour_set(tour,position);
+  check_tour(tour,city,position,0);
+
+  for (move = 1; move <= no_moves; move++)
+    {
+      a = gsl_rng_uniform_int(R,n);
+      b = gsl_rng_uniform_int(R,n);
+      for (k = 0; k < tour->no_segments; k++)
+        size[k] = tour->segment[k].size;
+
+      LST_reverse(tour,a,b);
+      /* The path takes the positions it had, in the opposite order */
+      l = (position[b] - position[a] + n) % n + 1;
+      for (i = position[a], j = position[b], k = 0; k < l/2;
+           k++, i = (i + 1) % n, j = (j + n - 1) % n)
+        {
+          t = city[i];
+          city[i] = city[j];
+          city[j] = t;
+          position[city[i]] = i;
+          position[city[j]] = j;
+        }
+      check_tour(tour,city,position,move);
+
+      if (a != b && check_built(tour))
+        no_built++;
+      else
+        for (k = 0; k < tour->no_segments; k++)
+          if (tour->segment[k].size != size[k])
+            {
+              no_split++;
+              break;
+            }
+
+      for (k = 0; k < CHECK_BETWEEN_TRIPLES; k++)
+        {
+          a = gsl_rng_uniform_int(R,n);
+          b = gsl_rng_uniform_int(R,n);
+          c = gsl_rng_uniform_int(R,n);
+          if (LST_between(tour,a,b,c) !=
+              ((position[b] - position[a] + n) % n <= (position[c] - position[a] + n) % n))
+            error(EXIT_FAILURE,0,"Move %ld: LST_between(%d,%d,%d) differs from the array",
+                  move,a,b,c);
+        }
+    }
+
+  printf("%8d cities%10ld moves%10ld split%10ld built again\n",
+         n,no_moves,no_split,no_built);
+  free(size);
+  free(position);
+  free(city);
+  LST_tour_free(tour);
+}
+
+
+int
+main(int argc, char **argv)
+{
+  long int no_moves = CHECK_DEFAULT_MOVES;
+  unsigned long int seed = 0;
+  gsl_rng *R;
+  size_t i;
+
+  if (argc > 4)
+    error(EXIT_FAILURE,0,"Usage: %s [CITIES [MOVES [SEED]]]",argv[0]);
+  if (argc > 2)
+    no_moves = atol(argv[2]);
+  if (argc > 3)
+    seed = strtoul(argv[3],NULL,10);
+  if (argc > 1 && atoi(argv[1]) < 3)
+    error(EXIT_FAILURE,0,"A tour needs at least three cities");
+
+  R = gsl_rng_alloc(gsl_rng_taus);
+  gsl_rng_set(R,seed);
+  if (argc > 1)
+    check_size(atoi(argv[1]),no_moves,R);
+  else
+    for (i = 0; i < sizeof(check_sizes)/sizeof(check_sizes[0]); i++)
+      check_size(check_sizes[i],no_moves,R);
+  gsl_rng_free(R);
+  return 0;
+}
@@ -0,0 +1,593 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    delaunay.c
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Delaunay triangulation of the cities for candidate lists
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#include <stdlib.h>
+#include <error.h>
+
+#include "delaunay.h"
+#include "kdTree.h"
+
+/* Triangles are counterclockwise, nb[i] being the triangle across the
+   edge opposite to v[i]. Each edge of the convex hull is also an edge
+   of a ghost triangle whose third vertex is the vertex at infinity, so
+   that cities outside the hull are inserted as the others (Bowyer and
+   Watson's algorithm). A triangle is free when v[0] is -1. */
+struct DT_triangle
+  {
+    int v[3];
+    int nb[3];
+    int mark;                        /* insertion whose cavity contains it */
+  };
+
+/* Edge u->w of the cavity of an insertion, seen from inside, with the
+   triangle outside the cavity */
+struct DT_edge
+  {
+    int u, w;
+    int out;
+  };
+
+typedef struct
+  {
+    const struct point *p;
+    int infinite;                    /* index of the vertex at infinity */
+    struct DT_triangle *t;
+    int no_triangles, max_triangles;
+    int *free_triangles;
+    int no_free, max_free;
+    int *cavity;
+    int no_cavity, max_cavity;
+    struct DT_edge *boundary;
+    int no_boundary, max_boundary;
+    int *by_start;                   /* new triangle starting at each vertex */
+    int last;                        /* triangle from which walks start */
+    int stamp;
+  }
+DT_triangulation;
+
+
+static void *
+DT_reserve(void *buffer, int *max, int size, size_t element)
+{
+  if (size <= *max)
+    return buffer;
+  while (*max < size)
+    *max = 2*(*max) + 16;
+  buffer = realloc(buffer,(size_t)(*max)*element);
+  if (!buffer)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  return buffer;
+}
+
+/* Twice the signed area of a, b, c: positive if counterclockwise */
+static double
+DT_orient(const DT_triangulation *T, int a, int b, int c)
+{
+  const struct point *p = T->p;
+
+  return (p[b].x - p[a].x)*(p[c].y - p[a].y) -
+         (p[b].y - p[a].y)*(p[c].x - p[a].x);
+}
+
+/* Positive if d lies inside the circle through the counterclockwise
+   a, b, c */
+static double
+DT_incircle(const DT_triangulation *T, int a, int b, int c, int d)
+{
+  const struct point *p = T->p;
+  double adx = p[a].x - p[d].x, ady = p[a].y - p[d].y;
+  double bdx = p[b].x - p[d].x, bdy = p[b].y - p[d].y;
+  double cdx = p[c].x - p[d].x, cdy = p[c].y - p[d].y;
+
+  return (adx*adx + ady*ady)*(bdx*cdy - cdx*bdy) +
+         (bdx*bdx + bdy*bdy)*(cdx*ady - adx*cdy) +
+         (cdx*cdx + cdy*cdy)*(adx*bdy - bdx*ady);
+}
+
+static int
+DT_ghost_vertex(const DT_triangulation *T, int id)
+{
+  int k;
+
+  for (k = 0; k < 3; k++)
+    if (T->t[id].v[k] == T->infinite)
+      return k;
+  return -1;
+}
+
+/* Whether city c lies in the circumcircle of the triangle; for a ghost
+   triangle, that is the open half-plane beyond its hull edge together
+   with the inside of the edge */
+static int
+DT_in_circle(const DT_triangulation *T, int id, int c)
+{
+  const struct point *p = T->p;
+  const struct DT_triangle *t = &T->t[id];
+  int k = DT_ghost_vertex(T,id), x, y;
+  double orient;
+
+  if (k < 0)
+    return DT_incircle(T,t->v[0],t->v[1],t->v[2],c) > 0.0;
+  x = t->v[(k+1)%3];
+  y = t->v[(k+2)%3];
+  orient = DT_orient(T,x,y,c);
+  if (orient != 0.0)
+    return orient > 0.0;
+  return (p[c].x - p[x].x)*(p[c].x - p[y].x) +
+         (p[c].y - p[x].y)*(p[c].y - p[y].y) < 0.0;
+}
+
+static int
+DT_new_triangle(DT_triangulation *T, int a, int b, int c)
+{
+  int id;
+
+  if (T->no_free)
+    id = T->free_triangles[--T->no_free];
+  else
+    {
+      T->t = DT_reserve(T->t,&T->max_triangles,T->no_triangles+1,
+                        sizeof(struct DT_triangle));
+      id = T->no_triangles++;
+    }
+  T->t[id].v[0] = a;
+  T->t[id].v[1] = b;
+  T->t[id].v[2] = c;
+  T->t[id].mark = 0;
+  return id;
+}
+
+static void
+DT_free_triangle(DT_triangulation *T, int id)
+{
+  T->free_triangles = DT_reserve(T->free_triangles,&T->max_free,
+                                 T->no_free+1,sizeof(int));
+  T->free_triangles[T->no_free++] = id;
+  T->t[id].v[0] = -1;
+}
+
+/* Triangle containing city c, or ghost triangle beyond whose edge it
+   lies, found by looking at all of them; -1 if rounding has left none */
+static int
+DT_scan(const DT_triangulation *T, int c)
+{
+  int id, i;
+
+  for (id = 0; id < T->no_triangles; id++)
+    if (T->t[id].v[0] >= 0 && DT_ghost_vertex(T,id) < 0)
+      {
+        for (i = 0; i < 3; i++)
+          if (DT_orient(T,T->t[id].v[(i+1)%3],T->t[id].v[(i+2)%3],c) < 0.0)
+            break;
+        if (i == 3)
+          return id;
+      }
+  for (id = 0; id < T->no_triangles; id++)
+    if (T->t[id].v[0] >= 0 && DT_ghost_vertex(T,id) >= 0 &&
+        DT_in_circle(T,id,c))
+      return id;
+  return -1;
+}
+
+/* Walk from the last triangle created towards city c. The edge looked
+   at first changes at each step, so that the walk cannot cycle; should
+   rounding make it too long, all the triangles are scanned. */
+static int
+DT_locate(const DT_triangulation *T, int c)
+{
+  int id = T->last, i = 0, k, steps = 0;
+  const struct DT_triangle *t;
+
+  k = DT_ghost_vertex(T,id);
+  if (k >= 0)
+    id = T->t[id].nb[k];
+  for (;;)
+    {
+      if (DT_ghost_vertex(T,id) >= 0)
+        return id;
+      t = &T->t[id];
+      for (k = 0; k < 3; k++)
+        {
+          i = (k + steps) % 3;
+          if (DT_orient(T,t->v[(i+1)%3],t->v[(i+2)%3],c) < 0.0)
+            break;
+        }
+      if (k == 3)
+        return id;
+      id = t->nb[i];
+      if (++steps > T->no_triangles)
+        return DT_scan(T,c);
+    }
+}
+
+/* Replace the triangle across edge w->u of triangle out with id */
+static void
+DT_relink(DT_triangulation *T, int out, int u, int w, int id)
+{
+  struct DT_triangle *t = &T->t[out];
+  int i;
+
+  for (i = 0; i < 3; i++)
+    if (t->v[(i+1)%3] == w && t->v[(i+2)%3] == u)
+      t->nb[i] = id;
+}
+
+/* Insert city c, or return the city at its position; -1 if it cannot
+   be located */
+static int
+DT_insert(DT_triangulation *T, int c)
+{
+  const struct point *p = T->p;
+  int start = DT_locate(T,c), id, nb, u, w, i, j, k;
+
+  if (start < 0)
+    return -1;
+  for (k = 0; k < 3; k++)
+    {
+      u = T->t[start].v[k];
+      if (u != T->infinite && p[u].x == p[c].x && p[u].y == p[c].y)
+        return u;
+    }
+
+  /* The cavity: triangles whose circumcircle contains c. A triangle is
+     also taken when c does not lie strictly on the inner side of the
+     edge it shares with the cavity, so that the new triangles are
+     never inverted whatever the rounding of DT_incircle. */
+  T->stamp++;
+  T->no_cavity = 0;
+  T->cavity = DT_reserve(T->cavity,&T->max_cavity,1,sizeof(int));
+  T->cavity[T->no_cavity++] = start;
+  T->t[start].mark = T->stamp;
+  for (j = 0; j < T->no_cavity; j++)
+    for (i = 0; i < 3; i++)
+      {
+        id = T->cavity[j];
+        nb = T->t[id].nb[i];
+        if (T->t[nb].mark == T->stamp)
+          continue;
+        u = T->t[id].v[(i+1)%3];
+        w = T->t[id].v[(i+2)%3];
+        if (DT_in_circle(T,nb,c) ||
+            (u != T->infinite && w != T->infinite &&
+             DT_orient(T,u,w,c) <= 0.0))
+          {
+            T->cavity = DT_reserve(T->cavity,&T->max_cavity,
+                                   T->no_cavity+1,sizeof(int));
+            T->cavity[T->no_cavity++] = nb;
+            T->t[nb].mark = T->stamp;
+          }
+      }
+
+  T->no_boundary = 0;
+  for (j = 0; j < T->no_cavity; j++)
+    for (i = 0; i < 3; i++)
+      {
+        id = T->cavity[j];
+        nb = T->t[id].nb[i];
+        if (T->t[nb].mark == T->stamp)
+          continue;
+        T->boundary = DT_reserve(T->boundary,&T->max_boundary,
+                                 T->no_boundary+1,sizeof(struct DT_edge));
+        T->boundary[T->no_boundary].u = T->t[id].v[(i+1)%3];
+        T->boundary[T->no_boundary].w = T->t[id].v[(i+2)%3];
+        T->boundary[T->no_boundary].out = nb;
+        T->no_boundary++;
+      }
+  for (j = 0; j < T->no_cavity; j++)
+    DT_free_triangle(T,T->cavity[j]);
+
+  /* Join c to the edges of the cavity */
+  for (j = 0; j < T->no_boundary; j++)
+    {
+      u = T->boundary[j].u;
+      w = T->boundary[j].w;
+      id = DT_new_triangle(T,u,w,c);
+      T->t[id].nb[2] = T->boundary[j].out;
+      DT_relink(T,T->boundary[j].out,u,w,id);
+      T->by_start[u] = id;
+    }
+  for (j = 0; j < T->no_boundary; j++)
+    {
+      id = T->by_start[T->boundary[j].u];
+      nb = T->by_start[T->boundary[j].w];
+      T->t[id].nb[0] = nb;
+      T->t[nb].nb[1] = id;
+    }
+  T->last = id;
+  return c;
+}
+
+/* First triangle, with the ghost triangles on its edges */
+static void
+DT_start(DT_triangulation *T, int a, int b, int c)
+{
+  int r, gab, gbc, gca, tmp;
+
+  if (DT_orient(T,a,b,c) < 0.0)
+    {
+      tmp = b;
+      b = c;
+      c = tmp;
+    }
+  r = DT_new_triangle(T,a,b,c);
+  gab = DT_new_triangle(T,b,a,T->infinite);
+  gbc = DT_new_triangle(T,c,b,T->infinite);
+  gca = DT_new_triangle(T,a,c,T->infinite);
+  T->t[r].nb[0] = gbc;
+  T->t[r].nb[1] = gca;
+  T->t[r].nb[2] = gab;
+  T->t[gab].nb[0] = gca;
+  T->t[gab].nb[1] = gbc;
+  T->t[gab].nb[2] = r;
+  T->t[gbc].nb[0] = gab;
+  T->t[gbc].nb[1] = gca;
+  T->t[gbc].nb[2] = r;
+  T->t[gca].nb[0] = gbc;
+  T->t[gca].nb[1] = gab;
+  T->t[gca].nb[2] = r;
+  T->last = r;
+}
+
+/* A city with its position, for sorting cities along a line without
+   global state */
+struct DT_key
+  {
+    double x, y;
+    int city;
+  };
+
+static int
+DT_compare_keys(const void *a, const void *b)
+{
+  const struct DT_key *p = a;
+  const struct DT_key *q = b;
+
+  if (p->x != q->x)
+    return (p->x < q->x) ? -1 : 1;
+  if (p->y != q->y)
+    return (p->y < q->y) ? -1 : 1;
+  return p->city - q->city;
+}
+
+/* Cities all on a line: sorted along it, each one is joined to the
+   next one at a different position. Edges are stored in pairs. */
+static int
+DT_line_edges(const struct point *p, int *order, int n, int *rep, int *edge)
+{
+  int i, no_edges = 0, previous;
+  struct DT_key *key;
+
+  key = malloc(n*sizeof(struct DT_key));
+  if (!key)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (i = 0; i < n; i++)
+    {
+      key[i].x = p[order[i]].x;
+      key[i].y = p[order[i]].y;
+      key[i].city = order[i];
+    }
+  qsort(key,n,sizeof(struct DT_key),DT_compare_keys);
+  for (i = 0; i < n; i++)
+    order[i] = key[i].city;
+  free(key);
+  previous = order[0];
+  rep[order[0]] = order[0];
+  for (i = 1; i < n; i++)
+    if (p[order[i]].x == p[previous].x && p[order[i]].y == p[previous].y)
+      rep[order[i]] = previous;
+    else
+      {
+        rep[order[i]] = order[i];
+        edge[2*no_edges] = previous;
+        edge[2*no_edges+1] = order[i];
+        no_edges++;
+        previous = order[i];
+      }
+  return no_edges;
+}
+
+
+static void
+DT_triangulation_free(DT_triangulation *T)
+{
+  free(T->t);
+  free(T->free_triangles);
+  free(T->cavity);
+  free(T->boundary);
+  free(T->by_start);
+}
+
+
+int
+DT_graph_build(problem *insPtr, DT_graph *graph)
+{
+  DT_triangulation T;
+  KD_tree tree;
+  const struct point *p = insPtr->nodeptr;
+  int n = insPtr->n;
+  int *order, *rep, *edge, *degree, *members, *member;
+  int i, j, k, a, b = -1, c = -1, r, no_edges = 0;
+
+  /* Cities close in the order of the tree are close in the plane,
+     which keeps the walks short */
+  tree = KD_tree_build(insPtr);
+  order = tree.city;
+  rep = malloc(n*sizeof(int));
+  edge = malloc(2*(3*n)*sizeof(int));
+  if (!rep || !edge)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+
+  T.p = p;
+  T.infinite = n;
+  T.t = NULL;
+  T.no_triangles = T.max_triangles = 0;
+  T.free_triangles = NULL;
+  T.no_free = T.max_free = 0;
+  T.cavity = NULL;
+  T.no_cavity = T.max_cavity = 0;
+  T.boundary = NULL;
+  T.no_boundary = T.max_boundary = 0;
+  T.by_start = malloc((n+1)*sizeof(int));
+  T.stamp = 0;
+  if (!T.by_start)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+
+  a = order[0];
+  for (i = 1; i < n && b < 0; i++)
+    if (p[order[i]].x != p[a].x || p[order[i]].y != p[a].y)
+      b = order[i];
+  for (; b >= 0 && i < n && c < 0; i++)
+    if (DT_orient(&T,a,b,order[i]) != 0.0)
+      c = order[i];
+
+  if (c < 0)
+    no_edges = DT_line_edges(p,order,n,rep,edge);
+  else
+    {
+      DT_start(&T,a,b,c);
+      for (i = 0; i < n; i++)
+        {
+          k = order[i];
+          rep[k] = (k == a || k == b || k == c) ? k : DT_insert(&T,k);
+          if (rep[k] < 0)
+            {
+              free(edge);
+              free(rep);
+              DT_triangulation_free(&T);
+              KD_tree_free(&tree);
+              return 0;
+            }
+        }
+      for (i = 0; i < T.no_triangles; i++)
+        if (T.t[i].v[0] >= 0)
+          for (k = 0; k < 3; k++)
+            {
+              a = T.t[i].v[(k+1)%3];
+              b = T.t[i].v[(k+2)%3];
+              if (a < b && b != T.infinite)
+                {
+                  edge[2*no_edges] = a;
+                  edge[2*no_edges+1] = b;
+                  no_edges++;
+                }
+            }
+    }
+
+  /* Cities at the same position are grouped behind the one inserted */
+  degree = calloc(n+1,sizeof(int));
+  members = calloc(n+1,sizeof(int));
+  member = malloc(n*sizeof(int));
+  if (!degree || !members || !member)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (i = 0; i < n; i++)
+    members[rep[i]+1]++;
+  for (i = 0; i < n; i++)
+    members[i+1] += members[i];
+  for (i = 0; i < n; i++)
+    member[members[rep[i]] + degree[rep[i]]++] = i;
+
+  /* Each city: the others of its group and the groups of the cities
+     adjacent to the one inserted */
+  for (i = 0; i < n; i++)
+    degree[i] = members[rep[i]+1] - members[rep[i]] - 1;
+  for (j = 0; j < no_edges; j++)
+    {
+      a = edge[2*j];
+      b = edge[2*j+1];
+      for (k = members[a]; k < members[a+1]; k++)
+        degree[member[k]] += members[b+1] - members[b];
+      for (k = members[b]; k < members[b+1]; k++)
+        degree[member[k]] += members[a+1] - members[a];
+    }
+
+  graph->no_cities = n;
+  graph->first = malloc((n+1)*sizeof(int));
+  if (!graph->first)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  graph->first[0] = 0;
+  for (i = 0; i < n; i++)
+    graph->first[i+1] = graph->first[i] + degree[i];
+  graph->city = malloc((graph->first[n] ? graph->first[n] : 1)*sizeof(int));
+  if (!graph->city)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+
+  for (i = 0; i < n; i++)
+    {
+      degree[i] = graph->first[i];
+      r = rep[i];
+      for (k = members[r]; k < members[r+1]; k++)
+        if (member[k] != i)
+          graph->city[degree[i]++] = member[k];
+    }
+  for (j = 0; j < no_edges; j++)
+    {
+      a = edge[2*j];
+      b = edge[2*j+1];
+      for (k = members[a]; k < members[a+1]; k++)
+        for (i = members[b]; i < members[b+1]; i++)
+          {
+            graph->city[degree[member[k]]++] = member[i];
+            graph->city[degree[member[i]]++] = member[k];
+          }
+    }
+
+  free(degree);
+  free(members);
+  free(member);
+  free(edge);
+  free(rep);
+  DT_triangulation_free(&T);
+  KD_tree_free(&tree);
+  return 1;
+}
+
+
+void
+DT_graph_free(DT_graph *graph)
+{
+  free(graph->first);
+  free(graph->city);
+  graph->first = NULL;
+  graph->city = NULL;
+}
@@ -0,0 +1,73 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    delaunay.h
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Delaunay triangulation of the cities for candidate lists
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#ifndef DT_DELAUNAY
+#define DT_DELAUNAY
+
+#include "problemdataStructures.h"
+
+/* Adjacency of the cities in the Delaunay triangulation of their
+   coordinates: the neighbors of city i are city[first[i]] to
+   city[first[i+1]-1]. Cities at the same position are neighbors of
+   each other and share all their other neighbors; if all the cities
+   lie on a line, each one is adjacent to the next ones along it. */
+typedef struct
+  {
+    int no_cities;
+    int *first;
+    int *city;
+  }
+DT_graph;
+
+/* Triangulate the cities of the instance, in expected O(n log n)
+   time. Coordinates are taken as points of the plane, also for GEO
+   instances. Returns 0, with nothing allocated, if rounding leaves a
+   city outside of all the triangles. */
+int
+DT_graph_build(problem *insPtr, DT_graph *graph);
+
+void
+DT_graph_free(DT_graph *graph);
+
+#endif /* DT_DELAUNAY */
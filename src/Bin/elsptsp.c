@@ -0,0 +1,425 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    elsptsp.c
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Library interface of the estimation-based local search
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_rng.h>
+
+#include "elsptsp.h"
+#include "heuristics.h"
+#include "readFile.h"
+#include "sampleLS.h"
+#include "adaptiveSampling.h"
+
+/* Bounds of the configuration, as those of the options of ptspls */
+#define ELS_MAX_REALIZATIONS 10000
+#define ELS_MAX_NEIGHBORS 1000
+#define ELS_MAX_WINDOW_SIZE 50.0
+#define ELS_MAX_NODES 100.0
+#define ELS_MAX_EVALUATION_THREADS 1024
+
+struct ELS_context
+  {
+    problem instance;
+    int has_instance;
+    double *prob_vec;
+    int *tour;                       /* of the last search */
+    int has_tour;
+    ELS_config config;
+    gsl_rng *R;
+
+    /* Kept across searches, and released when what they depend on
+       changes */
+    LS_SOLUTION_INT *apriori_solution;
+    ELS_init_type apriori_initialization;
+    LS_candidates candidates;
+    int has_candidates;
+    ELS_exploration_type candidates_exploration;
+    int candidates_neighbors;
+
+    /* Search being run */
+    const ELS_callbacks *callbacks;
+    double start;
+  };
+
+
+/* Processor time of the calling thread */
+static double
+ELS_clock(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID,&t);
+  return t.tv_sec + t.tv_nsec/1e9;
+}
+
+
+void
+ELS_config_default(ELS_config *config)
+{
+  config->initialization = ELS_INIT_NN;
+  config->exploration = ELS_EXPLORATION_QNN;
+  config->neighbors = 40;
+  config->seed = 0;
+  config->realizations = 5;
+  config->sampling_type = 1;
+  config->alpha = 0.05;
+  config->importance_sampling = 1;
+  config->delta_probability = 0.069;
+  config->delta_dash_probability = 0.57;
+  config->window_size = 1.3;
+  config->nodes = 10;
+  config->evaluation_threads = 1;
+  config->evaluation_tolerance = 0;
+  config->realization_threads = 1;
+  config->realization_chunk = 16;
+  config->steps = 0;
+  config->time = 0.0;
+}
+
+
+ELS_status
+ELS_context_create(ELS_context **context)
+{
+  ELS_context *c;
+
+  *context = NULL;
+  c = calloc(1,sizeof(ELS_context));
+  if (!c)
+    return ELS_ERROR_MEMORY;
+  c->R = gsl_rng_alloc (gsl_rng_taus);
+  if (!c->R)
+    {
+      free(c);
+      return ELS_ERROR_MEMORY;
+    }
+  ELS_config_default(&c->config);
+  *context = c;
+  return ELS_OK;
+}
+
+
+/* Release what is kept for the current instance */
+static void
+ELS_release_instance(ELS_context *context)
+{
+  if (context->has_candidates)
+    LS_candidates_free(&context->candidates);
+  context->has_candidates = 0;
+  free(context->apriori_solution);
+  context->apriori_solution = NULL;
+  if (context->has_instance)
+    {
+      free_distances(&context->instance);
+      free(context->instance.nodeptr);
+    }
+  context->has_instance = 0;
+  free(context->prob_vec);
+  context->prob_vec = NULL;
+  free(context->tour);
+  context->tour = NULL;
+  context->has_tour = 0;
+}
+
+
+void
+ELS_context_free(ELS_context *context)
+{
+  if (!context)
+    return;
+  ELS_release_instance(context);
+  gsl_rng_free(context->R);
+  free(context);
+}
+
+
+ELS_status
+ELS_set_instance(ELS_context *context, int n, const double *x,
+                 const double *y, const double *probability,
+                 ELS_distance_type type, double memory_budget)
+{
+  static const char *edge_weight_type[] = {"EUC_2D","CEIL_2D","GEO","ATT"};
+  problem *insPtr = &context->instance;
+  int i;
+
+  if (n < 3 || type < ELS_EUC_2D || type > ELS_ATT || !(memory_budget >= 0.0))
+    return ELS_ERROR_INSTANCE;
+  for (i=0; i<n; i++)
+    if (!isfinite(x[i]) || !isfinite(y[i]) ||
+        !(probability[i] >= 0.0 && probability[i] <= 1.0))
+      return ELS_ERROR_INSTANCE;
+
+  ELS_release_instance(context);
+  memset(insPtr,0,sizeof(problem));
+  insPtr->n = n;
+  insPtr->nodeptr = malloc(n*sizeof(struct point));
+  context->prob_vec = malloc(n*sizeof(double));
+  context->tour = malloc(n*sizeof(int));
+  if (!insPtr->nodeptr || !context->prob_vec || !context->tour)
+    {
+      free(insPtr->nodeptr);
+      free(context->prob_vec);
+      free(context->tour);
+      context->prob_vec = NULL;
+      context->tour = NULL;
+      return ELS_ERROR_MEMORY;
+    }
+  for (i=0; i<n; i++)
+    {
+      insPtr->nodeptr[i].x = x[i];
+      insPtr->nodeptr[i].y = y[i];
+      insPtr->nodeptr[i].prob = probability[i];
+      /* As in ptspls */
+      context->prob_vec[i] = GSL_MIN(probability[i],0.99);
+    }
+  set_distance_type(insPtr,edge_weight_type[type]);
+  if (distance_matrix_fits(insPtr,memory_budget))
+    insPtr->distance = compute_distances(insPtr);
+  context->has_instance = 1;
+  return ELS_OK;
+}
+
+
+ELS_status
+ELS_configure(ELS_context *context, const ELS_config *config)
+{
+  if (config->initialization < ELS_INIT_NI ||
+      config->initialization > ELS_INIT_SF ||
+      config->exploration < ELS_EXPLORATION_QNN ||
+      config->exploration > ELS_EXPLORATION_DT2)
+    return ELS_ERROR_CONFIGURATION;
+  if ((config->exploration == ELS_EXPLORATION_NN ||
+       config->exploration == ELS_EXPLORATION_QNN) &&
+      (config->neighbors < 1 || config->neighbors > ELS_MAX_NEIGHBORS))
+    return ELS_ERROR_CONFIGURATION;
+  if (config->exploration == ELS_EXPLORATION_QNN && config->neighbors%4 != 0)
+    return ELS_ERROR_CONFIGURATION;
+  if (config->realizations < 1 || config->realizations > ELS_MAX_REALIZATIONS ||
+      config->sampling_type < 0 || config->sampling_type > 2)
+    return ELS_ERROR_CONFIGURATION;
+  if (config->sampling_type > 0 && LSA_alpha_index(config->alpha) < 0)
+    return ELS_ERROR_CONFIGURATION;
+  if (config->importance_sampling < 0 || config->importance_sampling > 1 ||
+      !(config->delta_probability >= 0.0 && config->delta_probability <= 1.0) ||
+      !(config->delta_dash_probability >= 0.0 && config->delta_dash_probability <= 1.0) ||
+      !(config->window_size >= 0.0 && config->window_size <= ELS_MAX_WINDOW_SIZE) ||
+      !(config->nodes >= 0.0 && config->nodes <= ELS_MAX_NODES))
+    return ELS_ERROR_CONFIGURATION;
+  if (config->evaluation_threads < 1 ||
+      config->evaluation_threads > ELS_MAX_EVALUATION_THREADS ||
+      config->evaluation_tolerance < 0)
+    return ELS_ERROR_CONFIGURATION;
+  if (config->realization_threads < 1 ||
+      config->realization_threads > ELS_MAX_EVALUATION_THREADS ||
+      config->realization_chunk < 1 || config->realization_chunk > ELS_MAX_REALIZATIONS)
+    return ELS_ERROR_CONFIGURATION;
+  if (config->steps < 0 || !(config->time >= 0.0))
+    return ELS_ERROR_CONFIGURATION;
+  context->config = *config;
+  return ELS_OK;
+}
+
+
+/* Called by the search after each step */
+static int
+ELS_report(void *data, int step)
+{
+  ELS_context *context = data;
+  const ELS_callbacks *callbacks = context->callbacks;
+  double time;
+
+  if (!context->config.time && !(callbacks && callbacks->step))
+    return 0;
+  time = ELS_clock() - context->start;
+  if (context->config.time && time >= context->config.time)
+    return 1;
+  return callbacks && callbacks->step &&
+         (*callbacks->step)(callbacks->data,step,time);
+}
+
+
+/* Neighbor lists of the exploration, as built by ptspls; 0 if the
+   cities cannot be triangulated */
+static int
+ELS_explore(ELS_context *context, LS_List *solPtr)
+{
+  problem *insPtr = &context->instance;
+
+  switch (context->config.exploration)
+    {
+    case ELS_EXPLORATION_QNN:
+      LS_solution_sort_quad_neighbors(insPtr,solPtr,context->config.neighbors);
+      break;
+    case ELS_EXPLORATION_NN:
+      LS_solution_sort_neighbors(solPtr,context->config.neighbors);
+      break;
+    case ELS_EXPLORATION_DT:
+      return LS_solution_sort_delaunay_neighbors(insPtr,solPtr,0);
+    case ELS_EXPLORATION_DT2:
+      return LS_solution_sort_delaunay_neighbors(insPtr,solPtr,1);
+    }
+  return 1;
+}
+
+
+ELS_status
+ELS_solve(ELS_context *context, const ELS_callbacks *callbacks)
+{
+  static LS_SOLUTION_INT *(*const heuristic[])(problem *) =
+    {nearestInsertion, farthestInsertion, nearestNeighbor, radialSort, spaceFilling};
+  problem *insPtr = &context->instance;
+  const ELS_config *config = &context->config;
+  LS_List solution;
+  struct LS_city *this;
+  int i, neighbors;
+
+  if (!context->has_instance)
+    return ELS_ERROR_NO_INSTANCE;
+  neighbors = (config->exploration == ELS_EXPLORATION_NN ||
+               config->exploration == ELS_EXPLORATION_QNN) ? config->neighbors : 0;
+  if (neighbors > insPtr->n-1)
+    return ELS_ERROR_CONFIGURATION;
+
+  context->callbacks = callbacks;
+  context->start = ELS_clock();
+
+  if (context->apriori_solution &&
+      context->apriori_initialization != config->initialization)
+    {
+      free(context->apriori_solution);
+      context->apriori_solution = NULL;
+    }
+  if (!context->apriori_solution)
+    {
+      context->apriori_solution = heuristic[config->initialization](insPtr);
+      context->apriori_initialization = config->initialization;
+    }
+
+  gsl_rng_set (context->R, config->seed);
+  solution = LS_solution_allocate(insPtr->n,config->realizations,
+                                  context->prob_vec,insPtr->distance,
+                                  config->alpha,config->importance_sampling,
+                                  config->delta_probability,
+                                  config->delta_dash_probability,
+                                  config->window_size,config->nodes);
+  LS_solution_set_instance(&solution,insPtr);
+  LS_resample_realizations(solution,context->R,config->sampling_type);
+  LS_solution_set(&solution,context->apriori_solution);
+  LS_solution_set_evaluation_threads(&solution,config->evaluation_threads,
+                                     config->evaluation_tolerance);
+  if (config->sampling_type == 1)
+    LSA_solution_set_realization_threads(&solution,config->realization_threads,
+                                         config->realization_chunk);
+
+  if (context->has_candidates &&
+      (context->candidates_exploration != config->exploration ||
+       context->candidates_neighbors != neighbors))
+    {
+      LS_candidates_free(&context->candidates);
+      context->has_candidates = 0;
+    }
+  if (context->has_candidates)
+    LS_solution_share_neighbors(&solution,&context->candidates);
+  else
+    {
+      if (!ELS_explore(context,&solution))
+        {
+          LS_solution_free(&solution);
+          context->callbacks = NULL;
+          return ELS_ERROR_INSTANCE;
+        }
+      context->candidates = LS_solution_save_neighbors(&solution);
+      context->candidates_exploration = config->exploration;
+      context->candidates_neighbors = neighbors;
+      context->has_candidates = 1;
+    }
+
+  solution.quiet = 1;
+  solution.report = ELS_report;
+  solution.report_data = context;
+  /* The time limit is checked by ELS_report, not by the stopwatch */
+  LS_2hnndlbfls_times(config->steps,&solution,context->R,0.0,0,
+                      config->sampling_type);
+
+  for (i=0,this=solution.first; i<insPtr->n; i++,this=LS_NEXT_CITY(&solution,this))
+    context->tour[i] = this->city;
+  context->has_tour = 1;
+  if (callbacks && callbacks->solution)
+    (*callbacks->solution)(callbacks->data,context->tour,insPtr->n,
+                           solution.no_steps,ELS_clock() - context->start);
+  LS_solution_free(&solution);
+  context->callbacks = NULL;
+  return ELS_OK;
+}
+
+
+const int *
+ELS_tour(const ELS_context *context)
+{
+  return context->has_tour ? context->tour : NULL;
+}
+
+
+const char *
+ELS_status_string(ELS_status status)
+{
+  switch (status)
+    {
+    case ELS_OK:
+      return "Success";
+    case ELS_ERROR_MEMORY:
+      return "Cannot allocate memory";
+    case ELS_ERROR_INSTANCE:
+      return "Illegal instance";
+    case ELS_ERROR_CONFIGURATION:
+      return "Illegal configuration";
+    case ELS_ERROR_NO_INSTANCE:
+      return "No instance has been given";
+    default:
+      return "Unknown status";
+    }
+}
@@ -0,0 +1,188 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    elsptsp.h
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Library interface of the estimation-based local search
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#ifndef ELS_PTSP
+#define ELS_PTSP
+
+#ifdef __cplusplus
+extern "C"
+  {
+#endif
+
+/* libelsptsp runs the local search of ptspls from within a program.
+   A context owns an instance, the configuration of the search, its
+   random number generator and the tour of the last search; what does
+   not depend on the seed (distance matrix, initial solution, neighbor
+   lists) is kept across the searches of a context. The library holds
+   no global state: distinct contexts can be used at the same time
+   from distinct threads, a context from one thread at a time. Nothing
+   is printed, illegal input is reported by the returned status, and
+   the process is only ended if memory cannot be allocated. */
+
+typedef enum
+  {
+    ELS_OK = 0,
+    ELS_ERROR_MEMORY,                /* the context cannot be allocated */
+    ELS_ERROR_INSTANCE,              /* illegal instance, or one whose
+                                        cities cannot be triangulated
+                                        by the Delaunay explorations */
+    ELS_ERROR_CONFIGURATION,         /* illegal configuration */
+    ELS_ERROR_NO_INSTANCE            /* no instance has been given */
+  }
+ELS_status;
+
+typedef enum
+  {
+    ELS_EUC_2D,
+    ELS_CEIL_2D,
+    ELS_GEO,
+    ELS_ATT
+  }
+ELS_distance_type;
+
+typedef enum
+  {
+    ELS_EXPLORATION_QNN,             /* quadrant-nearest-neighbor */
+    ELS_EXPLORATION_NN,              /* nearest-neighbor */
+    ELS_EXPLORATION_DT,              /* delaunay */
+    ELS_EXPLORATION_DT2              /* second-order-delaunay */
+  }
+ELS_exploration_type;
+
+typedef enum
+  {
+    ELS_INIT_NI,                     /* nearest insertion */
+    ELS_INIT_FI,                     /* farthest insertion */
+    ELS_INIT_NN,                     /* nearest neighbor */
+    ELS_INIT_RS,                     /* radial sort */
+    ELS_INIT_SF                      /* space filling */
+  }
+ELS_init_type;
+
+/* Parameters of a search, as the options of ptspls of the same name */
+typedef struct
+  {
+    ELS_init_type initialization;
+    ELS_exploration_type exploration;
+    int neighbors;                   /* ignored by the Delaunay explorations */
+    unsigned long int seed;
+    int realizations;
+    int sampling_type;               /* 0, 1 or 2 */
+    double alpha;                    /* 0.10, 0.05, 0.02 or 0.01 */
+    int importance_sampling;         /* 0 or 1 */
+    double delta_probability;
+    double delta_dash_probability;
+    double window_size;
+    double nodes;
+    int evaluation_threads;          /* 1 for evaluating on the calling
+                                        thread only */
+    int evaluation_tolerance;
+    int realization_threads;         /* only for sampling_type 1 */
+    int realization_chunk;
+    int steps;                       /* 0 for no limit */
+    double time;                     /* processor time of the calling
+                                        thread, in seconds; 0 for no limit */
+  }
+ELS_config;
+
+/* Functions called during a search, with data as first argument; any
+   of them can be NULL. */
+typedef struct
+  {
+    /* After each step, with the step and the time since the start of
+       the search; a nonzero value stops the search. */
+    int (*step)(void *data, int step, double time);
+    /* At the end of the search, with the tour of the n cities found
+       after the given number of steps; the tour is only valid during
+       the call, but is also kept by the context (ELS_tour). */
+    void (*solution)(void *data, const int *tour, int n, int steps,
+                     double time);
+    void *data;
+  }
+ELS_callbacks;
+
+typedef struct ELS_context ELS_context;
+
+/* The defaults of ptspls. */
+void
+ELS_config_default(ELS_config *config);
+
+ELS_status
+ELS_context_create(ELS_context **context);
+
+void
+ELS_context_free(ELS_context *context);
+
+/* Give the instance: n cities with their coordinates and their
+   probabilities, which are copied. The distance matrix is computed if
+   it does not take more than memory_budget megabytes. Anything kept
+   for the previous instance is released. */
+ELS_status
+ELS_set_instance(ELS_context *context, int n, const double *x,
+                 const double *y, const double *probability,
+                 ELS_distance_type type, double memory_budget);
+
+/* Check the configuration and keep it for the following searches. */
+ELS_status
+ELS_configure(ELS_context *context, const ELS_config *config);
+
+/* Run a search with the current configuration, its generator being
+   seeded with the seed of the configuration. ELS_ERROR_INSTANCE is
+   returned, and the tour of the last search kept, if the cities cannot
+   be triangulated for a Delaunay exploration. */
+ELS_status
+ELS_solve(ELS_context *context, const ELS_callbacks *callbacks);
+
+/* Tour of the last search, NULL if no search has been run. */
+const int *
+ELS_tour(const ELS_context *context);
+
+const char *
+ELS_status_string(ELS_status status);
+
+#ifdef __cplusplus
+  }
+#endif
+
+#endif /* ELS_PTSP */
@@ -0,0 +1,310 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    expectedCost.c
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Exact expected cost of an a priori tour, shared with the evaluator
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#include <stdlib.h>
+#include <error.h>
+
+#include "expectedCost.h"
+
+/* Sum of a[r]*b[r] for r from 0 to n-1, on independent partial sums so
+   that the products may be computed several at once */
+static double
+PTSP_dot(const double *a, const double *b, long int n)
+{
+  double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+  long int r;
+
+  for (r = 0; r + 4 <= n; r += 4)
+    {
+      s0 += a[r] * b[r];
+      s1 += a[r+1] * b[r+1];
+      s2 += a[r+2] * b[r+2];
+      s3 += a[r+3] * b[r+3];
+    }
+  for (; r < n; r++)
+    s0 += a[r] * b[r];
+  return (s0 + s1) + (s2 + s3);
+}
+
+/* PTSP_expected_cost with the same probability p for all the cities:
+   the product over the cities in between two others is absent[k], k
+   being their number */
+static double
+PTSP_homogeneous_expected_cost(long int n, const long int *tour, double p,
+                               PTSP_distance_row distance_row, void *data)
+{
+  double *absent, *row;
+  double cost = 0.0;
+  long int i, k;
+
+  absent = malloc(n*sizeof(double));
+  row = malloc(n*sizeof(double));
+  if (!absent || !row)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  absent[0] = 1.0;
+  for (k = 1; k < n; k++)
+    absent[k] = absent[k-1] * (1.0 - p);
+
+  for (i = 0; i < n; i++)
+    {
+      (*distance_row)(tour[i],tour,n,row,data);
+      /* Positions i+1 to n-1, then 0 to i-1 past the end of the tour */
+      cost += PTSP_dot(row+i+1,absent,n-i-1) + PTSP_dot(row,absent+n-i-1,i);
+    }
+
+  free(absent);
+  free(row);
+  return p * p * cost;
+}
+
+double
+PTSP_expected_cost(long int n, const long int *tour, const double *probability,
+                   PTSP_distance_row distance_row, void *data)
+{
+  double *present, *absent, *term;
+  double product, p, cost = 0.0;
+  long int i, r;
+
+  for (r = 1; r < n && probability[tour[r]] == probability[tour[0]]; r++)
+    ;
+  if (n > 0 && r == n)
+    return PTSP_homogeneous_expected_cost(n,tour,probability[tour[0]],
+                                          distance_row,data);
+
+  /* The probabilities in the order of the tour */
+  present = malloc(n*sizeof(double));
+  absent = malloc(n*sizeof(double));
+  term = malloc(n*sizeof(double));
+  if (!present || !absent || !term)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (r = 0; r < n; r++)
+    {
+      present[r] = probability[tour[r]];
+      absent[r] = 1.0 - present[r];
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      (*distance_row)(tour[i],tour,n,term,data);
+      p = present[i];
+
+      /* Product of the absence of the cities after i up to r-1,
+         running along the tour from i, wrapping around at n */
+      product = 1.0;
+      for (r = i+1; r < n; r++)
+        {
+          term[r] = term[r] * p * present[r] * product;
+          product *= absent[r];
+        }
+      for (r = 0; r < i; r++)
+        {
+          term[r] = term[r] * p * present[r] * product;
+          product *= absent[r];
+        }
+
+      /* Summed in the order of the positions, not from i */
+      for (r = 0; r < i; r++)
+        cost += term[r];
+      for (r = i+1; r < n; r++)
+        cost += term[r];
+    }
+
+  free(present);
+  free(absent);
+  free(term);
+  return cost;
+}
+
+
+/* Smallest window of the positions of tour out of which previous is the
+   same, once aligned so that tour[anchor] is at the same position and
+   read in the given direction (1 or -1); the positions are walked from
+   the anchor, so the window is the smallest one only if the anchor is
+   out of it. Returns its length, its first position in *first. */
+static long int
+PTSP_window(long int n, const long int *previous, const long int *position,
+            const long int *tour, long int anchor, int direction,
+            long int *first)
+{
+  long int k, r, step, begin = -1, end = -1;
+
+  r = position[tour[anchor]];
+  for (step = 1; step < n; step++)
+    {
+      k = anchor + step;
+      if (k >= n)
+        k -= n;
+      r += direction;
+      if (r == n)
+        r = 0;
+      else if (r < 0)
+        r = n - 1;
+      if (previous[r] != tour[k])
+        {
+          if (begin < 0)
+            begin = step;
+          end = step;
+        }
+    }
+  if (begin < 0)
+    return 0;
+  *first = (anchor + begin) % n;
+  return end - begin + 1;
+}
+
+/* Part of the expected cost of tour made by the pairs of cities with at
+   least one of them in the w positions from first, present[r] being the
+   probability of tour[r] */
+static double
+PTSP_window_cost(long int n, const long int *tour, const double *present,
+                 long int first, long int w, double *row,
+                 PTSP_distance_row distance_row, void *data)
+{
+  double product, p, cost = 0.0;
+  long int i, m, r, step;
+
+  for (m = 0; m < w; m++)
+    {
+      i = (first + m) % n;
+      (*distance_row)(tour[i],tour,n,row,data);
+      p = present[i];
+
+      /* Pairs from i to every other city */
+      product = 1.0;
+      for (step = 1, r = i; step < n; step++)
+        {
+          if (++r == n)
+            r = 0;
+          cost += row[r] * p * present[r] * product;
+          product *= 1.0 - present[r];
+        }
+
+      /* Pairs to i from the cities out of the window, whose terms are
+         not summed along their own row */
+      product = 1.0;
+      for (step = 1, r = i; step < n; step++)
+        {
+          if (--r < 0)
+            r = n - 1;
+          if ((r - first + n) % n >= w)
+            cost += row[r] * p * present[r] * product;
+          product *= 1.0 - present[r];
+        }
+    }
+  return cost;
+}
+
+
+int
+PTSP_expected_cost_change(long int n, const long int *previous,
+                          const long int *tour, const double *probability,
+                          PTSP_distance_row distance_row, void *data,
+                          double *change)
+{
+  long int *position, *aligned;
+  double *present, *row;
+  long int r, k, w, first, best = n, best_first = 0, best_anchor = 0;
+  int a, direction, best_direction = 1;
+
+  position = malloc(n*sizeof(long int));
+  if (!position)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (r = 0; r < n; r++)
+    position[previous[r]] = r;
+
+  /* A window shorter than n/2 cannot contain both anchors */
+  for (a = 0; a < 2; a++)
+    for (direction = 1; direction >= -1; direction -= 2)
+      {
+        w = PTSP_window(n,previous,position,tour,a*(n/2),direction,&first);
+        if (w < best)
+          {
+            best = w;
+            best_first = first;
+            best_anchor = a*(n/2);
+            best_direction = direction;
+          }
+      }
+
+  if (best == 0)
+    {
+      free(position);
+      *change = 0.0;
+      return 1;
+    }
+  if (2*best >= n)
+    {
+      free(position);
+      return 0;
+    }
+
+  /* previous, aligned on the positions of tour */
+  aligned = malloc(n*sizeof(long int));
+  present = malloc(2*n*sizeof(double));
+  row = malloc(n*sizeof(double));
+  if (!aligned || !present || !row)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  r = position[tour[best_anchor]];
+  for (k = 0; k < n; k++)
+    {
+      aligned[(best_anchor + k) % n] = previous[r];
+      r = (r + best_direction + n) % n;
+    }
+  for (r = 0; r < n; r++)
+    {
+      present[r] = probability[tour[r]];
+      present[n+r] = probability[aligned[r]];
+    }
+
+  *change = PTSP_window_cost(n,tour,present,best_first,best,row,
+                             distance_row,data)
+    - PTSP_window_cost(n,aligned,present+n,best_first,best,row,
+                       distance_row,data);
+
+  free(position);
+  free(aligned);
+  free(present);
+  free(row);
+  return 1;
+}
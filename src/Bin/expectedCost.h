@@ -0,0 +1,87 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    expectedCost.h
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Exact expected cost of an a priori tour, shared with the evaluator
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#ifndef PTSP_EXPECTED_COST
+#define PTSP_EXPECTED_COST
+
+/* As the parser, the computation does not depend on the data
+   structures of ptspls, so that the evaluator shares it. */
+
+/* Fill distance[r] with the distance from city to city tour[r], for r
+   from 0 to n-1 */
+typedef void
+(*PTSP_distance_row)(long int city, const long int *tour, long int n,
+                     double *distance, void *data);
+
+/* Expected length of the a priori tour visiting the n cities in the
+   order of tour, city i being present with probability probability[i]:
+   the sum over the pairs of cities of their distance, times the
+   probability that both are present and that all the cities between
+   them along the tour are absent. The time is O(n^2) and the memory
+   O(n): the distances are asked for a row at a time, with data as last
+   argument. The terms are summed in the same order as with the matrix
+   of the products of (1-p) formerly built by the evaluator, so that the
+   result is the same to the last bit, unless all the probabilities are
+   the same p: the cost is then the sum of the distances between the
+   cities k steps apart times p^2 (1-p)^(k-1), and each row is summed
+   as a dot product with these powers. */
+double
+PTSP_expected_cost(long int n, const long int *tour, const double *probability,
+                   PTSP_distance_row distance_row, void *data);
+
+/* Change of the expected cost from the tour previous to tour, computed
+   only for the pairs of cities whose contribution may differ: if both
+   tours are the same cycle outside a window of w consecutive positions,
+   possibly after a rotation or a reversal of one of them, the pairs
+   with no city in the window keep their terms. The time is O(w n), so
+   the change is computed only if w < n/2, the memory O(n). Returns 1
+   and sets *change if it has been computed, 0 if the tours differ too
+   much and the cost has to be computed from scratch. */
+int
+PTSP_expected_cost_change(long int n, const long int *previous,
+                          const long int *tour, const double *probability,
+                          PTSP_distance_row distance_row, void *data,
+                          double *change);
+
+#endif /* PTSP_EXPECTED_COST */
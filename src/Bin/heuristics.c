@@ -79,7 +79,7 @@ static int DISTa[6][6] = {
 #else
 /* warning: this macro cannot be called twice in the same arithmetic
 * expression*/
-#define DIST(a,b) insPtr->distance[a][b]
+#define DIST(a,b) LS_INSTANCE_DIST(insPtr,a,b)
 #endif
 
 void printTour( long int *t )
@@ -184,9 +184,9 @@ LS_SOLUTION_INT *nearestNeighbor(problem *insPtr)
           if (!visited[j])
             {
               /*printf("From %ld to %d the tour lenght =%ld\n",this_city,j,insPtr.distance[this_city][j]);*/
-              if (insPtr->distance[this_city][j] < closest_distance)
+              if (LS_INSTANCE_DIST(insPtr,this_city,j) < closest_distance)
                 {
-                  closest_distance = insPtr->distance[this_city][j];
+                  closest_distance = LS_INSTANCE_DIST(insPtr,this_city,j);
                   closest_city = j;
                 }
             }
@@ -197,7 +197,7 @@ LS_SOLUTION_INT *nearestNeighbor(problem *insPtr)
 
 
 
-      tourlength+=insPtr->distance[this_city][closest_city];
+      tourlength+=LS_INSTANCE_DIST(insPtr,this_city,closest_city);
       tour[i]=closest_city;
       visited[closest_city] = TRUE;
       this_city = closest_city;
@@ -207,7 +207,7 @@ LS_SOLUTION_INT *nearestNeighbor(problem *insPtr)
 
   /* finish tour by returning to start */
 
-  tourlength+=insPtr->distance[this_city][start_city];
+  tourlength+=LS_INSTANCE_DIST(insPtr,this_city,start_city);
   //    tour[n]=0;
   checkTour(tour);
   /*printf("\nNearest Neighbour\n");
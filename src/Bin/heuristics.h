@@ -79,7 +79,6 @@ extern "C"
     void printTour( long int *t ) ;
     void compute_tour_length( long int *t ) ;
     void checkTour( long int *t ) ;
-    LS_SOLUTION_INT* (*initialSolution)(problem *);
     /* function to compute a solution using the nearest neighbor heuristic*/
     LS_SOLUTION_INT *nearestNeighbor(problem *insPtr);
     /* function to compute a solution using the space filling heuristic*/
@@ -0,0 +1,309 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    instanceCache.c
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Binary instance cache mapped in memory
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <error.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <gsl/gsl_math.h>
+
+#include "instanceCache.h"
+#include "readFile.h"
+#include "sampleLS.h"
+
+/* The matrix and the lists start on page boundaries */
+#define LS_CACHE_ALIGNMENT 4096
+#define LS_CACHE_ALIGN(offset,alignment) \
+  (((offset) + (alignment) - 1) / (alignment) * (alignment))
+
+
+uint32_t
+LS_cache_distance_flags(void)
+{
+  uint32_t flags = 0;
+
+  if ((LS_DISTANCE)0.5 == 0)
+    flags |= LS_CACHE_INTEGER_DISTANCE;
+#ifdef LS_DISTANCE_FULL_MATRIX
+  flags |= LS_CACHE_FULL_MATRIX;
+#endif
+  return flags;
+}
+
+
+long int
+LS_cache_dimension(FILE *file)
+{
+  LS_cache_header header;
+  long int n = -1;
+
+  if (fread(&header,sizeof(header),1,file) == 1 &&
+      memcmp(header.magic,LS_CACHE_MAGIC,sizeof(header.magic)) == 0)
+    n = header.n;
+  rewind(file);
+  return n;
+}
+
+
+static void
+LS_cache_put(FILE *file, const void *data, uint64_t size, uint64_t *offset)
+{
+  if (size && fwrite(data,size,1,file) != 1)
+    error(EXIT_FAILURE,errno,"Cannot write the instance cache");
+  *offset += size;
+}
+
+/* Zeros up to the offset where the next part starts */
+static void
+LS_cache_pad(FILE *file, uint64_t start, uint64_t *offset)
+{
+  for (; *offset < start; (*offset)++)
+    if (fputc(0,file) == EOF)
+      error(EXIT_FAILURE,errno,"Cannot write the instance cache");
+}
+
+void
+LS_cache_write(const char *name, const char *source, problem *insPtr,
+               int with_matrix, const int *kind, const int *nn,
+               int no_lists)
+{
+  LS_cache_header header;
+  char *path, *temporary;
+  FILE *file;
+  int fd, i, l, n = insPtr->n, nn_quad, length;
+  int *list;
+  mode_t mask;
+  uint64_t offset;
+  KD_tree tree;
+  KD_neighbor *nearest;
+
+  if (no_lists > LS_CACHE_MAX_LISTS)
+    error(EXIT_FAILURE,0,"At most %d neighbor lists can be cached",
+          LS_CACHE_MAX_LISTS);
+
+  memset(&header,0,sizeof(header));
+  memcpy(header.magic,LS_CACHE_MAGIC,sizeof(header.magic));
+  header.version = LS_CACHE_VERSION;
+  header.byte_order = LS_CACHE_BYTE_ORDER;
+  if (!LS_cache_hash_file(source,&header.source_hash,&header.source_size) ||
+      !(path = realpath(source,NULL)))
+    error(EXIT_FAILURE,errno,"Cannot read %s",source);
+  header.n = n;
+  snprintf(header.edge_weight_type,sizeof(header.edge_weight_type),"%.15s",
+           insPtr->edge_weight_type);
+
+  /* Layout of the file */
+  offset = sizeof(header);
+  header.source_offset = offset;
+  offset += strlen(path) + 1;
+  offset = LS_CACHE_ALIGN(offset,sizeof(double));
+  header.points_offset = offset;
+  offset += (uint64_t)n*sizeof(struct point);
+  if (with_matrix)
+    {
+      offset = LS_CACHE_ALIGN(offset,LS_CACHE_ALIGNMENT);
+      header.distance_offset = offset;
+      header.distance_size = sizeof(LS_DISTANCE);
+      header.distance_flags = LS_cache_distance_flags();
+      offset += LS_DISTANCE_MATRIX_SIZE(n)*sizeof(LS_DISTANCE);
+    }
+  header.no_lists = no_lists;
+  for (l = 0; l < no_lists; l++)
+    {
+      /* As LS_solution_sort_neighbors and
+         LS_solution_sort_quad_neighbors */
+      if (kind[l] == LS_CACHE_NN_LISTS)
+        length = GSL_MIN(nn[l],n);
+      else
+        length = 1 + GSL_MIN(4*(GSL_MIN(nn[l],n)/4),n-1);
+      offset = LS_CACHE_ALIGN(offset,LS_CACHE_ALIGNMENT);
+      header.list[l].kind = kind[l];
+      header.list[l].nn = nn[l];
+      header.list[l].length = length;
+      header.list[l].offset = offset;
+      offset += (uint64_t)n*length*sizeof(int);
+    }
+  header.file_size = offset;
+
+  /* Written aside and renamed, so that runs reading the cache never
+     see it half written */
+  temporary = malloc(strlen(name) + 8);
+  if (!temporary)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  sprintf(temporary,"%s.XXXXXX",name);
+  fd = mkstemp(temporary);
+  if (fd < 0 || !(file = fdopen(fd,"wb")))
+    error(EXIT_FAILURE,errno,"Cannot create %s",temporary);
+  mask = umask(0);
+  umask(mask);
+  fchmod(fd,0666 & ~mask);
+
+  offset = 0;
+  LS_cache_put(file,&header,sizeof(header),&offset);
+  LS_cache_put(file,path,strlen(path) + 1,&offset);
+  LS_cache_pad(file,header.points_offset,&offset);
+  LS_cache_put(file,insPtr->nodeptr,(uint64_t)n*sizeof(struct point),&offset);
+  if (with_matrix)
+    {
+      if (!insPtr->distance)
+        insPtr->distance = compute_distances(insPtr);
+      LS_cache_pad(file,header.distance_offset,&offset);
+      LS_cache_put(file,insPtr->distance,
+                   LS_DISTANCE_MATRIX_SIZE(n)*sizeof(LS_DISTANCE),&offset);
+    }
+
+  tree = KD_tree_build(insPtr);
+  nearest = malloc(n*sizeof(KD_neighbor));
+  if (!nearest)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (l = 0; l < no_lists; l++)
+    {
+      length = header.list[l].length;
+      nn_quad = GSL_MIN(nn[l],n)/4;
+      LS_cache_pad(file,header.list[l].offset,&offset);
+      for (i = 0; i < n; i++)
+        {
+          if (kind[l] == LS_CACHE_NN_LISTS)
+            list = LS_allocate_nearest_neighbors(&tree,i,length,nearest);
+          else
+            list = LS_allocate_sort_quad_neighbors(&tree,i,nn_quad,length);
+          LS_cache_put(file,list,length*sizeof(int),&offset);
+          free(list);
+        }
+    }
+  free(nearest);
+  KD_tree_free(&tree);
+
+  if (fclose(file) || rename(temporary,name))
+    error(EXIT_FAILURE,errno,"Cannot write %s",name);
+  free(temporary);
+  free(path);
+}
+
+
+int
+LS_cache_map(const char *name, problem *insPtr)
+{
+  const LS_cache_header *header = LS_cache_map_file(name);
+
+  if (!header)
+    return 0;
+  insPtr->cache = (void *)header;
+  insPtr->cache_size = header->file_size;
+  insPtr->n = header->n;
+  insPtr->nodeptr = (struct point *)((char *)insPtr->cache +
+                                     header->points_offset);
+  if (!set_distance_type(insPtr,header->edge_weight_type))
+    error(EXIT_FAILURE,0,"EDGE_WEIGHT_TYPE %s not implemented",
+          header->edge_weight_type);
+  insPtr->distance = NULL;
+  insPtr->distance_mapped_size = 0;
+  if (header->distance_offset &&
+      header->distance_size == sizeof(LS_DISTANCE) &&
+      header->distance_flags == LS_cache_distance_flags())
+    insPtr->distance = (LS_DISTANCE *)((char *)insPtr->cache +
+                                       header->distance_offset);
+  return 1;
+}
+
+
+const char *
+LS_cache_source(const problem *insPtr)
+{
+  return LS_cache_file_source(insPtr->cache);
+}
+
+
+int
+LS_cache_is_stale(const problem *insPtr)
+{
+  return LS_cache_file_is_stale(insPtr->cache);
+}
+
+
+const int *
+LS_cache_neighbors(const problem *insPtr, int kind, int nn, int *length)
+{
+  const LS_cache_header *header = insPtr->cache;
+  const int *list;
+  uint64_t i, entries;
+  uint32_t l;
+
+  if (!header)
+    return NULL;
+  for (l = 0; l < header->no_lists; l++)
+    if (header->list[l].kind == (uint32_t)kind &&
+        header->list[l].nn == (uint32_t)nn)
+      {
+        *length = header->list[l].length;
+        list = (const int *)((const char *)insPtr->cache +
+                             header->list[l].offset);
+        /* The header only locates the lists: the cities they hold are
+           checked before the search reads them as indices */
+        entries = header->n*header->list[l].length;
+        for (i = 0; i < entries; i++)
+          if (list[i] < 0 || list[i] >= insPtr->n)
+            error(EXIT_FAILURE,0,"Instance cache %s is corrupt: build it again",
+                  insPtr->name);
+        return list;
+      }
+  return NULL;
+}
+
+
+void
+LS_cache_unmap(problem *insPtr)
+{
+  char *begin = insPtr->cache;
+
+  if ((char *)insPtr->distance >= begin &&
+      (char *)insPtr->distance < begin + insPtr->cache_size)
+    insPtr->distance = NULL;
+  insPtr->nodeptr = NULL;
+  LS_cache_unmap_file(insPtr->cache);
+  insPtr->cache = NULL;
+  insPtr->cache_size = 0;
+}
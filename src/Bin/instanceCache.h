@@ -0,0 +1,99 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    instanceCache.h
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Binary instance cache mapped in memory
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#ifndef LS_INSTANCE_CACHE
+#define LS_INSTANCE_CACHE
+
+#include <stdio.h>
+#include "instanceCacheFile.h"
+#include "problemdataStructures.h"
+
+/* The instance cache as ptspls uses it; its format is described in
+   instanceCacheFile.h. */
+
+/* Flags of the distance matrix as this program stores it. */
+uint32_t
+LS_cache_distance_flags(void);
+
+/* Number of cities if the open file is an instance cache, -1
+   otherwise; the file is rewound. */
+long int
+LS_cache_dimension(FILE *file);
+
+/* Write the cache of the instance read from source: the distance
+   matrix if with_matrix, and the neighbor lists of the given kinds and
+   numbers of neighbors. The file is replaced atomically. */
+void
+LS_cache_write(const char *name, const char *source, problem *insPtr,
+               int with_matrix, const int *kind, const int *nn,
+               int no_lists);
+
+/* Map the instance cache in the instance, as read_ptsp would read the
+   PTSPLIB file. The matrix is used only if it has been stored as this
+   program stores it. Returns 0 if the file is not an instance cache;
+   see LS_cache_map_file for the caches that stop the program. */
+int
+LS_cache_map(const char *name, problem *insPtr);
+
+/* Whether the PTSPLIB file of the mapped cache has changed since the
+   cache was built; a file that is not there any more has not. */
+int
+LS_cache_is_stale(const problem *insPtr);
+
+/* Path of the PTSPLIB file of the mapped cache. */
+const char *
+LS_cache_source(const problem *insPtr);
+
+/* Neighbor lists of the given kind and number of neighbors in the
+   mapped cache, each of *length cities, or NULL if there are none.
+   Exits if a city of the lists is not one of the instance. */
+const int *
+LS_cache_neighbors(const problem *insPtr, int kind, int nn, int *length);
+
+/* Unmap the cache: the coordinates and the matrix it holds are no
+   longer available. */
+void
+LS_cache_unmap(problem *insPtr);
+
+#endif /* LS_INSTANCE_CACHE */
@@ -0,0 +1,206 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    instanceCacheFile.c
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Format of the instance cache shared with the evaluator
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <error.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "instanceCacheFile.h"
+
+#define LS_CACHE_BUFFER 65536
+
+/* 64-bit FNV-1a */
+#define LS_FNV_OFFSET 14695981039346656037ULL
+#define LS_FNV_PRIME 1099511628211ULL
+
+
+int
+LS_cache_hash_file(const char *name, uint64_t *hash, uint64_t *size)
+{
+  FILE *file = fopen(name,"rb");
+  unsigned char *buffer;
+  size_t i, got;
+  uint64_t h = LS_FNV_OFFSET, s = 0;
+
+  if (!file)
+    return 0;
+  buffer = malloc(LS_CACHE_BUFFER);
+  if (!buffer)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  while ((got = fread(buffer,1,LS_CACHE_BUFFER,file)) > 0)
+    {
+      for (i = 0; i < got; i++)
+        {
+          h ^= buffer[i];
+          h *= LS_FNV_PRIME;
+        }
+      s += got;
+    }
+  free(buffer);
+  fclose(file);
+  *hash = h;
+  *size = s;
+  return 1;
+}
+
+
+/* Whether count items of the given size, starting at offset, lie
+   after the header and within the file, aligned as their type */
+static int
+LS_cache_part_fits(const LS_cache_header *header, uint64_t offset,
+                   uint64_t count, uint64_t size, uint64_t alignment)
+{
+  return offset >= sizeof(LS_cache_header) &&
+         offset <= header->file_size &&
+         offset % alignment == 0 &&
+         count <= (header->file_size - offset) / size;
+}
+
+/* Whether the parts the header locates lie within the file. n is
+   checked first, so that the sizes of the parts cannot overflow. */
+static int
+LS_cache_header_is_valid(const LS_cache_header *header)
+{
+  uint64_t n = header->n, entries;
+  uint32_t l;
+
+  if (header->n < 1 || header->n > INT_MAX ||
+      !memchr(header->edge_weight_type,0,sizeof(header->edge_weight_type)) ||
+      !LS_cache_part_fits(header,header->source_offset,1,1,1) ||
+      !LS_cache_part_fits(header,header->points_offset,n,
+                          LS_CACHE_POINT_SIZE,sizeof(double)) ||
+      header->no_lists > LS_CACHE_MAX_LISTS)
+    return 0;
+
+  if (header->distance_offset)
+    {
+      entries = (header->distance_flags & LS_CACHE_FULL_MATRIX) ?
+                n*n : n*(n+1)/2;
+      if (header->distance_size == 0 ||
+          !LS_cache_part_fits(header,header->distance_offset,entries,
+                              header->distance_size,header->distance_size))
+        return 0;
+    }
+
+  for (l = 0; l < header->no_lists; l++)
+    if (header->list[l].length < 1 || header->list[l].length > n ||
+        !LS_cache_part_fits(header,header->list[l].offset,
+                            n*header->list[l].length,sizeof(int),sizeof(int)))
+      return 0;
+  return 1;
+}
+
+
+const LS_cache_header *
+LS_cache_map_file(const char *name)
+{
+  LS_cache_header header;
+  struct stat status;
+  const char *map, *source;
+  int fd = open(name,O_RDONLY);
+
+  if (fd < 0)
+    return NULL;
+  if (pread(fd,&header,sizeof(header),0) != sizeof(header) ||
+      memcmp(header.magic,LS_CACHE_MAGIC,sizeof(header.magic)) != 0)
+    {
+      close(fd);
+      return NULL;
+    }
+  if (header.byte_order != LS_CACHE_BYTE_ORDER ||
+      header.version != LS_CACHE_VERSION)
+    error(EXIT_FAILURE,0,"Instance cache %s has been built by another version "
+          "or on another machine: build it again",name);
+  if (fstat(fd,&status) || (uint64_t)status.st_size != header.file_size)
+    error(EXIT_FAILURE,0,"Instance cache %s is truncated",name);
+  if (!LS_cache_header_is_valid(&header))
+    error(EXIT_FAILURE,0,"Instance cache %s is corrupt: build it again",name);
+  map = mmap(NULL,header.file_size,PROT_READ,MAP_SHARED,fd,0);
+  close(fd);
+  if (map == MAP_FAILED)
+    error(EXIT_FAILURE,errno,"Cannot map %s",name);
+
+  /* The path of the instance ends within the file */
+  source = map + header.source_offset;
+  if (!memchr(source,0,header.file_size - header.source_offset))
+    error(EXIT_FAILURE,0,"Instance cache %s is corrupt: build it again",name);
+  return (const LS_cache_header *)map;
+}
+
+
+const char *
+LS_cache_file_source(const LS_cache_header *header)
+{
+  return (const char *)header + header->source_offset;
+}
+
+
+int
+LS_cache_file_is_stale(const LS_cache_header *header)
+{
+  const char *source = LS_cache_file_source(header);
+  struct stat status;
+  uint64_t hash, size;
+
+  if (stat(source,&status))
+    return 0;
+  if ((uint64_t)status.st_size != header->source_size ||
+      !LS_cache_hash_file(source,&hash,&size))
+    return 1;
+  return hash != header->source_hash || size != header->source_size;
+}
+
+
+void
+LS_cache_unmap_file(const LS_cache_header *header)
+{
+  munmap((void *)header,header->file_size);
+}
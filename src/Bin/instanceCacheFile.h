@@ -0,0 +1,135 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    instanceCacheFile.h
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Format of the instance cache shared with the evaluator
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#ifndef LS_INSTANCE_CACHE_FILE
+#define LS_INSTANCE_CACHE_FILE
+
+#include <stdint.h>
+
+/* An instance cache holds, in one file that is mapped in memory
+   without copies, what ptspls otherwise computes from a PTSPLIB
+   instance at each run: coordinates and probabilities, the distance
+   matrix, and neighbor lists. It is built by ptspcache and given to
+   ptspls (or evaluate) in place of the instance. The file starts with
+   the header below; all the offsets are from the start of the file.
+   The FNV-1a hash of the PTSPLIB file is recorded, so that a cache
+   whose instance has changed is not used.
+
+   The format does not depend on the data structures of ptspls, so
+   that the evaluator shares it, and the mapping of the file, with
+   ptspls. */
+
+#define LS_CACHE_MAGIC "ELSPTSPC"
+#define LS_CACHE_VERSION 1
+#define LS_CACHE_BYTE_ORDER 0x01020304
+
+#define LS_CACHE_MAX_LISTS 16
+
+/* Kinds of neighbor lists */
+#define LS_CACHE_NN_LISTS 1     /* LS_solution_sort_neighbors */
+#define LS_CACHE_QNN_LISTS 2    /* LS_solution_sort_quad_neighbors */
+
+/* Flags describing the distance matrix */
+#define LS_CACHE_INTEGER_DISTANCE 1
+#define LS_CACHE_FULL_MATRIX 2
+
+/* The points are x, y and probability, the layout of an array of
+   struct point */
+#define LS_CACHE_POINT_SIZE (3*sizeof(double))
+
+typedef struct
+  {
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t file_size;
+    uint64_t source_hash;            /* FNV-1a hash of the PTSPLIB file */
+    uint64_t source_size;
+    uint64_t source_offset;          /* its path, NUL-terminated */
+    int64_t  n;
+    char     edge_weight_type[16];   /* NUL-terminated */
+    uint64_t points_offset;          /* n points */
+    uint64_t distance_offset;        /* 0 if there is no matrix */
+    uint32_t distance_size;          /* sizeof(LS_DISTANCE) */
+    uint32_t distance_flags;
+    uint32_t no_lists;
+    uint32_t reserved;
+    struct
+      {
+        uint32_t kind;
+        uint32_t nn;                 /* as given to ptspls */
+        uint64_t length;             /* cities in each list */
+        uint64_t offset;             /* n lists of int */
+      }
+    list[LS_CACHE_MAX_LISTS];
+  }
+LS_cache_header;
+
+/* Hash and size of a file; returns 0 if it cannot be read. */
+int
+LS_cache_hash_file(const char *name, uint64_t *hash, uint64_t *size);
+
+/* Map an instance cache in memory, read only, and return its header,
+   at the start of the mapping, or NULL if the file is not an instance
+   cache. The program stops if the cache has been built by another
+   version or on another machine, or if any part of it does not lie
+   within the file, so that the offsets of the header can be used as
+   they are. */
+const LS_cache_header *
+LS_cache_map_file(const char *name);
+
+/* Path of the PTSPLIB file of a mapped cache. */
+const char *
+LS_cache_file_source(const LS_cache_header *header);
+
+/* Whether the PTSPLIB file of a mapped cache has changed since the
+   cache was built; a file that is not there any more has not. */
+int
+LS_cache_file_is_stale(const LS_cache_header *header);
+
+/* Unmap a cache mapped by LS_cache_map_file. */
+void
+LS_cache_unmap_file(const LS_cache_header *header);
+
+#endif /* LS_INSTANCE_CACHE_FILE */
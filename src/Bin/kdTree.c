@@ -0,0 +1,317 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    kdTree.c
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: 2-d tree over the cities for building candidate lists
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#include <stdlib.h>
+#include <error.h>
+#include <gsl/gsl_math.h>
+
+#include "kdTree.h"
+
+/* Largest number of cities in a leaf */
+#define KD_BUCKET_SIZE 8
+
+#define KD_X(tree,c) ((tree)->insPtr->nodeptr[c].x)
+#define KD_Y(tree,c) ((tree)->insPtr->nodeptr[c].y)
+
+/* Search for the nearest cities of c */
+struct KD_query
+  {
+    const KD_tree *tree;
+    int c;
+    double x, y;
+    int k;
+    int quadrant;
+    KD_neighbor *nearest;
+    int found;
+  };
+
+
+static double
+KD_coordinate(const KD_tree *tree, int c, int axis)
+{
+  return axis ? KD_Y(tree,c) : KD_X(tree,c);
+}
+
+/* Reorder city[begin..end-1] so that the city in position middle has
+   the coordinate it would have if they were sorted along axis, with
+   no larger coordinates before it and no smaller ones after it */
+static void
+KD_select(KD_tree *tree, int begin, int end, int middle, int axis)
+{
+  int *city = tree->city;
+  int i, j, tmp;
+  double pivot;
+
+  while (end - begin > 1)
+    {
+      pivot = KD_coordinate(tree,city[begin + (end-begin)/2],axis);
+      i = begin;
+      j = end - 1;
+      while (i <= j)
+        {
+          while (KD_coordinate(tree,city[i],axis) < pivot)
+            i++;
+          while (KD_coordinate(tree,city[j],axis) > pivot)
+            j--;
+          if (i <= j)
+            {
+              tmp = city[i];
+              city[i] = city[j];
+              city[j] = tmp;
+              i++;
+              j--;
+            }
+        }
+      if (middle <= j)
+        end = j + 1;
+      else if (middle >= i)
+        begin = i;
+      else
+        return;
+    }
+}
+
+static int
+KD_build_node(KD_tree *tree, int begin, int end)
+{
+  int id = tree->no_nodes++;
+  struct KD_node *node = &tree->node[id];
+  int i, axis, middle;
+
+  node->begin = begin;
+  node->end = end;
+  node->lo_x = node->hi_x = KD_X(tree,tree->city[begin]);
+  node->lo_y = node->hi_y = KD_Y(tree,tree->city[begin]);
+  for (i = begin+1; i < end; i++)
+    {
+      node->lo_x = GSL_MIN(node->lo_x,KD_X(tree,tree->city[i]));
+      node->hi_x = GSL_MAX(node->hi_x,KD_X(tree,tree->city[i]));
+      node->lo_y = GSL_MIN(node->lo_y,KD_Y(tree,tree->city[i]));
+      node->hi_y = GSL_MAX(node->hi_y,KD_Y(tree,tree->city[i]));
+    }
+  node->left = node->right = -1;
+
+  if (end - begin <= KD_BUCKET_SIZE)
+    return id;
+
+  /* Split at the median of the longest side */
+  axis = (node->hi_y - node->lo_y > node->hi_x - node->lo_x);
+  middle = begin + (end-begin)/2;
+  KD_select(tree,begin,end,middle,axis);
+
+  tree->node[id].left = KD_build_node(tree,begin,middle);
+  tree->node[id].right = KD_build_node(tree,middle,end);
+  return id;
+}
+
+
+KD_tree
+KD_tree_build(problem *insPtr)
+{
+  KD_tree tree;
+  int i, n = insPtr->n;
+
+  tree.insPtr = insPtr;
+  tree.no_nodes = 0;
+  tree.city = malloc(n*sizeof(int));
+  tree.node = malloc(2*n*sizeof(struct KD_node));
+  if (!tree.city || !tree.node)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (i = 0; i < n; i++)
+    tree.city[i] = i;
+  KD_build_node(&tree,0,n);
+  return tree;
+}
+
+
+void
+KD_tree_free(KD_tree *tree)
+{
+  free(tree->city);
+  free(tree->node);
+  tree->city = NULL;
+  tree->node = NULL;
+}
+
+
+static int
+KD_in_quadrant(int quadrant, double x, double y, double cx, double cy)
+{
+  switch (quadrant)
+    {
+    case KD_QUADRANT_1:
+      return x > cx && y >= cy;
+    case KD_QUADRANT_2:
+      return x >= cx && y < cy;
+    case KD_QUADRANT_3:
+      return x < cx && y <= cy;
+    case KD_QUADRANT_4:
+      return x <= cx && y > cy;
+    default:
+      return 1;
+    }
+}
+
+/* Whether the bounding box of node may contain cities of the quadrant */
+static int
+KD_meets_quadrant(const struct KD_node *node, int quadrant, double cx, double cy)
+{
+  switch (quadrant)
+    {
+    case KD_QUADRANT_1:
+      return node->hi_x > cx && node->hi_y >= cy;
+    case KD_QUADRANT_2:
+      return node->hi_x >= cx && node->lo_y < cy;
+    case KD_QUADRANT_3:
+      return node->lo_x < cx && node->lo_y <= cy;
+    case KD_QUADRANT_4:
+      return node->lo_x <= cx && node->hi_y > cy;
+    default:
+      return 1;
+    }
+}
+
+/* Squared length from (x,y) to the bounding box of node. It is computed
+   as the distance functions compute xd*xd + yd*yd, and rounding is
+   monotone, so it is never larger than the one of a city in the box */
+static double
+KD_box_squared_length(const struct KD_node *node, double x, double y)
+{
+  double xd = 0.0, yd = 0.0;
+
+  if (x < node->lo_x)
+    xd = node->lo_x - x;
+  else if (x > node->hi_x)
+    xd = x - node->hi_x;
+  if (y < node->lo_y)
+    yd = node->lo_y - y;
+  else if (y > node->hi_y)
+    yd = y - node->hi_y;
+  return xd*xd + yd*yd;
+}
+
+/* Insert city j at distance d in the list of the nearest cities,
+   ordered by distance and then by index */
+static void
+KD_insert(struct KD_query *q, int j, LS_DISTANCE d)
+{
+  int pos = q->found;
+
+  if (pos == q->k)
+    {
+      if (d > q->nearest[pos-1].distance ||
+          (d == q->nearest[pos-1].distance && j > q->nearest[pos-1].city))
+        return;
+      pos--;
+    }
+  else
+    q->found++;
+
+  while (pos > 0 &&
+         (d < q->nearest[pos-1].distance ||
+          (d == q->nearest[pos-1].distance && j < q->nearest[pos-1].city)))
+    {
+      q->nearest[pos] = q->nearest[pos-1];
+      pos--;
+    }
+  q->nearest[pos].city = j;
+  q->nearest[pos].distance = d;
+}
+
+static void
+KD_search(struct KD_query *q, int id)
+{
+  const KD_tree *tree = q->tree;
+  const struct KD_node *node = &tree->node[id];
+  LS_DISTANCE (*length_distance)(double) = tree->insPtr->length_distance;
+  int i, j, first, second;
+  double length_left, length_right;
+
+  if (!KD_meets_quadrant(node,q->quadrant,q->x,q->y))
+    return;
+  /* Cities in the box cannot come before the last one found */
+  if (q->found == q->k && length_distance &&
+      length_distance(KD_box_squared_length(node,q->x,q->y)) >
+      q->nearest[q->k-1].distance)
+    return;
+
+  if (node->left < 0)
+    {
+      for (i = node->begin; i < node->end; i++)
+        {
+          j = tree->city[i];
+          if (KD_in_quadrant(q->quadrant,KD_X(tree,j),KD_Y(tree,j),q->x,q->y))
+            KD_insert(q,j,LS_INSTANCE_DIST(tree->insPtr,q->c,j));
+        }
+      return;
+    }
+
+  /* Visit first the child closer to the city */
+  length_left = KD_box_squared_length(&tree->node[node->left],q->x,q->y);
+  length_right = KD_box_squared_length(&tree->node[node->right],q->x,q->y);
+  first = (length_left <= length_right) ? node->left : node->right;
+  second = (first == node->left) ? node->right : node->left;
+  KD_search(q,first);
+  KD_search(q,second);
+}
+
+
+int
+KD_tree_nearest(const KD_tree *tree, int c, int k, int quadrant,
+                KD_neighbor *nearest)
+{
+  struct KD_query q;
+
+  q.tree = tree;
+  q.c = c;
+  q.x = KD_X(tree,c);
+  q.y = KD_Y(tree,c);
+  q.k = k;
+  q.quadrant = quadrant;
+  q.nearest = nearest;
+  q.found = 0;
+  if (k > 0)
+    KD_search(&q,0);
+  return q.found;
+}
@@ -0,0 +1,102 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    kdTree.h
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: 2-d tree over the cities for building candidate lists
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#ifndef KD_TREE
+#define KD_TREE
+
+#include "problemdataStructures.h"
+
+/* Quadrants of a city c for KD_tree_nearest: the quadrant of a city j
+   is given by the position of j with respect to c, the axes being
+   assigned as follows; a city at the same position as c lies in no
+   quadrant. */
+#define KD_ALL_QUADRANTS 0
+#define KD_QUADRANT_1 1     /* x >  c.x and y >= c.y */
+#define KD_QUADRANT_2 2     /* x >= c.x and y <  c.y */
+#define KD_QUADRANT_3 3     /* x <  c.x and y <= c.y */
+#define KD_QUADRANT_4 4     /* x <= c.x and y >  c.y */
+
+typedef struct
+  {
+    int city;
+    LS_DISTANCE distance;
+  }
+KD_neighbor;
+
+struct KD_node
+  {
+    double lo_x, hi_x, lo_y, hi_y;   /* bounding box of the cities */
+    int begin, end;                  /* cities in tree->city[begin..end-1] */
+    int left, right;                 /* children, -1 for a leaf */
+  };
+
+typedef struct
+  {
+    problem *insPtr;
+    int no_nodes;
+    int *city;
+    struct KD_node *node;            /* node 0 is the root */
+  }
+KD_tree;
+
+/* Build the tree over the cities of the instance. */
+KD_tree
+KD_tree_build(problem *insPtr);
+
+void
+KD_tree_free(KD_tree *tree);
+
+/* Find the k cities closest to city c in the given quadrant (or in all
+   of them), c itself included when searching all quadrants. They are
+   stored in nearest ordered by distance, then by index, the order in
+   which a stable sort of the distances from c would give them; the
+   function returns how many were found. Distances are those of
+   LS_INSTANCE_DIST. Regions of the plane are pruned through the
+   length_distance of the instance; without it, as for GEO, all the
+   cities are examined. */
+int
+KD_tree_nearest(const KD_tree *tree, int c, int k, int quadrant,
+                KD_neighbor *nearest);
+
+#endif /* KD_TREE */
@@ -46,6 +46,9 @@
 
 
 
+#include <stddef.h>
+#include "triangularIndex.h"
+
 #define LINE_BUF_LEN 100
 
 #if defined(LS_DISTANCE_LONGINT) && defined(LS_DISTANCE_DOUBLE)
@@ -63,6 +66,19 @@
 #ifndef P_DATA_STRUCTURES
 #define P_DATA_STRUCTURES
 
+/* All distances are symmetric: only the lower triangle of the matrix,
+   diagonal included, is stored row after row, and LS_DISTANCE_INDEX
+   gives the position of the distance between cities i and j in a
+   matrix of n cities. With -DLS_DISTANCE_FULL_MATRIX the whole matrix
+   is stored instead. */
+#ifdef LS_DISTANCE_FULL_MATRIX
+#  define LS_DISTANCE_INDEX(i,j,n) ((size_t)(i)*(n)+(j))
+#  define LS_DISTANCE_MATRIX_SIZE(n) ((size_t)(n)*(n))
+#else
+#  define LS_DISTANCE_INDEX(i,j,n) LS_triangular_index((i),(j))
+#  define LS_DISTANCE_MATRIX_SIZE(n) ((size_t)(n)*((n)+1)/2)
+#endif
+
 struct point
   {
     double x;
@@ -70,17 +86,36 @@ struct point
     double prob;
   };
 
-typedef struct
+typedef struct problem
   {
     char*         name;      	 /* instance name */
     char         edge_weight_type[LINE_BUF_LEN];  /* selfexplanatory */
     long int      n;                      /* number of cities */
     struct point  *nodeptr;               /* array of structs containing coordinates of nodes */
-    LS_DISTANCE      **distance;	        	/* distance matrix: distance[i][j] gives distance
-        													   between city i und j */
+    LS_DISTANCE      *distance;	        	/* distance matrix: distance[LS_DISTANCE_INDEX(i,j,n)]
+        													   gives distance between city i und j */
+    size_t        distance_mapped_size;   /* size of the matrix if it is memory mapped,
+                                               0 if it is allocated on the heap */
+    LS_DISTANCE   (*distance_function)(long int i, long int j, struct problem *insPtr);
+                                          /* computes the distance from the coordinates,
+                                             used when no matrix has been computed */
+    LS_DISTANCE   (*length_distance)(double squared_length);
+                                          /* distance as a non-decreasing function of
+                                             the squared Euclidean length, NULL if the
+                                             distance is not Euclidean (GEO) */
+    void          *cache;                 /* instance cache mapped in memory, which
+                                             nodeptr and possibly distance point
+                                             into; NULL for a PTSPLIB file */
+    size_t        cache_size;
   }
 problem;
 
+/* Distance between cities a and b: read from the matrix if it has
+   been computed, computed from the coordinates otherwise */
+#define LS_INSTANCE_DIST(insPtr,a,b) \
+  ((insPtr)->distance ? (insPtr)->distance[LS_DISTANCE_INDEX((a),(b),(insPtr)->n)] \
+                      : (insPtr)->distance_function((a),(b),(insPtr)))
+
 
 #endif
 
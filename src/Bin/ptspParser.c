@@ -0,0 +1,536 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    ptspParser.c
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Parser of PTSPLIB instances shared with the evaluator
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <limits.h>
+#include <errno.h>
+#include <error.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "ptspParser.h"
+
+#define PTSP_COORD_SECTION "NODE_COORD_SECTION"
+
+/* Tokens longer than this are converted from a copy on the heap */
+#define PTSP_TOKEN_LEN 64
+
+/* Decimal numbers with at most this many significant digits and a
+   power of ten in [-PTSP_MAX_POWER,PTSP_MAX_POWER] are exactly
+   representable as the quotient or the product of two doubles that
+   are themselves exact: the conversion then needs a single rounding,
+   and is the one strtod would give */
+#define PTSP_MAX_DIGITS 15
+#define PTSP_MAX_POWER 22
+
+static const double PTSP_power[PTSP_MAX_POWER+1] =
+  {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+/* Text of an instance: the mapped file, or the inflated one */
+struct PTSP_text
+  {
+    const char *begin, *end;
+    void *map;
+    size_t map_size;
+    char *inflated;
+  };
+
+struct PTSP_scanner
+  {
+    const char *file_name;
+    const char *begin, *p, *end;
+  };
+
+
+/* Space, or one of \t, \n, \v, \f and \r */
+static int
+PTSP_is_space(char c)
+{
+  return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t';
+}
+
+static int
+PTSP_is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+static long int
+PTSP_line(const struct PTSP_scanner *s)
+{
+  const char *p = s->begin;
+  long int line = 1;
+
+  while ((p = memchr(p,'\n',s->p - p)) != NULL)
+    {
+      p++;
+      line++;
+    }
+  return line;
+}
+
+static int
+PTSP_contains(const char *begin, const char *end, const char *word)
+{
+  size_t length = strlen(word);
+
+  while (end - begin >= (ptrdiff_t)length &&
+         (begin = memchr(begin,word[0],end - begin - length + 1)) != NULL)
+    {
+      if (memcmp(begin,word,length) == 0)
+        return 1;
+      begin++;
+    }
+  return 0;
+}
+
+
+/* Inflate a gzip stream; with header_only, stop once the coordinates
+   are reached */
+static char *
+PTSP_inflate(const char *file_name, const unsigned char *data, size_t size,
+             int header_only, size_t *length)
+{
+  z_stream z;
+  size_t capacity = 2*size + 65536, used = 0, before, left = size;
+  char *out = malloc(capacity);
+  int ret;
+
+  if (!out)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  memset(&z,0,sizeof(z));
+  if (inflateInit2(&z,15+32) != Z_OK)
+    error(EXIT_FAILURE,0,"Cannot inflate %s",file_name);
+  z.next_in = (unsigned char *)data;
+  for (;;)
+    {
+      if (used == capacity)
+        {
+          capacity *= 2;
+          if (!(out = realloc(out,capacity)))
+            error(EXIT_FAILURE,0,"Cannot allocate memory");
+        }
+      if (z.avail_in == 0)
+        {
+          z.avail_in = left < UINT_MAX ? left : UINT_MAX;
+          left -= z.avail_in;
+        }
+      z.next_out = (unsigned char *)out + used;
+      z.avail_out = capacity - used < UINT_MAX ? capacity - used : UINT_MAX;
+      before = used;
+      ret = inflate(&z,Z_NO_FLUSH);
+      used += (char *)z.next_out - (out + used);
+      if (ret == Z_STREAM_END)
+        {
+          /* Another member may follow, as after `cat a.gz b.gz' */
+          if ((z.avail_in == 0 && left == 0) ||
+              (z.avail_in > 0 && z.next_in[0] != 0x1f))
+            break;
+          inflateReset(&z);
+        }
+      else if (ret == Z_BUF_ERROR && z.avail_in == 0 && left == 0)
+        error(EXIT_FAILURE,0,"%s is truncated",file_name);
+      else if (ret != Z_OK && ret != Z_BUF_ERROR)
+        error(EXIT_FAILURE,0,"%s is corrupted: %s",file_name,
+              z.msg ? z.msg : "inflate failed");
+      if (header_only &&
+          PTSP_contains(out + (before > sizeof(PTSP_COORD_SECTION) ?
+                               before - sizeof(PTSP_COORD_SECTION) : 0),
+                        out + used,PTSP_COORD_SECTION))
+        break;
+    }
+  inflateEnd(&z);
+  *length = used;
+  return out;
+}
+
+/* Map the file and inflate it if it is compressed; returns 0 if it
+   cannot be read */
+static int
+PTSP_open(const char *file_name, struct PTSP_text *text, int header_only)
+{
+  struct stat status;
+  const unsigned char *data;
+  size_t length;
+  int fd = open(file_name,O_RDONLY);
+
+  memset(text,0,sizeof(*text));
+  if (fd < 0)
+    return 0;
+  if (fstat(fd,&status))
+    {
+      close(fd);
+      return 0;
+    }
+  text->map_size = status.st_size;
+  if (text->map_size > 0)
+    {
+      text->map = mmap(NULL,text->map_size,PROT_READ,MAP_PRIVATE,fd,0);
+      if (text->map == MAP_FAILED)
+        {
+          close(fd);
+          return 0;
+        }
+      madvise(text->map,text->map_size,MADV_SEQUENTIAL);
+    }
+  close(fd);
+
+  data = text->map;
+  if (text->map_size >= 2 && data[0] == 0x1f && data[1] == 0x8b)
+    {
+      text->inflated = PTSP_inflate(file_name,data,text->map_size,
+                                    header_only,&length);
+      munmap(text->map,text->map_size);
+      text->map = NULL;
+      text->begin = text->inflated;
+      text->end = text->inflated + length;
+    }
+  else
+    {
+      text->begin = text->map;
+      text->end = text->begin + text->map_size;
+    }
+  return 1;
+}
+
+static void
+PTSP_close(struct PTSP_text *text)
+{
+  if (text->map)
+    munmap(text->map,text->map_size);
+  free(text->inflated);
+}
+
+
+static void
+PTSP_skip_spaces(struct PTSP_scanner *s)
+{
+  while (s->p < s->end && PTSP_is_space(*s->p))
+    s->p++;
+}
+
+/* Blanks within a line */
+static void
+PTSP_skip_blanks(struct PTSP_scanner *s)
+{
+  while (s->p < s->end && (*s->p == ' ' || *s->p == '\t' || *s->p == '\r'))
+    s->p++;
+}
+
+static void
+PTSP_skip_line(struct PTSP_scanner *s)
+{
+  const char *newline = memchr(s->p,'\n',s->end - s->p);
+
+  s->p = newline ? newline + 1 : s->end;
+}
+
+/* The next token, of characters other than white space, and stop */
+static const char *
+PTSP_token(struct PTSP_scanner *s, const char **stop)
+{
+  const char *token;
+
+  PTSP_skip_spaces(s);
+  token = s->p;
+  while (s->p < s->end && !PTSP_is_space(*s->p))
+    s->p++;
+  *stop = s->p;
+  return token;
+}
+
+static int
+PTSP_is(const char *begin, const char *end, const char *word)
+{
+  size_t length = strlen(word);
+
+  return (size_t)(end - begin) == length && memcmp(begin,word,length) == 0;
+}
+
+/* Copy the first word of the value of a keyword */
+static void
+PTSP_copy_word(struct PTSP_scanner *s, char *word)
+{
+  const char *begin = s->p;
+  size_t length;
+
+  while (s->p < s->end && !PTSP_is_space(*s->p))
+    s->p++;
+  length = s->p - begin;
+  if (length > PTSP_NAME_LEN-1)
+    length = PTSP_NAME_LEN-1;
+  memcpy(word,begin,length);
+  word[length] = 0;
+}
+
+/* Convert the next token as strtod does, and move past it; returns 0
+   if it is not a number. Most numbers are converted in the same pass
+   that finds the end of the token. */
+static int
+PTSP_number(struct PTSP_scanner *s, double *value)
+{
+  const char *begin, *p, *end = s->end;
+  unsigned long long mantissa = 0;
+  int negative = 0, digits = 0, significant = 0, exponent = 0;
+  int exponent_sign = 1, exponent_value = 0, exponent_digits = 0;
+  char buffer[PTSP_TOKEN_LEN], *copy, *stop;
+  size_t length;
+  int converted;
+
+  PTSP_skip_spaces(s);
+  begin = p = s->p;
+  if (p < end && (*p == '-' || *p == '+'))
+    negative = (*p++ == '-');
+  for (; p < end && PTSP_is_digit(*p); p++, digits++)
+    if (mantissa || *p != '0')
+      {
+        if (significant++ < 19)
+          mantissa = 10*mantissa + (*p - '0');
+        else
+          exponent++;
+      }
+  if (p < end && *p == '.')
+    {
+      for (p++; p < end && PTSP_is_digit(*p); p++, digits++)
+        if (!mantissa && *p == '0')
+          exponent--;
+        else if (significant++ < 19)
+          {
+            mantissa = 10*mantissa + (*p - '0');
+            exponent--;
+          }
+    }
+  if (digits > 0 && p + 1 < end && (*p == 'e' || *p == 'E'))
+    {
+      p++;
+      if (*p == '-' || *p == '+')
+        exponent_sign = (*p++ == '-') ? -1 : 1;
+      for (; p < end && PTSP_is_digit(*p); p++, exponent_digits++)
+        if (exponent_value < 10000)
+          exponent_value = 10*exponent_value + (*p - '0');
+      exponent += exponent_sign*exponent_value;
+      if (!exponent_digits)
+        p = begin;
+    }
+
+  if (digits > 0 && (p == end || PTSP_is_space(*p)) &&
+      significant <= PTSP_MAX_DIGITS &&
+      exponent >= -PTSP_MAX_POWER && exponent <= PTSP_MAX_POWER)
+    {
+      *value = (double)mantissa;
+      if (exponent < 0)
+        *value /= PTSP_power[-exponent];
+      else
+        *value *= PTSP_power[exponent];
+      if (negative)
+        *value = -*value;
+      s->p = p;
+      return 1;
+    }
+
+  /* Long mantissas, large exponents, hexadecimal, infinities... */
+  for (p = begin; p < end && !PTSP_is_space(*p); p++)
+    ;
+  s->p = p;
+  length = p - begin;
+  copy = length < PTSP_TOKEN_LEN ? buffer : malloc(length+1);
+  if (!copy)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  memcpy(copy,begin,length);
+  copy[length] = 0;
+  *value = strtod(copy,&stop);
+  converted = (stop == copy + length && length > 0);
+  if (copy != buffer)
+    free(copy);
+  return converted;
+}
+
+static int
+PTSP_integer(const char *begin, const char *end, long int *value)
+{
+  const char *p = begin;
+  long int v = 0;
+
+  if (p < end && *p == '+')
+    p++;
+  if (p == end)
+    return 0;
+  for (; p < end; p++)
+    {
+      if (!PTSP_is_digit(*p) || v > (LONG_MAX - (*p - '0'))/10)
+        return 0;
+      v = 10*v + (*p - '0');
+    }
+  *value = v;
+  return 1;
+}
+
+/* Parse the keywords up to NODE_COORD_SECTION, or only up to DIMENSION
+   with dimension_only; returns 0 if the section is not found */
+static int
+PTSP_parse_header(struct PTSP_scanner *s, PTSP_instance *instance,
+                  int dimension_only)
+{
+  const char *keyword, *stop, *value;
+
+  instance->name[0] = 0;
+  instance->edge_weight_type[0] = 0;
+  instance->n = -1;
+  for (;;)
+    {
+      PTSP_skip_spaces(s);
+      if (s->p == s->end)
+        return 0;
+      keyword = s->p;
+      while (s->p < s->end && !PTSP_is_space(*s->p) && *s->p != ':')
+        s->p++;
+      stop = s->p;
+      if (PTSP_is(keyword,stop,PTSP_COORD_SECTION))
+        {
+          PTSP_skip_line(s);
+          return 1;
+        }
+      if (PTSP_is(keyword,stop,"EOF"))
+        return 0;
+      PTSP_skip_blanks(s);
+      if (s->p < s->end && *s->p == ':')
+        s->p++;
+      PTSP_skip_blanks(s);
+
+      if (PTSP_is(keyword,stop,"NAME"))
+        PTSP_copy_word(s,instance->name);
+      else if (PTSP_is(keyword,stop,"TYPE"))
+        {
+          value = s->p;
+          while (s->p < s->end && !PTSP_is_space(*s->p))
+            s->p++;
+          if (!dimension_only && !PTSP_is(value,s->p,"PTSP"))
+            error(EXIT_FAILURE,0,"%s:%ld: not a PTSP instance in TSPLIB format",
+                  s->file_name,PTSP_line(s));
+        }
+      else if (PTSP_is(keyword,stop,"DIMENSION"))
+        {
+          value = s->p;
+          while (s->p < s->end && !PTSP_is_space(*s->p))
+            s->p++;
+          /* A tour needs at least three cities */
+          if (!PTSP_integer(value,s->p,&instance->n) || instance->n < 3)
+            error(EXIT_FAILURE,0,"%s:%ld: illegal DIMENSION",
+                  s->file_name,PTSP_line(s));
+          if (dimension_only)
+            return 1;
+        }
+      else if (PTSP_is(keyword,stop,"EDGE_WEIGHT_TYPE"))
+        PTSP_copy_word(s,instance->edge_weight_type);
+      PTSP_skip_line(s);
+    }
+}
+
+
+void
+PTSP_read(const char *file_name, PTSP_instance *instance)
+{
+  struct PTSP_text text;
+  struct PTSP_scanner s;
+  const char *token, *stop;
+  double *nodes;
+  long int i;
+  int k;
+
+  if (!PTSP_open(file_name,&text,0))
+    error(EXIT_FAILURE,errno,"Cannot read instance file %s",file_name);
+  s.file_name = file_name;
+  s.begin = s.p = text.begin;
+  s.end = text.end;
+  if (!PTSP_parse_header(&s,instance,0))
+    error(EXIT_FAILURE,0,"%s: no " PTSP_COORD_SECTION,file_name);
+  if (instance->n < 0)
+    error(EXIT_FAILURE,0,"%s: no DIMENSION",file_name);
+
+  nodes = malloc(3*instance->n*sizeof(double));
+  if (!nodes)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  /* Each city is given by its index, which is not used, and by x, y
+     and its probability */
+  for (i = 0; i < instance->n; i++)
+    {
+      token = PTSP_token(&s,&stop);
+      if (token == stop)
+        error(EXIT_FAILURE,0,"%s: %ld cities instead of %ld",
+              file_name,i,instance->n);
+      for (k = 0; k < 3; k++)
+        if (!PTSP_number(&s,&nodes[3*i+k]))
+          error(EXIT_FAILURE,0,"%s:%ld: illegal coordinates of city %ld",
+                file_name,PTSP_line(&s),i+1);
+    }
+  instance->nodes = nodes;
+  PTSP_close(&text);
+}
+
+
+long int
+PTSP_dimension(const char *file_name)
+{
+  struct PTSP_text text;
+  struct PTSP_scanner s;
+  PTSP_instance instance;
+
+  if (!PTSP_open(file_name,&text,1))
+    return -1;
+  s.file_name = file_name;
+  s.begin = s.p = text.begin;
+  s.end = text.end;
+  PTSP_parse_header(&s,&instance,1);
+  PTSP_close(&text);
+  return instance.n;
+}
@@ -0,0 +1,77 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    ptspParser.h
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Parser of PTSPLIB instances shared with the evaluator
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#ifndef PTSP_PARSER
+#define PTSP_PARSER
+
+/* The parser does not depend on the data structures of ptspls, so
+   that the evaluator shares it. */
+
+#define PTSP_NAME_LEN 100
+
+typedef struct
+  {
+    char      name[PTSP_NAME_LEN];              /* NAME, possibly truncated */
+    char      edge_weight_type[PTSP_NAME_LEN];
+    long int  n;                                /* DIMENSION */
+    double    *nodes;      /* x, y and probability of city i in
+                              nodes[3*i], nodes[3*i+1] and nodes[3*i+2]:
+                              the layout of an array of struct point */
+  }
+PTSP_instance;
+
+/* Read a PTSPLIB instance, possibly compressed with gzip. The file is
+   mapped in memory and parsed in place; nodes is allocated with malloc.
+   The program stops with a message pointing at the line at fault if the
+   file is not a PTSP instance. The type of the edge weights is not
+   checked. */
+void
+PTSP_read(const char *file_name, PTSP_instance *instance);
+
+/* DIMENSION of a PTSPLIB instance, possibly compressed with gzip, from
+   its header only; -1 if the file cannot be read or has none. */
+long int
+PTSP_dimension(const char *file_name);
+
+#endif /* PTSP_PARSER */
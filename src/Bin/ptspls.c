@@ -51,10 +51,15 @@
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_randist.h>
 #include <unistd.h>
+#include <pthread.h>
 
 #include "heuristics.h"
 #include "readFile.h"
+#include "ptspParser.h"
+#include "instanceCache.h"
 #include "sampleLS.h"
+#include "adaptiveSampling.h"
+#include "approximation.h"
 #include "stopwatch.h"
 
 #ifdef TESTLS_SOLUTION_LONGINT
@@ -81,7 +86,9 @@ typedef enum {LS_ESTIMATE,
               LS_APPROXIMATE} LS_APPROACH_TYPE;
 
 typedef enum {LS_NN_EXPLORATION,
-              LS_QNN_EXPLORATION} LS_EXPLORATION_TYPE;
+              LS_QNN_EXPLORATION,
+              LS_DT_EXPLORATION,
+              LS_DT2_EXPLORATION} LS_EXPLORATION_TYPE;
 
 typedef enum {LS_HOMOGENEOUS,
               LS_HETEROGENEOUS} LS_PROBLEM_TYPE;
@@ -94,12 +101,15 @@ typedef enum {LS_INIT_NI,
 
 #define LS_MAX_VERBOSE 3
 #define LS_MAX_VERBOSE_STRING "3"
+#define LS_MAX_DEPTH_STRING "1000"     /* LSX_MAX_DEPTH */
 
 #define LS_MAX_SEED ULONG_MAX
 #define LS_MAX_REALIZATIONS 10000
 #define LS_MAX_NEIGHBORS 1000
 #define LS_MAX_TIME 3153600.0
 #define LS_MAX_ITERATIONS INT_MAX
+#define LS_MAX_MEMORY_BUDGET 1048576.0
+#define LS_MAX_THREADS 1024
 
 #define LS_DEFAULT_SEED 0
 #define LS_DEFAULT_REALIZATIONS 5
@@ -114,12 +124,22 @@ typedef enum {LS_INIT_NI,
 #define LS_DEFAULT_DELTADASHPROB 0.57
 #define LS_DEFAULT_WINDOWSIZE 1.3
 #define LS_DEFAULT_NODES 10
+#define LS_DEFAULT_MEMORY_BUDGET 4096.0
+#define LS_DEFAULT_THREADS 1
+#define LS_DEFAULT_EVALUATION_THREADS 1
+#define LS_DEFAULT_EVALUATION_TOLERANCE 0
+#define LS_DEFAULT_REALIZATION_THREADS 1
+#define LS_DEFAULT_REALIZATION_CHUNK 16
+
+/* Realizations on which the searches of a multi-start run are compared */
+#define LS_MULTI_START_REALIZATIONS 1000
 
 #define LSOPTION_APPROACH_ESTIMATION "estimation"
 #define LSOPTION_APPROACH_APPROXIMATION "approximation"
 
 #define LSOPTION_ESTIMATION_FIXED "fixed-estimation"
 #define LSOPTION_ESTIMATION_ADAPTIVE_TYPE_1 "adaptive sampling by t-test"
+#define LSOPTION_ESTIMATION_ADAPTIVE_TYPE_2 "adaptive sampling by t-test on blocks of 64 realizations"
 
 #define LSOPTION_ESTIMATION_IMPSAMP_TYPE_0 "do not use importance sampling"
 #define LSOPTION_ESTIMATION_IMPSAMP_TYPE_1 "biasing only the nodes close to the exchange moves with respect to window size"
@@ -128,7 +148,16 @@ typedef enum {LS_INIT_NI,
 
 #define LSOPTION_EXPLORATION_QNN "quadrant-nearest-neighbor"
 #define LSOPTION_EXPLORATION_NN "nearest-neighbor"
+#define LSOPTION_EXPLORATION_DT "delaunay"
+#define LSOPTION_EXPLORATION_DT2 "second-order-delaunay"
+
+
+#define LSOPTION_NEIGHBORHOOD_TWO_H_OPT "2.5-opt"
+#define LSOPTION_NEIGHBORHOOD_OR_OPT "or-opt"
+#define LSOPTION_NEIGHBORHOOD_VARIABLE_DEPTH "variable-depth"
 
+#define LSOPTION_TOUR_ARRAY "array"
+#define LSOPTION_TOUR_TWO_LEVEL "two-level"
 
 #define LSOPTION_PROBLEM_HOMOGENEOUS "homogeneous"
 #define LSOPTION_PROBLEM_HETEROGENEOUS "heterogeneous"
@@ -155,6 +184,16 @@ typedef enum {LS_INIT_NI,
 #define LS_LONGOPTIONONLY_ESTIMATION_DELTA_DASH_PROB 6
 #define LS_LONGOPTIONONLY_ESTIMATION_WINDOW_SIZE 7
 #define LS_LONGOPTIONONLY_ESTIMATION_WINDOW_SIZE_NODES 8
+#define LS_LONGOPTIONONLY_MEMORY_BUDGET 9
+#define LS_LONGOPTIONONLY_BATCH 10
+#define LS_LONGOPTIONONLY_THREADS 11
+#define LS_LONGOPTIONONLY_EVALUATION_THREADS 12
+#define LS_LONGOPTIONONLY_EVALUATION_TOLERANCE 13
+#define LS_LONGOPTIONONLY_REALIZATION_THREADS 14
+#define LS_LONGOPTIONONLY_REALIZATION_CHUNK 15
+#define LS_LONGOPTIONONLY_APPROXIMATION_DEPTH 16
+#define LS_LONGOPTIONONLY_TOUR 17
+#define LS_LONGOPTIONONLY_SWEEP 18
 
 
 #define EITHER(a,b) "Either '" a  "' [default] or '" b "'"
@@ -168,6 +207,7 @@ typedef struct
     int is_exploration_nn;
     int is_exploration_exaustive;
     int is_approach_importance_sampling;
+    int is_importance_sampling_given;
   }
 LS_CHECK_TYPE;
 
@@ -178,7 +218,7 @@ const char *argp_program_bug_address = "<prasanna@iridia.ulb.ac.be,prasannapraka
 
 /* Program documentation. */
 static char doc[] = "ptspls -- Local search for the PTSP";
-static char args_doc[] = "INSTANCE";
+static char args_doc[] = "INSTANCE\n--batch=FILE";
 
 static struct argp_option options[] =
     {
@@ -207,26 +247,82 @@ static struct argp_option options[] =
        "The method to be used for exploring the neighborhood. One of "
        "'" LSOPTION_EXPLORATION_QNN "' (" LSOPTION_EXPLORATION_QNN ") [default], "
        "'" LSOPTION_EXPLORATION_NN "' (" LSOPTION_EXPLORATION_NN "), "
+       "'" LSOPTION_EXPLORATION_DT "' (" LSOPTION_EXPLORATION_DT "), or "
+       "'" LSOPTION_EXPLORATION_DT2 "' (" LSOPTION_EXPLORATION_DT2 ")"
       },
+      {"tour",
+       LS_LONGOPTIONONLY_TOUR,
+       "T",
+       0,
+       "The representation of the tour.  "
+       EITHER(LSOPTION_TOUR_ARRAY,LSOPTION_TOUR_TWO_LEVEL) ".  "
+       "The search is the same with both; the moves cost O(sqrt(n)) on the "
+       "two-level list instead of up to O(n), its steps through the tour being slower"},
+      {"neighborhood",
+       LS_LONGOPTIONONLY_NEIGHBORHOOD,
+       "N",
+       0,
+       "The neighborhood of the local search.  One of "
+       "'" LSOPTION_NEIGHBORHOOD_TWO_H_OPT "' [default], "
+       "'" LSOPTION_NEIGHBORHOOD_OR_OPT "', or "
+       "'" LSOPTION_NEIGHBORHOOD_VARIABLE_DEPTH "'.  "
+       "When no move of the first one improves around a city, the second one moves short segments "
+       "starting or ending at one of its neighbors next to it, in either orientation, estimated "
+       "without importance sampling, and the third one "
+       "looks for a chain of 2-exchange moves from it as the Lin-Kernighan heuristic does, "
+       "possibly starting with a 3-exchange that moves a segment, "
+       "estimated on the realizations as a whole.  "
+       "The last one not with --sweep nor more than one evaluation thread"},
+      {"sweep",
+       LS_LONGOPTIONONLY_SWEEP,
+       0,
+       0,
+       "In each step, look at all the cities whose don't look bit is not set against the same tour, "
+       "and make the improving moves found whose edges are left in the tour by those made before them "
+       "and which still improve on it, instead of only the first one.  "
+       "Not with more than one evaluation thread"},
       {"problem",
        'p',
        "P",
        0,
        "The kind of PTSP problem instance to be solved.  "
-       EITHER(LSOPTION_PROBLEM_HETEROGENEOUS,LSOPTION_PROBLEM_HOMOGENEOUS)},
+       EITHER(LSOPTION_PROBLEM_HETEROGENEOUS,LSOPTION_PROBLEM_HOMOGENEOUS) ".  "
+       "The moves of an instance whose cities have all the same probability "
+       "are evaluated by the approximation approach, unless options of the "
+       "estimation approach are given"},
+      {"memory-budget",
+       LS_LONGOPTIONONLY_MEMORY_BUDGET,
+       "MB",
+       0,
+       "Largest distance matrix, in megabytes, that is computed in advance [default 4096]. "
+       "For larger instances the distances are computed from the coordinates."},
       {"seed",
        's',
        "S",
        0,
        "Seed for initializing the random number generator"},
+      {"approach",
+       'a',
+       "A",
+       0,
+       "The approach for evaluating the moves.  "
+       EITHER(LSOPTION_APPROACH_ESTIMATION,LSOPTION_APPROACH_APPROXIMATION)},
+      {"depth",
+       LS_LONGOPTIONONLY_APPROXIMATION_DEPTH,
+       "D",
+       0,
+       "In the approximation approach, the largest number of steps along the tour between two cities "
+       "whose distance enters the delta of a move, at most " LS_MAX_DEPTH_STRING "; "
+       "0 [default] for leaving out the pairs of cities unlikely to be consecutive"},
 
       {"sampling",
        'k',
        "K",
        0,
        "The type of sampling to be used in the estimation approach: One of "
-       "'0' (" LSOPTION_ESTIMATION_FIXED ") , or "
-       "'1' (" LSOPTION_ESTIMATION_ADAPTIVE_TYPE_1 ") [default] " },
+       "'0' (" LSOPTION_ESTIMATION_FIXED ") , "
+       "'1' (" LSOPTION_ESTIMATION_ADAPTIVE_TYPE_1 ") [default], or "
+       "'2' (" LSOPTION_ESTIMATION_ADAPTIVE_TYPE_2 ")" },
       {"importance-sampling",
        LS_LONGOPTIONONLY_ESTIMATION_IMP_SAMPLING,
        "1",
@@ -245,7 +341,7 @@ static struct argp_option options[] =
        0,
        0,
        0,
-       "If --sampling=1" },
+       "If --sampling=1 or --sampling=2" },
       {"alpha",
        'c',
        "C",
@@ -285,7 +381,8 @@ static struct argp_option options[] =
        'n',
        "N",
        0,
-       "Number of neighbors in the nearest neighbor or quadrant-nearest-neighbor exploration. In the case of quadrant-nearest-neighbor this number must be a multiple of 4."},
+       "Number of neighbors in the nearest neighbor or quadrant-nearest-neighbor exploration. In the case of quadrant-nearest-neighbor this number must be a multiple of 4. "
+       "The Delaunay explorations take as many neighbors as the triangulation gives."},
       {0,
        0,
        0,
@@ -295,12 +392,70 @@ static struct argp_option options[] =
        't',
        "T",
        0.000000,
-       "Stop after T seconds"},
+       "Stop after the step during which T seconds are reached, "
+       "printing the final solution [default: 1]"},
       {"steps",
        LS_LONGOPTIONONLY_ITERATIONS,
        "N",
        0,
        "Stop after N steps"},
+      {0,
+       0,
+       0,
+       0,
+       "Multi-start"},
+      {"threads",
+       LS_LONGOPTIONONLY_THREADS,
+       "N",
+       0,
+       "Run N independent searches from the initial solution, one per thread, and report the one of lowest estimated cost [default 1]. "
+       "Each search has its own random numbers; they share the instance, its distances and its neighbor lists. "
+       "The time limit is that of each search: the processor time of the process is checked against N times T, "
+       "whatever its value. "
+       "The result depends only on the seed and on N, unless the searches are stopped by the time limit."},
+      {0,
+       0,
+       0,
+       0,
+       "Parallel evaluation"},
+      {"evaluation-threads",
+       LS_LONGOPTIONONLY_EVALUATION_THREADS,
+       "W",
+       0,
+       "Evaluate the moves from W cities at once on W threads in each step of the search [default 1]. "
+       "Without tolerance, the steps make the same moves as on a single thread. "
+       "The time limit counts the processor time of all the threads, whatever its value."},
+      {"evaluation-tolerance",
+       LS_LONGOPTIONONLY_EVALUATION_TOLERANCE,
+       "T",
+       0,
+       "With more than one evaluation thread, make in each step up to T improving moves besides the first one, "
+       "among those found at the same time and still improving on the tour left by the moves before them [default 0]"},
+      {"realization-threads",
+       LS_LONGOPTIONONLY_REALIZATION_THREADS,
+       "W",
+       0,
+       "With adaptive sampling of type 1, compute the deltas of a move on W threads, a chunk of realizations at once [default 1]. "
+       "The result is the same as on a single thread. "
+       "The time limit counts the processor time of all the threads, whatever its value."},
+      {"realization-chunk",
+       LS_LONGOPTIONONLY_REALIZATION_CHUNK,
+       "C",
+       0,
+       "Realizations in each chunk of --realization-threads [default 16]"},
+      {0,
+       0,
+       0,
+       0,
+       "Batch mode"},
+      {"batch",
+       LS_LONGOPTIONONLY_BATCH,
+       "FILE",
+       0,
+       "Run the jobs of FILE, one per line: an instance followed by options, which override those given on the command line; "
+       "empty lines and lines starting with '#' are skipped. "
+       "The instance, its distances and its neighbor lists are kept across consecutive jobs on the same instance. "
+       "A record is printed for each job: its number, instance and seed, followed by the last step as in a single run."},
       {0}
     };
 
@@ -317,8 +472,13 @@ struct arguments
     LS_APPROACH_TYPE approach;
     LS_EXPLORATION_TYPE exploration;
     LS_PROBLEM_TYPE problem;
+    int two_level;
+    int sweep;
+    int or_opt;
+    int variable_depth;
     unsigned long int seed;
     int realizations;
+    int depth;
     int sampling_type;
     int neighbors;
     double time;
@@ -329,6 +489,13 @@ struct arguments
     float deltaDashProb;
     float windowsize;
     float nodes;
+    double memory_budget;
+    int threads;
+    int evaluation_threads;
+    int evaluation_tolerance;
+    int realization_threads;
+    int realization_chunk;
+    char* batch_file_name;
   };
 
 static error_t
@@ -409,6 +576,18 @@ parse_opt (int key, char *arg, struct argp_state *state)
           check.is_exploration_qnn=1;
           arguments->exploration = LS_QNN_EXPLORATION;
         }
+      else if (strcmp(arg,LSOPTION_EXPLORATION_DT)==0)
+        {
+          if (check.is_exploration_nn || check.is_exploration_qnn)
+            argp_error(state,"Options are not consistent");
+          arguments->exploration = LS_DT_EXPLORATION;
+        }
+      else if (strcmp(arg,LSOPTION_EXPLORATION_DT2)==0)
+        {
+          if (check.is_exploration_nn || check.is_exploration_qnn)
+            argp_error(state,"Options are not consistent");
+          arguments->exploration = LS_DT2_EXPLORATION;
+        }
       else
         argp_error(state,
                    "Illegal argument '%s' for option '%s'",
@@ -471,6 +650,13 @@ parse_opt (int key, char *arg, struct argp_state *state)
         argp_error(state,"Illegal number of neighbors");
       break;
 
+    case LS_LONGOPTIONONLY_MEMORY_BUDGET:
+      arguments->memory_budget = atof(arg);
+      if (arguments->memory_budget<0.0 ||
+          arguments->memory_budget>LS_MAX_MEMORY_BUDGET)
+        argp_error(state,"Illegal memory budget");
+      break;
+
     case 't':
       arguments->time = atof(arg);
       if (arguments->time<0.00000 ||
@@ -489,6 +675,7 @@ parse_opt (int key, char *arg, struct argp_state *state)
       if (check.is_approach_approximation)
         argp_error(state,"Options are not consistent");
       check.is_approach_estimation=1;
+      check.is_importance_sampling_given=1;
       arguments->importance_sampling = atoi(arg);
       if (arguments->importance_sampling<0 ||
           arguments->importance_sampling>5)
@@ -541,6 +728,82 @@ parse_opt (int key, char *arg, struct argp_state *state)
         argp_error(state,"Illegal option for nodes percentage");
       break;
 
+    case LS_LONGOPTIONONLY_THREADS:
+      arguments->threads = atoi(arg);
+      if (arguments->threads<1 ||
+          arguments->threads>LS_MAX_THREADS)
+        argp_error(state,"Illegal number of threads");
+      break;
+
+    case LS_LONGOPTIONONLY_EVALUATION_THREADS:
+      arguments->evaluation_threads = atoi(arg);
+      if (arguments->evaluation_threads<1 ||
+          arguments->evaluation_threads>LS_MAX_THREADS)
+        argp_error(state,"Illegal number of evaluation threads");
+      break;
+
+    case LS_LONGOPTIONONLY_EVALUATION_TOLERANCE:
+      arguments->evaluation_tolerance = atoi(arg);
+      if (arguments->evaluation_tolerance<0)
+        argp_error(state,"Illegal evaluation tolerance");
+      break;
+
+    case LS_LONGOPTIONONLY_REALIZATION_THREADS:
+      arguments->realization_threads = atoi(arg);
+      if (arguments->realization_threads<1 ||
+          arguments->realization_threads>LS_MAX_THREADS)
+        argp_error(state,"Illegal number of realization threads");
+      break;
+
+    case LS_LONGOPTIONONLY_REALIZATION_CHUNK:
+      arguments->realization_chunk = atoi(arg);
+      if (arguments->realization_chunk<1 ||
+          arguments->realization_chunk>LS_MAX_REALIZATIONS)
+        argp_error(state,"Illegal realization chunk");
+      break;
+
+    case LS_LONGOPTIONONLY_TOUR:
+      if (strcmp(arg,LSOPTION_TOUR_ARRAY)==0)
+        arguments->two_level = 0;
+      else if (strcmp(arg,LSOPTION_TOUR_TWO_LEVEL)==0)
+        arguments->two_level = 1;
+      else
+        argp_error(state,
+                   "Illegal argument '%s' for option '%s'",
+                   arg, "tour");
+      break;
+
+    case LS_LONGOPTIONONLY_SWEEP:
+      arguments->sweep = 1;
+      break;
+
+    case LS_LONGOPTIONONLY_NEIGHBORHOOD:
+      arguments->or_opt = 0;
+      arguments->variable_depth = 0;
+      if (strcmp(arg,LSOPTION_NEIGHBORHOOD_OR_OPT)==0)
+        arguments->or_opt = 1;
+      else if (strcmp(arg,LSOPTION_NEIGHBORHOOD_VARIABLE_DEPTH)==0)
+        arguments->variable_depth = 1;
+      else if (strcmp(arg,LSOPTION_NEIGHBORHOOD_TWO_H_OPT)!=0)
+        argp_error(state,
+                   "Illegal argument '%s' for option '%s'",
+                   arg, "neighborhood");
+      break;
+
+    case LS_LONGOPTIONONLY_APPROXIMATION_DEPTH:
+      if (check.is_approach_estimation)
+        argp_error(state,"Options are not consistent");
+      check.is_approach_approximation=1;
+      arguments->depth = atoi(arg);
+      if (arguments->depth<0 ||
+          arguments->depth>LSX_MAX_DEPTH)
+        argp_error(state,"Illegal depth");
+      break;
+
+    case LS_LONGOPTIONONLY_BATCH:
+      arguments->batch_file_name = arg;
+      break;
+
     case ARGP_KEY_ARG:
       if (state->arg_num >=1)
         /* Too many arguments */
@@ -555,9 +818,18 @@ parse_opt (int key, char *arg, struct argp_state *state)
       break;
 
     case ARGP_KEY_END:
-      if (state->arg_num < 1)
+      if (state->arg_num < 1 && !arguments->batch_file_name)
         /* Not enough arguments */
         argp_error(state,"Instance file is missing");
+      if (state->arg_num >= 1 && arguments->batch_file_name)
+        argp_error(state,"An instance cannot be given with --batch");
+      if (arguments->problem == LS_HOMOGENEOUS && !check.is_approach_estimation)
+        arguments->approach = LS_APPROXIMATE;
+      if ((arguments->sweep || arguments->variable_depth) &&
+          arguments->evaluation_threads > 1)
+        argp_error(state,"Options are not consistent");
+      if (arguments->sweep && arguments->variable_depth)
+        argp_error(state,"Options are not consistent");
       break;
 
     default:
@@ -594,15 +866,12 @@ check_arguments(struct arguments arguments)
     error(EXIT_FAILURE,0,"No stopping criterion is given");
 
   /* read the number of cities from instance_file */
-  while (!feof(arguments.instance_file))
-    if (fscanf(arguments.instance_file,"DIMENSION : %d",&no_cities))
-      break;
-    else
-      fscanf(arguments.instance_file,"%*[^\n]\n");
-  if (feof(arguments.instance_file))
+  no_cities = LS_cache_dimension(arguments.instance_file);
+  if (no_cities < 0)
+    no_cities = PTSP_dimension(arguments.instance_file_name);
+  if (no_cities < 0)
     error(EXIT_FAILURE,0,
           "Error parsing instance file %s",arguments.instance_file_name);
-  rewind(arguments.instance_file);
 
 
 
@@ -610,13 +879,16 @@ check_arguments(struct arguments arguments)
     if (arguments.neighbors%4!=0)
       error(EXIT_FAILURE,0,"Illegal number of neighbours for quadrant-nearest-neighbor. It must be a multiple of 4. ");
 
-  if (arguments.neighbors>no_cities-1)
+  /* The Delaunay candidates do not depend on the number of neighbors */
+  if ((arguments.exploration==LS_NN_EXPLORATION ||
+       arguments.exploration==LS_QNN_EXPLORATION) &&
+      arguments.neighbors>no_cities-1)
     error(EXIT_FAILURE,0,"Illegal number of neighbors");
 
-  if (arguments.sampling_type>1)
+  if (arguments.sampling_type>2)
     error(EXIT_FAILURE,0,"Illegal sampling type for estimation");
 
-  if (arguments.alpha>20.0)
+  if (arguments.sampling_type>0 && LSA_alpha_index(arguments.alpha)<0)
     error(EXIT_FAILURE,0,"Illegal alpha for adaptive estimation");
 
   if(arguments.importance_sampling > 1)
@@ -630,6 +902,13 @@ check_arguments(struct arguments arguments)
     if (arguments.deltaDashProb<0.0 || arguments.deltaDashProb>1.0  )
       error(EXIT_FAILURE,0,"Illegal deltaDashProbability for importance sampling");
 
+  /* Weighting the realizations of the cities of a segment by their
+     likelihood ratios lets the t-test accept Or-opt moves that worsen
+     the tour: importance sampling is only used for the other moves */
+  if (arguments.or_opt && arguments.importance_sampling == 1 &&
+      check.is_importance_sampling_given)
+    error(0,0,"Warning: the Or-opt moves are estimated without importance sampling");
+
 }
 
 void
@@ -683,6 +962,12 @@ print_parameters(struct arguments arguments)
     case LS_NN_EXPLORATION:
       printf("%s\n",LSOPTION_EXPLORATION_NN);
       break;
+    case LS_DT_EXPLORATION:
+      printf("%s\n",LSOPTION_EXPLORATION_DT);
+      break;
+    case LS_DT2_EXPLORATION:
+      printf("%s\n",LSOPTION_EXPLORATION_DT2);
+      break;
     default:
       printf("??\n");
       error(EXIT_FAILURE,0,"Illegal exploration");
@@ -702,10 +987,22 @@ print_parameters(struct arguments arguments)
       error(EXIT_FAILURE,0,"Illegal problem type");
     }
 
+  printf("tour: %s\n",arguments.two_level ? LSOPTION_TOUR_TWO_LEVEL : LSOPTION_TOUR_ARRAY);
+
+  if (arguments.sweep)
+    printf("sweep: yes\n");
+
+  printf("neighborhood: %s\n",
+         arguments.or_opt ? LSOPTION_NEIGHBORHOOD_OR_OPT
+         : arguments.variable_depth ? LSOPTION_NEIGHBORHOOD_VARIABLE_DEPTH
+         : LSOPTION_NEIGHBORHOOD_TWO_H_OPT);
+
   printf("seed: %lu\n",arguments.seed);
 
   if (arguments.approach==LS_ESTIMATE)
     printf("realizations: %d\n",arguments.realizations);
+  else
+    printf("depth: %d\n",arguments.depth);
 
   if (arguments.exploration==LS_NN_EXPLORATION||arguments.exploration==LS_QNN_EXPLORATION)
     printf("neighbors: %d\n",arguments.neighbors);
@@ -732,20 +1029,537 @@ print_parameters(struct arguments arguments)
   if (arguments.windowsize)
     printf("windowsize: %f\n",arguments.windowsize);
 
+  printf("memory budget: %.0f MB\n",arguments.memory_budget);
+
+  if (arguments.threads>1)
+    printf("threads: %d\n",arguments.threads);
+
+  if (arguments.evaluation_threads>1)
+    printf("evaluation threads: %d\nevaluation tolerance: %d\n",
+           arguments.evaluation_threads,arguments.evaluation_tolerance);
+
+  if (arguments.realization_threads>1)
+    printf("realization threads: %d\nrealization chunk: %d\n",
+           arguments.realization_threads,arguments.realization_chunk);
+
   printf("verbose: %d\n",arguments.verbose);
 }
 
 
 void
 LS_instance_free(problem *insPtr)
+{
+  if (insPtr->cache)
+    LS_cache_unmap(insPtr);
+  free_distances(insPtr);
+  free(insPtr->nodeptr);
+}
+
+
+/* Read the instance, or map it if it is an instance cache, and compute
+   the distance matrix if it fits in the memory budget */
+void
+LS_instance_load(problem *insPtr, char *file_name, double memory_budget)
+{
+  insPtr->name=file_name;
+  if (LS_cache_map(file_name, insPtr))
+    {
+      if (LS_cache_is_stale(insPtr))
+        error(EXIT_FAILURE,0,"Instance cache %s is out of date with respect to %s",
+              file_name,LS_cache_source(insPtr));
+    }
+  else
+    insPtr->nodeptr=read_ptsp(file_name, insPtr);
+  /* A cached matrix is not computed but mapped, whatever its size */
+  if (!insPtr->distance &&
+      distance_matrix_fits(insPtr,memory_budget))
+    insPtr->distance=compute_distances(insPtr);
+}
+
+
+double *
+LS_probability_vector(const problem *insPtr)
+{
+  double *prob_vec = (double *) malloc(insPtr->n * sizeof(double));
+
+  if (!prob_vec)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for(int city=0; city<insPtr->n; city++)
+    {
+
+      if(insPtr->nodeptr[city].prob > 0.99)
+        prob_vec[city]=0.99;
+      else
+        prob_vec[city]=insPtr->nodeptr[city].prob;
+    }
+  return prob_vec;
+}
+
+
+long int *
+LS_initial_solution(LS_INIT_TYPE initialization, problem *insPtr)
+{
+  LS_SOLUTION_INT *(*heuristic)(problem *);
+
+  switch (initialization)
+    {
+    case LS_INIT_NI:
+      heuristic=nearestInsertion;
+      break;
+    case LS_INIT_FI:
+      heuristic=farthestInsertion;
+      break;
+    case LS_INIT_NN:
+      heuristic=nearestNeighbor;
+      break;
+    case LS_INIT_RS:
+      heuristic=radialSort;
+      break;
+    case LS_INIT_SF:
+      heuristic=spaceFilling;
+      break;
+    default:
+      printf("??\n");
+      error(EXIT_FAILURE,0,"Illegal initialization heuristic");
+    }
+  return heuristic(insPtr);
+}
+
+
+/* Type of sampling of the search: that of the estimation, or
+   LSX_SAMPLING_TYPE for the approximation */
+static int
+LS_search_sampling_type(struct arguments arguments)
+{
+  return (arguments.approach==LS_APPROXIMATE) ? LSX_SAMPLING_TYPE : arguments.sampling_type;
+}
+
+
+/* Solution starting from the apriori solution, with its realizations
+   drawn from R in the estimation approach; it has no neighbor lists
+   yet */
+LS_List
+LS_solution_start(struct arguments arguments, problem *insPtr,
+                  double *prob_vec, gsl_rng *R, long int *apriori_solution)
+{
+  LS_List solution;
+
+  solution = LS_solution_allocate(insPtr->n,
+                                  arguments.realizations,
+                                  prob_vec,
+                                  insPtr->distance,
+                                  arguments.alpha,
+                                  arguments.importance_sampling,
+                                  arguments.deltaProb,
+                                  arguments.deltaDashProb,
+                                  arguments.windowsize,
+                                  arguments.nodes
+                                 );
+  LS_solution_set_instance(&solution,insPtr);
+  solution.depth = arguments.depth;
+  /* Add realizations */
+  if (arguments.approach==LS_ESTIMATE)
+    LS_resample_realizations(solution,R,arguments.sampling_type);
+  else if (!LSX_solution_set_homogeneous(&solution) &&
+           arguments.problem==LS_HOMOGENEOUS)
+    error(EXIT_FAILURE,0,"The cities of %s have not all the same probability",
+          insPtr->name);
+
+
+  LS_solution_set(&solution,apriori_solution);
+  if (arguments.two_level)
+    LS_solution_set_two_level(&solution);
+  if (arguments.sweep)
+    LS_solution_set_sweep(&solution);
+  solution.or_opt = arguments.or_opt;
+  if (arguments.variable_depth)
+    LS_solution_set_variable_depth(&solution);
+  LS_solution_set_evaluation_threads(&solution,arguments.evaluation_threads,
+                                     arguments.evaluation_tolerance);
+  if (LS_search_sampling_type(arguments)==1)
+    LSA_solution_set_realization_threads(&solution,arguments.realization_threads,
+                                         arguments.realization_chunk);
+  return solution;
+}
+
+
+/* Build the neighbor lists of the exploration, unless the instance
+   cache holds them */
+void
+LS_solution_explore(struct arguments arguments, problem *insPtr,
+                    LS_List *solPtr)
+{
+  int no_neighbors=arguments.neighbors;
+  const int *cached_neighbors;
+  int length;
+
+  switch (arguments.exploration)
+    {
+    case LS_QNN_EXPLORATION:
+      cached_neighbors = LS_cache_neighbors(insPtr,LS_CACHE_QNN_LISTS,
+                                            no_neighbors,&length);
+      if (cached_neighbors)
+        LS_solution_copy_neighbors(solPtr,cached_neighbors,length);
+      else
+        LS_solution_sort_quad_neighbors(insPtr,solPtr,no_neighbors);
+      break;
+    case LS_NN_EXPLORATION:
+      cached_neighbors = LS_cache_neighbors(insPtr,LS_CACHE_NN_LISTS,
+                                            no_neighbors,&length);
+      if (cached_neighbors)
+        LS_solution_copy_neighbors(solPtr,cached_neighbors,length);
+      else
+        LS_solution_sort_neighbors(solPtr,no_neighbors);
+      break;
+    case LS_DT_EXPLORATION:
+      if (!LS_solution_sort_delaunay_neighbors(insPtr,solPtr,0))
+        error(EXIT_FAILURE,0,"Cannot triangulate the cities");
+      break;
+    case LS_DT2_EXPLORATION:
+      if (!LS_solution_sort_delaunay_neighbors(insPtr,solPtr,1))
+        error(EXIT_FAILURE,0,"Cannot triangulate the cities");
+      break;
+    default:
+      printf("??\n");
+      error(EXIT_FAILURE,0,"Illegal exploration");
+    }
+}
+
+
+/* One of the searches of a multi-start run */
+struct LS_start
+  {
+    struct arguments arguments;
+    problem *insPtr;
+    double *prob_vec;
+    long int *apriori_solution;
+    const LS_candidates *candidates;
+    unsigned long int seed;
+    double time;
+    LS_List solution;
+  };
+
+static void
+*LS_start_search(void *arg)
+{
+  struct LS_start *start = arg;
+  gsl_rng *R;
+
+  R = gsl_rng_alloc (gsl_rng_taus);
+  if (!R)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  gsl_rng_set (R, start->seed);
+  start->solution = LS_solution_start(start->arguments,start->insPtr,
+                                      start->prob_vec,R,
+                                      start->apriori_solution);
+  LS_solution_share_neighbors(&start->solution,start->candidates);
+  start->solution.quiet = 1;
+  LS_2hnndlbfls_times(start->arguments.iterations,&start->solution,R,
+                      start->time,start->arguments.verbose,
+                      LS_search_sampling_type(start->arguments));
+  gsl_rng_free(R);
+  return NULL;
+}
+
+
+/* Run arguments.threads independent searches from the apriori
+   solution, one per thread, and return the solution of lowest cost
+   estimated on common realizations; the others are freed. The first
+   search has the seed of the arguments, and is the search of a single
+   run; the seeds of the others, and of the realizations on which the
+   solutions are compared, are drawn from a generator seeded with it.
+   The returned solution shares the candidates, which have to outlive
+   it. The stopwatch measures the processor time of the whole process,
+   so that the time limit of each search is scaled by the number of
+   searches; it arms no timer, so that the scaled limit may be as long
+   as needed. */
+LS_List
+LS_multi_start(struct arguments arguments, problem *insPtr, double *prob_vec,
+               long int *apriori_solution, const LS_candidates *candidates)
+{
+  int k, best = 0, no_starts = arguments.threads;
+  struct LS_start *starts;
+  pthread_t *threads;
+  int *created;
+  double cost, best_cost = GSL_POSINF;
+  gsl_rng *S;
+  LS_List solution;
+
+  starts = malloc(no_starts*sizeof(struct LS_start));
+  threads = malloc(no_starts*sizeof(pthread_t));
+  created = malloc(no_starts*sizeof(int));
+  S = gsl_rng_alloc (gsl_rng_mt19937);
+  if (!starts || !threads || !created || !S)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  gsl_rng_set (S, (unsigned long int)arguments.seed);
+
+  for (k=0; k<no_starts; k++)
+    {
+      starts[k].arguments = arguments;
+      starts[k].insPtr = insPtr;
+      starts[k].prob_vec = prob_vec;
+      starts[k].apriori_solution = apriori_solution;
+      starts[k].candidates = candidates;
+      starts[k].seed = k ? gsl_rng_get(S) : arguments.seed;
+      starts[k].time = arguments.time*no_starts;
+    }
+  /* The calling thread runs the first search, and the searches of the
+     threads that could not be created */
+  for (k=1; k<no_starts; k++)
+    {
+      created[k] = !pthread_create(&threads[k], NULL, LS_start_search, &starts[k]);
+      if (!created[k])
+        LS_start_search(&starts[k]);
+    }
+  LS_start_search(&starts[0]);
+  for (k=1; k<no_starts; k++)
+    if (created[k])
+      pthread_join(threads[k], NULL);
+
+  /* Every solution is evaluated on the realizations of the same
+     generator state, ties going to the first search */
+  gsl_rng_set (S, gsl_rng_get(S));
+  for (k=0; k<no_starts; k++)
+    {
+      gsl_rng *E = gsl_rng_clone(S);
+
+      if (!E)
+        error(EXIT_FAILURE,0,"Cannot allocate memory");
+      cost = LS_solution_estimate_cost(starts[k].solution,E,
+                                       LS_MULTI_START_REALIZATIONS);
+      gsl_rng_free(E);
+      if (arguments.verbose)
+        printf("Start\t%d\tSeed\t%lu\tSteps\t%d\tEstimated_cost\t%.3f\n",
+               k+1,starts[k].seed,starts[k].solution.no_steps,cost);
+      if (cost < best_cost)
+        {
+          best_cost = cost;
+          best = k;
+        }
+    }
+  for (k=0; k<no_starts; k++)
+    if (k != best)
+      LS_solution_free(&starts[k].solution);
+
+  solution = starts[best].solution;
+  gsl_rng_free(S);
+  free(created);
+  free(threads);
+  free(starts);
+  return solution;
+}
+
+
+/* Neighbor lists of an exploration, kept across the jobs of a batch */
+struct LS_batch_lists
+  {
+    LS_EXPLORATION_TYPE exploration;
+    int neighbors;                   /* 0 for the Delaunay explorations */
+    LS_candidates candidates;
+  };
+
+/* Instance of the current jobs of a batch, with what does not depend
+   on the seed */
+struct LS_batch_instance
+  {
+    char *file_name;
+    problem instance;
+    double *prob_vec;
+    long int *apriori_solution[LS_INIT_SF+1];
+    struct LS_batch_lists *lists;
+    int no_lists;
+  };
+
+
+/* Position of the job being read, for the error messages */
+static const char *batch_label;
+
+static void
+LS_batch_print_label(void)
+{
+  fprintf(stderr,"%s: ",batch_label);
+}
+
+/* Parse the jobs of the batch file, each with the given arguments as
+   defaults, and check them all before any is run */
+struct arguments *
+LS_batch_read(struct arguments defaults, int *no_jobs)
+{
+  LS_CHECK_TYPE defaults_check = check;
+  struct arguments *jobs = NULL;
+  FILE *batch_file;
+  char *line = NULL, *token, *label;
+  char **job_argv = NULL;
+  size_t line_size = 0;
+  int job_argc, max_argc = 0, line_no = 0;
+
+  batch_file = fopen(defaults.batch_file_name,"r");
+  if (!batch_file)
+    error(EXIT_FAILURE,errno,"Cannot open %s for reading",defaults.batch_file_name);
+  *no_jobs = 0;
+  while (getline(&line,&line_size,batch_file) >= 0)
+    {
+      line_no++;
+      token = line + strspn(line," \t\r\n");
+      if (*token == 0 || *token == '#')
+        continue;
+
+      label = malloc(strlen(defaults.batch_file_name) + 3*sizeof(int) + 2);
+      if (!label)
+        error(EXIT_FAILURE,0,"Cannot allocate memory");
+      sprintf(label,"%s:%d",defaults.batch_file_name,line_no);
+      job_argc = 0;
+      for (token = strtok(line," \t\r\n"); ; token = strtok(NULL," \t\r\n"))
+        {
+          if (job_argc + 2 > max_argc)
+            {
+              max_argc = 2*max_argc + 8;
+              job_argv = realloc(job_argv,max_argc*sizeof(char *));
+              if (!job_argv)
+                error(EXIT_FAILURE,0,"Cannot allocate memory");
+            }
+          if (job_argc == 0)
+            job_argv[job_argc++] = label;
+          if (!token)
+            break;
+          job_argv[job_argc++] = token;
+        }
+      job_argv[job_argc] = NULL;
+
+      jobs = realloc(jobs,(*no_jobs+1)*sizeof(struct arguments));
+      if (!jobs)
+        error(EXIT_FAILURE,0,"Cannot allocate memory");
+      jobs[*no_jobs] = defaults;
+      jobs[*no_jobs].batch_file_name = NULL;
+      check = defaults_check;
+      /* Errors are reported with the position of the job, which argp
+         takes from job_argv[0] */
+      batch_label = label;
+      error_print_progname = LS_batch_print_label;
+      argp_parse (&argp, job_argc, job_argv, 0, 0, &jobs[*no_jobs]);
+      check_arguments(jobs[*no_jobs]);
+      error_print_progname = NULL;
+      fclose(jobs[*no_jobs].instance_file);
+      jobs[*no_jobs].instance_file = NULL;
+      (*no_jobs)++;
+      free(label);
+    }
+  fclose(batch_file);
+  free(line);
+  free(job_argv);
+  check = defaults_check;
+  return jobs;
+}
+
+
+void
+LS_batch_release(struct LS_batch_instance *batch)
 {
   int i;
-  for ( i= 0  ; i < insPtr->n ; i++ )
+
+  if (!batch->file_name)
+    return;
+  for (i=0; i<batch->no_lists; i++)
+    LS_candidates_free(&batch->lists[i].candidates);
+  free(batch->lists);
+  for (i=0; i<=LS_INIT_SF; i++)
+    free(batch->apriori_solution[i]);
+  free(batch->prob_vec);
+  LS_instance_free(&batch->instance);
+  memset(batch,0,sizeof(*batch));
+}
+
+
+/* Run the jobs of the batch file one after the other. The instance,
+   its distance matrix, its neighbor lists and its apriori solutions
+   are kept as long as consecutive jobs are on the same instance, the
+   matrix being computed with the memory budget of the first of them;
+   each job has its own generator, realizations and solution. */
+void
+LS_batch_run(struct arguments defaults)
+{
+  struct LS_batch_instance batch;
+  struct arguments *jobs, arguments;
+  struct LS_batch_lists *lists;
+  LS_List solution;
+  gsl_rng *R;
+  int no_jobs, k, l, neighbors;
+
+  jobs = LS_batch_read(defaults,&no_jobs);
+  memset(&batch,0,sizeof(batch));
+  R = gsl_rng_alloc (gsl_rng_taus);
+
+  for (k=0; k<no_jobs; k++)
     {
-      free(insPtr->distance[i]);
+      arguments = jobs[k];
+      if (arguments.verbose)
+        print_parameters(arguments);
+      /* The time and the time limit are those of the job */
+      stopwatch_start();
+
+      if (!batch.file_name ||
+          strcmp(batch.file_name,arguments.instance_file_name))
+        {
+          LS_batch_release(&batch);
+          batch.file_name = arguments.instance_file_name;
+          LS_instance_load(&batch.instance,batch.file_name,
+                           arguments.memory_budget);
+          batch.prob_vec = LS_probability_vector(&batch.instance);
+        }
+      if (!batch.apriori_solution[arguments.initialization])
+        batch.apriori_solution[arguments.initialization] =
+          LS_initial_solution(arguments.initialization,&batch.instance);
+
+      gsl_rng_set (R, (unsigned long int)arguments.seed);
+      solution = LS_solution_start(arguments,&batch.instance,batch.prob_vec,R,
+                                   batch.apriori_solution[arguments.initialization]);
+
+      neighbors = (arguments.exploration==LS_NN_EXPLORATION ||
+                   arguments.exploration==LS_QNN_EXPLORATION) ? arguments.neighbors : 0;
+      for (l=0; l<batch.no_lists; l++)
+        if (batch.lists[l].exploration==arguments.exploration &&
+            batch.lists[l].neighbors==neighbors)
+          break;
+      if (l<batch.no_lists)
+        LS_solution_share_neighbors(&solution,&batch.lists[l].candidates);
+      else
+        {
+          LS_solution_explore(arguments,&batch.instance,&solution);
+          lists = realloc(batch.lists,(batch.no_lists+1)*sizeof(struct LS_batch_lists));
+          if (!lists)
+            error(EXIT_FAILURE,0,"Cannot allocate memory");
+          batch.lists = lists;
+          batch.lists[l].exploration = arguments.exploration;
+          batch.lists[l].neighbors = neighbors;
+          batch.lists[l].candidates = LS_solution_save_neighbors(&solution);
+          batch.no_lists++;
+        }
+
+      if (arguments.threads>1)
+        {
+          LS_solution_free(&solution);
+          solution = LS_multi_start(arguments,&batch.instance,batch.prob_vec,
+                                    batch.apriori_solution[arguments.initialization],
+                                    &batch.lists[l].candidates);
+        }
+      else
+        {
+          solution.quiet = 1;
+          LS_2hnndlbfls_times(arguments.iterations,&solution,R,arguments.time,
+                              arguments.verbose,LS_search_sampling_type(arguments));
+        }
+      printf("Job\t%d\tInstance\t%s\tSeed\t%lu\t",
+             k+1,arguments.instance_file_name,arguments.seed);
+      LS_solution_log(solution,solution.no_steps);
+      fflush(stdout);
+      LS_solution_free(&solution);
     }
-  free(insPtr->distance);
-  free(insPtr->nodeptr);
+
+  LS_batch_release(&batch);
+  gsl_rng_free(R);
+  for (k=0; k<no_jobs; k++)
+    free(jobs[k].instance_file_name);
+  free(jobs);
 }
 
 
@@ -761,8 +1575,13 @@ main(int argc, char **argv)
         LS_ESTIMATE, /* approach */
         LS_QNN_EXPLORATION, /* exploration */
         LS_HETEROGENEOUS, /* problem */
+        0, /* two-level list */
+        0, /* sweep */
+        0, /* Or-opt */
+        0, /* variable depth */
         LS_DEFAULT_SEED, /* seed */
         LS_DEFAULT_REALIZATIONS, /* realizations */
+        LS_DEFAULT_DEPTH, /* depth */
         LS_DEFAULT_SAMPLING_TYPE,
         LS_DEFAULT_NEIGHBORS, /* neighbors */
         LS_DEFAULT_TIME, /* time */
@@ -772,13 +1591,28 @@ main(int argc, char **argv)
         LS_DEFAULT_DELTAPROB,
         LS_DEFAULT_DELTADASHPROB,
         LS_DEFAULT_WINDOWSIZE,
-        LS_DEFAULT_NODES
+        LS_DEFAULT_NODES,
+        LS_DEFAULT_MEMORY_BUDGET,
+        LS_DEFAULT_THREADS, /* threads */
+        LS_DEFAULT_EVALUATION_THREADS,
+        LS_DEFAULT_EVALUATION_TOLERANCE,
+        LS_DEFAULT_REALIZATION_THREADS,
+        LS_DEFAULT_REALIZATION_CHUNK,
+        NULL /* batch file name */
       };
 
   argp_parse (&argp, argc, argv, 0, 0, &arguments);
 
+  if (arguments.batch_file_name)
+    {
+      LS_batch_run(arguments);
+      exit(EXIT_SUCCESS);
+    }
+
   check_arguments(arguments);
-  stopwatch_start(arguments.time);
+  /* The searches check the time limit between steps, and print their
+     final solution when they reach it: the stopwatch only measures them */
+  stopwatch_start();
   //  printf("%f\n",arguments.time);
 
 
@@ -790,23 +1624,19 @@ main(int argc, char **argv)
 
   /* do the rest... */
   int no_steps = arguments.iterations;
-  int no_neighbors=arguments.neighbors;
   double time = arguments.time;
-  int no_realizations=arguments.realizations;
   problem instance;
   int no_cities,i;
   int sampling_type;
   double *prob_vec;
-  int homoflag;
 
   LS_List solution;
 
 
-  instance.name=arguments.instance_file_name;
-  instance.nodeptr=read_ptsp(arguments.instance_file_name, &instance);
-  instance.distance=compute_distances(&instance);
+  LS_instance_load(&instance,arguments.instance_file_name,
+                   arguments.memory_budget);
   no_cities=instance.n;
-  sampling_type=arguments.sampling_type;
+  sampling_type=LS_search_sampling_type(arguments);
 
 
 
@@ -816,75 +1646,10 @@ main(int argc, char **argv)
   R = gsl_rng_alloc (gsl_rng_taus);
   gsl_rng_set (R, (unsigned long int)arguments.seed);
 
-  prob_vec = (double *) malloc(no_cities * sizeof(double));
-  for(int city=0; city<no_cities; city++)
-    {
-
-      if(instance.nodeptr[city].prob > 0.99)
-        prob_vec[city]=0.99;
-      else
-        prob_vec[city]=instance.nodeptr[city].prob;
-    }
-
-
-
-
-  switch (arguments.initialization)
-    {
-    case LS_INIT_NI:
-      {
-        /*printf("%s\n",LSOPTION_INIT_NI);*/
-        initialSolution=nearestInsertion;
-      }
-      break;
-    case LS_INIT_FI:
-      {
-        /*printf("%s\n",LSOPTION_INIT_FI);*/
-        initialSolution=farthestInsertion;
-      }
-      break;
-    case LS_INIT_NN:
-      {
-        /*printf("%s\n",LSOPTION_INIT_NN);*/
-        initialSolution=nearestNeighbor;
-      }
-      break;
-    case LS_INIT_RS:
-      {
-        /*printf("%s\n",LSOPTION_INIT_RS);*/
-        initialSolution=radialSort;
-      }
-      break;
-    case LS_INIT_SF:
-      {
-        /*printf("%s\n",LSOPTION_INIT_SF);*/
-        initialSolution=spaceFilling;
-      }
-      break;
-    default:
-      printf("??\n");
-      error(EXIT_FAILURE,0,"Illegal initialization heuristic");
-    }
-
+  prob_vec = LS_probability_vector(&instance);
 
-  switch (arguments.problem)
-    {
-    case LS_HOMOGENEOUS:
-      {
-        homoflag=1;
-      }
-      break;
-    case LS_HETEROGENEOUS:
-      {
-        homoflag=0;
-      }
-      break;
-    default:
-      printf("??\n");
-      error(EXIT_FAILURE,0,"Illegal problem type");
-    }
 
-  long int* apriori_solution=initialSolution(&instance);
+  long int* apriori_solution=LS_initial_solution(arguments.initialization,&instance);
   printf("Step\t%3d\t",0);
   printf("Total_Time\t%5.8f\t", 0.00001);
   printf("Tour\t");
@@ -910,43 +1675,29 @@ main(int argc, char **argv)
   switch (arguments.approach)
     {
     case LS_ESTIMATE:
+    case LS_APPROXIMATE:
       {
-        solution = LS_solution_allocate(no_cities,
-                                        no_realizations,
-                                        prob_vec,
-                                        instance.distance,
-                                        arguments.alpha,
-                                        arguments.importance_sampling,
-                                        arguments.deltaProb,
-                                        arguments.deltaDashProb,
-                                        arguments.windowsize,
-                                        arguments.nodes
-                                       );
-        /* Add realizations */
-        LS_resample_realizations(solution,R,sampling_type);
-
-
-        LS_solution_set(&solution,apriori_solution);
-
-
+        solution = LS_solution_start(arguments,&instance,prob_vec,R,
+                                     apriori_solution);
+        LS_solution_explore(arguments,&instance,&solution);
 
-        switch (arguments.exploration)
+        if (arguments.threads>1)
           {
-          case LS_QNN_EXPLORATION:
-            LS_solution_sort_quad_neighbors(&instance,&solution,no_neighbors);
-            break;
-          case LS_NN_EXPLORATION:
-            LS_solution_sort_neighbors(&solution,no_neighbors);
-            break;
-          default:
-            printf("??\n");
-            error(EXIT_FAILURE,0,"Illegal exploration");
+            LS_candidates candidates = LS_solution_save_neighbors(&solution);
+
+            LS_solution_free(&solution);
+            solution = LS_multi_start(arguments,&instance,prob_vec,
+                                      apriori_solution,&candidates);
+            LS_solution_log(solution,solution.no_steps);
+            LS_solution_log(solution,solution.no_steps);
+            LS_solution_free(&solution);
+            LS_candidates_free(&candidates);
+          }
+        else
+          {
+            LS_2hnndlbfls_times(no_steps,&solution,R,time,arguments.verbose,sampling_type);
+            LS_solution_free(&solution);
           }
-
-        LS_2hnndlbfls_times(no_steps,&solution,R,time,arguments.verbose,sampling_type);
-
-
-        LS_solution_free(&solution);
       }
       break;
     default:
@@ -965,5 +1716,3 @@ main(int argc, char **argv)
   exit(EXIT_SUCCESS);
 
 }
-
-
@@ -51,7 +51,21 @@
 #include <time.h>
 #include <values.h>
 #include <error.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <gsl/gsl_math.h>
 #include "readFile.h"
+#include "ptspParser.h"
+
+/* Alignment of the distance matrix: a cache line */
+#define LS_DISTANCE_ALIGNMENT 64
+/* Threads computing the distance matrix: at most one per processor,
+   and not less than LS_DISTANCE_ROWS_PER_THREAD rows each */
+#define LS_DISTANCE_MAX_THREADS 64
+#define LS_DISTANCE_ROWS_PER_THREAD 256
+/* Size of a huge page, used with -DLS_HUGE_PAGES */
+#define LS_HUGE_PAGE_SIZE (2UL*1024*1024)
 
 
 #define DIST(a,b) insPtr->distance[a][b]
@@ -178,226 +192,414 @@ att_distance (long int i, long int j, problem *insPtr)
 
 
 
+/*
+      FUNCTION: the following three functions give the same distances as
+                round_distance, ceil_distance, and att_distance from the
+                squared Euclidean length xd*xd + yd*yd between two nodes
+      INPUT:    squared length
+      OUTPUT:   distance
+      COMMENTS: they are non-decreasing, which allows the searches by
+                coordinates to bound the distance to a region
+*/
+
+LS_DISTANCE
+round_length (double squared_length)
+{
+  return (LS_DISTANCE) (sqrt(squared_length) + 0.5);
+}
+
+LS_DISTANCE
+ceil_length (double squared_length)
+{
+  return (LS_DISTANCE) (sqrt(squared_length) + 0.000000001);
+}
+
+LS_DISTANCE
+att_length (double squared_length)
+{
+  double rij = sqrt (squared_length / 10.0);
+  double tij = dtrunc (rij);
+  long int dij;
+
+  if (tij < rij)
+    dij = (int) tij + 1;
+  else
+    dij = (int) tij;
+  return (LS_DISTANCE)dij;
+}
+
+
+
+int
+set_distance_type(problem *insPtr, const char *edge_weight_type)
+/*
+      FUNCTION: sets the functions computing the distances of an instance
+      INPUT:    pointer to the instance, its EDGE_WEIGHT_TYPE
+      OUTPUT:   1 if the type is one of EUC_2D, CEIL_2D, GEO, or ATT, 0 otherwise
+      COMMENTS: none
+*/
+{
+  LS_DISTANCE (*distance)(long int, long int, problem *);
+  LS_DISTANCE (*length)(double) = NULL;
+
+  if ( strcmp("EUC_2D", edge_weight_type) == 0 )
+    {
+      distance = round_distance;
+      length = round_length;
+    }
+  else if ( strcmp("CEIL_2D", edge_weight_type) == 0 )
+    {
+      distance = ceil_distance;
+      length = ceil_length;
+    }
+  else if ( strcmp("GEO", edge_weight_type) == 0 )
+    distance = geo_distance;
+  else if ( strcmp("ATT", edge_weight_type) == 0 )
+    {
+      distance = att_distance;
+      length = att_length;
+    }
+  else
+    return 0;
+
+  if (insPtr->edge_weight_type != edge_weight_type)
+    {
+      strncpy(insPtr->edge_weight_type,edge_weight_type,LINE_BUF_LEN-1);
+      insPtr->edge_weight_type[LINE_BUF_LEN-1] = 0;
+    }
+  insPtr->distance_function = distance;
+  insPtr->length_distance = length;
+  return 1;
+}
+
+
+
 struct point
       *read_ptsp(const char *ptsp_file_name, problem *insPtr)
       /*
             FUNCTION: parse and read instance file
             INPUT:    instance name
             OUTPUT:   list of coordinates for all nodes
-      	  COMMENTS: Instance files have to be in TSPLIB format, otherwise procedure fails
+      	  COMMENTS: Instance files have to be in TSPLIB format, possibly
+                    compressed with gzip, otherwise procedure fails; see
+                    ptspParser.h
       */
   {
-    FILE         *ptsp_file;
-    char         buf[LINE_BUF_LEN];
-    long int     i, j,n;
-    struct point *nodeptr;
-
-
-    ptsp_file = fopen(ptsp_file_name, "r");
-    if ( ptsp_file == NULL )
-      {
-        fprintf(stderr,"No instance file specified, abort\n");
-        exit(1);
-      }
-    assert(ptsp_file != NULL);
-    /*printf("\nreading tsp-file %s ... \n\n", ptsp_file_name);*/
-
-    fscanf(ptsp_file,"%s", buf);
-    while ( strcmp("NODE_COORD_SECTION", buf) != 0 )
-      {
-        if ( strcmp("NAME", buf) == 0 )
-          {
-            fscanf(ptsp_file, "%s", buf);
-            TRACE ( printf("%s ", buf); )
-            fscanf(ptsp_file, "%s", buf);
-            /*strcpy(insPtr->name, buf);*/
-            TRACE ( printf("%s \n", insPtr->name); )
-            buf[0]=0;
-          }
-        else if ( strcmp("NAME:", buf) == 0 )
-          {
-            fscanf(ptsp_file, "%s", buf);
-            /*strcpy(insPtr->name, buf);*/
-            TRACE ( printf("%s \n", insPtr->name); )
-            buf[0]=0;
-          }
-        else if ( strcmp("COMMENT", buf) == 0 )
-          {
-            fgets(buf, LINE_BUF_LEN, ptsp_file);
-            TRACE ( printf("%s", buf); )
-            buf[0]=0;
-          }
-        else if ( strcmp("COMMENT:", buf) == 0 )
-          {
-            fgets(buf, LINE_BUF_LEN, ptsp_file);
-            TRACE ( printf("%s", buf); )
-            buf[0]=0;
-          }
-        else if ( strcmp("TYPE:", buf) == 0 )
-          {
-            fscanf(ptsp_file, "%s", buf);
-            TRACE ( printf("%s\n", buf); )
-            if( strcmp("PTSP", buf) != 0 )
-              {
-                fprintf(stderr,"\n Not a PTSP instance in TSPLIB format !!\n");
-                exit(1);
-              }
-            buf[0]=0;
-          }
-        else if( strcmp("DIMENSION", buf) == 0 )
-          {
-            fscanf(ptsp_file, "%s", buf);
-            TRACE ( printf("%s ", buf); );
-            fscanf(ptsp_file, "%ld", &n);
-            insPtr->n = n;
-
-            TRACE ( printf("%ld\n", n); );
-            assert ( n > 2 && n < 50000);
-            buf[0]=0;
-          }
-        else if ( strcmp("DIMENSION:", buf) == 0 )
-          {
-            fscanf(ptsp_file, "%ld", &n);
-            insPtr->n = n;
-            TRACE ( printf("%ld\n", n); );
-            assert ( n > 2 && n < 6000);
-            buf[0]=0;
-          }
-        else if( strcmp("DISPLAY_DATA_TYPE", buf) == 0 )
-          {
-            fgets(buf, LINE_BUF_LEN, ptsp_file);
-            TRACE ( printf("%s", buf); );
-            buf[0]=0;
-          }
-        else if ( strcmp("DISPLAY_DATA_TYPE:", buf) == 0 )
-          {
-            fgets(buf, LINE_BUF_LEN, ptsp_file);
-            TRACE ( printf("%s", buf); );
-            buf[0]=0;
-          }
-        else if( strcmp("EDGE_WEIGHT_TYPE", buf) == 0 )
-          {
-            buf[0]=0;
-            fscanf(ptsp_file, "%s", buf);
-            TRACE ( printf("%s ", buf); );
-            buf[0]=0;
-            fscanf(ptsp_file, "%s", buf);
-            TRACE ( printf("%s\n", buf); );
-            if ( strcmp("EUC_2D", buf) == 0 )
-              {
-                distance = round_distance;
-              }
-            else if ( strcmp("CEIL_2D", buf) == 0 )
-              {
-                distance = ceil_distance;
-              }
-            else if ( strcmp("GEO", buf) == 0 )
-              {
-                distance = geo_distance;
-              }
-            else if ( strcmp("ATT", buf) == 0 )
-              {
-                distance = att_distance;
-              }
-            else
-              fprintf(stderr,"EDGE_WEIGHT_TYPE %s not implemented\n",buf);
-            /*strcpy(insPtr->edge_weight_type, buf);*/
-            buf[0]=0;
-          }
-        else if( strcmp("EDGE_WEIGHT_TYPE:", buf) == 0 )
-          {
-            /* set pointer to appropriate distance function; has to be one of
-               EUC_2D, CEIL_2D, GEO, or ATT. Everything else fails */
-            buf[0]=0;
-            fscanf(ptsp_file, "%s", buf);
-            TRACE ( printf("%s\n", buf); )
-            if ( strcmp("EUC_2D", buf) == 0 )
-              {
-                distance = round_distance;
-              }
-            else if ( strcmp("CEIL_2D", buf) == 0 )
-              {
-                distance = ceil_distance;
-              }
-            else if ( strcmp("GEO", buf) == 0 )
-              {
-                distance = geo_distance;
-              }
-            else if ( strcmp("ATT", buf) == 0 )
-              {
-                distance = att_distance;
-              }
-            else
-              {
-                fprintf(stderr,"EDGE_WEIGHT_TYPE %s not implemented\n",buf);
-                exit(1);
-              }
-            /*strcpy(insPtr->edge_weight_type, buf);*/
-            buf[0]=0;
-          }
-        buf[0]=0;
-        fscanf(ptsp_file,"%s", buf);
-      }
-
-
-    if( strcmp("NODE_COORD_SECTION", buf) == 0 )
-      {
-        TRACE ( printf("found section contaning the node coordinates\n"); )
-      }
-    else
-      {
-        fprintf(stderr,"\n\nSome error ocurred finding start of coordinates from tsp file !!\n");
-        exit(1);
-      }
-
-    if( (nodeptr = malloc(sizeof(struct point) * n)) == NULL )
-      exit(EXIT_FAILURE);
-    else
-      {
-        for ( i = 0 ; i < n ; i++ )
-          {
-            fscanf(ptsp_file,"%ld %lf %lf %lf", &j, &nodeptr[i].x,
-                   &nodeptr[i].y,&nodeptr[i].prob);
-          }
-      }
-
-    fclose(ptsp_file);
-    TRACE ( printf("number of cities is %ld\n",n); )
-    TRACE ( printf("\n... done\n"); )
-    return (nodeptr);
+    PTSP_instance ptsp;
+
+    PTSP_read(ptsp_file_name, &ptsp);
+    insPtr->n = ptsp.n;
+    /* No matrix until compute_distances is called: distances are
+       computed from the coordinates */
+    if (!set_distance_type(insPtr,ptsp.edge_weight_type))
+      error(EXIT_FAILURE,0,"EDGE_WEIGHT_TYPE %s not implemented",
+            ptsp.edge_weight_type);
+    insPtr->distance = NULL;
+    insPtr->distance_mapped_size = 0;
+    insPtr->cache = NULL;
+    insPtr->cache_size = 0;
+    TRACE ( printf("number of cities is %ld\n",insPtr->n); )
+    /* The nodes are stored as an array of struct point */
+    return ((struct point *)ptsp.nodes);
 
   }
 
 
+static LS_DISTANCE
+*allocate_distance_block(problem *insPtr, size_t size)
+/*
+      FUNCTION: allocates the contiguous storage of the distance matrix
+      INPUT:    size in bytes
+      OUTPUT:   pointer to a block aligned to a cache line
+      COMMENTS: with -DLS_HUGE_PAGES, large matrices are memory mapped and
+                backed by huge pages if the system allows it, so that
+                fewer TLB entries are needed for the lookups
+*/
+{
+  void *block;
+
+  insPtr->distance_mapped_size = 0;
+
+#ifdef LS_HUGE_PAGES
+  if (size >= LS_HUGE_PAGE_SIZE)
+    {
+      size_t mapped_size = (size + LS_HUGE_PAGE_SIZE - 1) & ~(LS_HUGE_PAGE_SIZE - 1);
+
+#ifdef MAP_HUGETLB
+      block = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (block == MAP_FAILED)
+#endif
+        {
+          block = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+          if (block != MAP_FAILED)
+            madvise(block, mapped_size, MADV_HUGEPAGE);
+#endif
+        }
+      if (block != MAP_FAILED)
+        {
+          insPtr->distance_mapped_size = mapped_size;
+          return block;
+        }
+    }
+#endif
+
+  if (posix_memalign(&block, LS_DISTANCE_ALIGNMENT, size))
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  return block;
+}
+
+
+/* Rows of the distance matrix computed by one thread: rows first,
+   first+step, first+2*step, ... The coordinates are copied in separate
+   arrays so that the loops over the columns are vectorized; for GEO
+   instances they are latitudes and longitudes in radians. */
+struct distance_rows
+{
+  problem      *insPtr;
+  LS_DISTANCE  *matrix;
+  const double *x;
+  const double *y;
+  void         (*row)(const struct distance_rows *rows, long int i,
+                      long int end, LS_DISTANCE *restrict row);
+  long int     first;
+  long int     step;
+};
+
+/*
+      FUNCTION: the following functions compute columns 0 to end-1 of row
+                i of the distance matrix; they give exactly the same
+                values as round_distance, ceil_distance, att_distance,
+                and geo_distance
+      INPUT:    rows being computed, row index, number of columns
+      OUTPUT:   none
+*/
+
+static void
+round_distance_row(const struct distance_rows *rows, long int i,
+                   long int end, LS_DISTANCE *restrict row)
+{
+  const double *restrict x = rows->x, *restrict y = rows->y;
+  const double xi = x[i], yi = y[i];
+  long int j;
+
+  for (j = 0; j < end; j++)
+    {
+      double xd = xi - x[j];
+      double yd = yi - y[j];
+      row[j] = (LS_DISTANCE) (sqrt(xd*xd + yd*yd) + 0.5);
+    }
+}
+
+static void
+ceil_distance_row(const struct distance_rows *rows, long int i,
+                  long int end, LS_DISTANCE *restrict row)
+{
+  const double *restrict x = rows->x, *restrict y = rows->y;
+  const double xi = x[i], yi = y[i];
+  long int j;
+
+  for (j = 0; j < end; j++)
+    {
+      double xd = xi - x[j];
+      double yd = yi - y[j];
+      row[j] = (LS_DISTANCE) (sqrt(xd*xd + yd*yd) + 0.000000001);
+    }
+}
+
+static void
+att_distance_row(const struct distance_rows *rows, long int i,
+                 long int end, LS_DISTANCE *restrict row)
+{
+  const double *restrict x = rows->x, *restrict y = rows->y;
+  const double xi = x[i], yi = y[i];
+  long int j;
+
+  for (j = 0; j < end; j++)
+    {
+      double xd = xi - x[j];
+      double yd = yi - y[j];
+      /* the truncation rounded up, when it is below rij, is the ceiling */
+      row[j] = (LS_DISTANCE) ceil(sqrt((xd*xd + yd*yd) / 10.0));
+    }
+}
+
+static void
+geo_distance_row(const struct distance_rows *rows, long int i,
+                 long int end, LS_DISTANCE *restrict row)
+{
+  const double *restrict lat = rows->x, *restrict lon = rows->y;
+  const double lati = lat[i], longi = lon[i];
+  double q1, q2, q3;
+  long int j, dd;
+
+  for (j = 0; j < end; j++)
+    {
+      q1 = cos (longi - lon[j]);
+      q2 = cos (lati - lat[j]);
+      q3 = cos (lati + lat[j]);
+      dd = (int) (6378.388 * acos (0.5 * ((1.0 + q1) * q2 - (1.0 - q1) * q3)) + 1.0);
+      row[j] = (LS_DISTANCE) dd;
+    }
+}
+
+static void
+generic_distance_row(const struct distance_rows *rows, long int i,
+                     long int end, LS_DISTANCE *restrict row)
+{
+  long int j;
+
+  for (j = 0; j < end; j++)
+    row[j] = rows->insPtr->distance_function(i,j,rows->insPtr);
+}
+
+static double
+geo_radians(double coordinate)
+{
+  double deg = dtrunc (coordinate);
+  double min = coordinate - deg;
+
+  return M_PI * (deg + 5.0 * min / 3.0) / 180.0;
+}
+
+
+static void
+*compute_distance_rows(void *arg)
+{
+  const struct distance_rows *rows = arg;
+  long int i, n = rows->insPtr->n;
+
+  for (i = rows->first; i < n; i += rows->step)
+    {
+#ifdef LS_DISTANCE_FULL_MATRIX
+      rows->row(rows, i, n, rows->matrix + LS_DISTANCE_INDEX(i,0,n));
+#else
+      rows->row(rows, i, i+1, rows->matrix + LS_DISTANCE_INDEX(i,0,n));
+#endif
+    }
+  return NULL;
+}
+
+
 LS_DISTANCE
-** compute_distances(problem *insPtr)
+* compute_distances(problem *insPtr)
 /*
       FUNCTION: computes the matrix of all intercity distances
       INPUT:    none
-      OUTPUT:   pointer to distance matrix, has to be freed when program stops
+      OUTPUT:   pointer to distance matrix, has to be freed with free_distances
+      COMMENTS: the matrix is stored as a single block, indexed with
+                LS_DISTANCE_INDEX; since distances are symmetric, each
+                pair of cities is computed once. Rows are distributed
+                among one thread per processor
 */
 {
-  long int     i, j,n=insPtr->n;
-  LS_DISTANCE     **matrix;
+  long int     i, t, n=insPtr->n;
+  long int     no_threads;
+  LS_DISTANCE  *matrix;
+  double       *x, *y;
+  pthread_t    threads[LS_DISTANCE_MAX_THREADS];
+  int          created[LS_DISTANCE_MAX_THREADS];
+  struct distance_rows rows[LS_DISTANCE_MAX_THREADS];
+  void         (*row)(const struct distance_rows *, long int, long int,
+                      LS_DISTANCE *restrict);
+
+  matrix = allocate_distance_block(insPtr,
+                                   LS_DISTANCE_MATRIX_SIZE(n)*sizeof(LS_DISTANCE));
+
+  x = malloc(n*sizeof(double));
+  y = malloc(n*sizeof(double));
+  if (!x || !y)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
 
+  if (insPtr->distance_function == round_distance)
+    row = round_distance_row;
+  else if (insPtr->distance_function == ceil_distance)
+    row = ceil_distance_row;
+  else if (insPtr->distance_function == att_distance)
+    row = att_distance_row;
+  else if (insPtr->distance_function == geo_distance)
+    row = geo_distance_row;
+  else
+    row = generic_distance_row;
 
-  matrix = malloc(n*sizeof(LS_DISTANCE*));
-  if (!matrix)
-    error(EXIT_FAILURE,0,"Cannot allocate memory");
   for (i = 0; i < n; i++)
     {
-      matrix[i] = malloc(n*sizeof(LS_DISTANCE));
-      if (!matrix[i])
-        error(EXIT_FAILURE,0,"Cannot allocate memory");
+      if (row == geo_distance_row)
+        {
+          x[i] = geo_radians(insPtr->nodeptr[i].x);
+          y[i] = geo_radians(insPtr->nodeptr[i].y);
+        }
       else
-        for ( j = 0  ; j < n ; j++ )
-          {
-            matrix[i][j] = distance(i,j,insPtr);
-          }
+        {
+          x[i] = insPtr->nodeptr[i].x;
+          y[i] = insPtr->nodeptr[i].y;
+        }
+    }
+
+  no_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  no_threads = GSL_MAX(1,GSL_MIN(no_threads,LS_DISTANCE_MAX_THREADS));
+  if (n < LS_DISTANCE_ROWS_PER_THREAD*no_threads)
+    no_threads = GSL_MAX(1,n/LS_DISTANCE_ROWS_PER_THREAD);
+
+  for (t = 0; t < no_threads; t++)
+    {
+      rows[t].insPtr = insPtr;
+      rows[t].matrix = matrix;
+      rows[t].x = x;
+      rows[t].y = y;
+      rows[t].row = row;
+      rows[t].first = t;
+      rows[t].step = no_threads;
+    }
+  /* The calling thread computes the first share, and the shares of the
+     threads that could not be created */
+  for (t = 1; t < no_threads; t++)
+    {
+      created[t] = !pthread_create(&threads[t], NULL, compute_distance_rows, &rows[t]);
+      if (!created[t])
+        compute_distance_rows(&rows[t]);
     }
+  compute_distance_rows(&rows[0]);
+  for (t = 1; t < no_threads; t++)
+    if (created[t])
+      pthread_join(threads[t], NULL);
 
+  free(x);
+  free(y);
   return matrix;
 }
 
 
+int
+distance_matrix_fits(problem *insPtr, double budget)
+/*
+      FUNCTION: checks whether the distance matrix fits in the memory budget
+      INPUT:    pointer to the instance, budget in megabytes
+      OUTPUT:   1 if the matrix should be computed, 0 if the distances
+                have to be computed from the coordinates
+*/
+{
+  double size = (double)LS_DISTANCE_MATRIX_SIZE(insPtr->n) * sizeof(LS_DISTANCE);
 
+  return size <= budget * 1024.0 * 1024.0;
+}
+
+
+void
+free_distances(problem *insPtr)
+/*
+      FUNCTION: frees the matrix computed by compute_distances
+      INPUT:    pointer to the instance
+      OUTPUT:   none
+*/
+{
+  if (!insPtr->distance)
+    return;
+  if (insPtr->distance_mapped_size)
+    munmap(insPtr->distance, insPtr->distance_mapped_size);
+  else
+    free(insPtr->distance);
+  insPtr->distance = NULL;
+}
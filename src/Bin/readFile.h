@@ -58,8 +58,6 @@
 #endif
 
 
-LS_DISTANCE
-(*distance)(long int i, long int j,  problem *insPtr);
 LS_DISTANCE
 round_distance (long int i, long int j, problem *insPtr) ;
 LS_DISTANCE
@@ -68,7 +66,19 @@ LS_DISTANCE
 geo_distance (long int i, long int j, problem *insPtr) ;
 LS_DISTANCE
 att_distance (long int i, long int j, problem *insPtr) ;
+LS_DISTANCE
+round_length (double squared_length);
+LS_DISTANCE
+ceil_length (double squared_length);
+LS_DISTANCE
+att_length (double squared_length);
+int
+set_distance_type(problem *insPtr, const char *edge_weight_type);
 struct point
       *read_ptsp(const char *ptsp_file_name, problem *insPtr) ;
 LS_DISTANCE
-**compute_distances(problem *insPtr);
+*compute_distances(problem *insPtr);
+void
+free_distances(problem *insPtr);
+int
+distance_matrix_fits(problem *insPtr, double budget);
@@ -51,6 +51,7 @@
 #include <gsl/gsl_randist.h>
 #include <gsl/gsl_sort_int.h>
 #include <search.h>
+#include <pthread.h>
 
 #ifdef LS_DISTANCE_LONGINT
 #  include <gsl/gsl_sort_long.h>
@@ -63,12 +64,14 @@
 #include "sampleLS.h"
 #include "stopwatch.h"
 #include "adaptiveSampling.h"
+#include "approximation.h"
+#include "expectedCost.h"
 #define TRUE	1
 #define FALSE	0
 
 LS_List
 LS_solution_allocate_aux(int no_cities, int no_realizations,
-                         const double *prob_vec, const LS_DISTANCE **D, double alpha, int importance_sampling, float deltaProb,
+                         const double *prob_vec, const LS_DISTANCE *D, double alpha, int importance_sampling, float deltaProb,
                          float deltaDashProb, float window_size_percent,float nodes_percent)
 {
   LS_List solution;
@@ -86,20 +89,34 @@ LS_solution_allocate_aux(int no_cities, int no_realizations,
 
   solution.value=0.0;
   solution.no_neighbors=0;
+  solution.shared_neighbors=FALSE;
   solution.first=NULL;
   solution.no_cities = no_cities;
   solution.no_realizations = no_realizations;
-  solution.distances = D;
+  solution.distance_matrix = D;
+  solution.instance = NULL;
   //solution.maximum_realizations=GSL_MAX((no_cities<100)?100:no_cities,no_realizations);
   solution.maximum_realizations=1000; /*this is kept constant*/
   solution.minimum_realizations=5; /*this is kept constant*/
 
   solution.generated_realizations=0;
   solution.move_status=FALSE;
+  solution.no_steps=0;
+  solution.quiet=FALSE;
+  solution.report=NULL;
+  solution.report_data=NULL;
+  solution.evaluators=NULL;
+  solution.sweep=NULL;
+  solution.lk=NULL;
+  solution.or_opt=FALSE;
+  solution.realization_pool=NULL;
   solution.mean_avg_delta=0.0;
   solution.sum_avg_delta=0.0;
 
   solution.alpha=alpha;
+  solution.depth=0;
+  solution.two_level=NULL;
+  solution.absent_power=NULL;
 
 
   /*stats*/
@@ -123,10 +140,24 @@ LS_solution_allocate_aux(int no_cities, int no_realizations,
   if (!solution.position_array)
     error(EXIT_FAILURE,0,"Cannot allocate memory");
 
+  solution.active = malloc(no_cities*sizeof(int));
+  solution.rank = malloc(no_cities*sizeof(int));
+  if (!solution.active || !solution.rank)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  solution.no_active = 0;
+
   solution.delta = malloc((solution.maximum_realizations)*sizeof(double));
   if (!solution.delta)
     error(EXIT_FAILURE,0,"Cannot allocate memory");
 
+  /* The three realization bitsets of all the cities are kept in a
+     single block, city after city */
+  solution.realization_words=LS_REALIZATION_NO_WORDS(solution.maximum_realizations);
+  solution.realization_store =
+    calloc(3*(size_t)no_cities*solution.realization_words,sizeof(LS_REALIZATION_WORD));
+  if (!solution.realization_store)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+
 
 
   for (i=0; i<no_cities; i++)
@@ -137,6 +168,9 @@ LS_solution_allocate_aux(int no_cities, int no_realizations,
       // solution.array[i].correction_vector=NULL;
 
       solution.array[i].city = i;
+      solution.array[i].dlb = 1;
+      solution.array[i].version = 0;
+      solution.rank[i] = i;
 
 
       if (prob_vec)
@@ -167,22 +201,16 @@ LS_solution_allocate_aux(int no_cities, int no_realizations,
 
 
       solution.array[i].neighbors = 0;
+      solution.array[i].neighbor_distances = NULL;
+      solution.array[i].no_neighbors = 0;
 
 
       solution.array[i].realizations =
-        malloc((solution.maximum_realizations)*sizeof(int));
-      if (!solution.array[i].realizations)
-        error(EXIT_FAILURE,0,"Cannot allocate memory");
-
+        solution.realization_store + (3*(size_t)i)*solution.realization_words;
       solution.array[i].two_opt_biased_realizations =
-        malloc((solution.maximum_realizations)*sizeof(int));
-      if (!solution.array[i].two_opt_biased_realizations)
-        error(EXIT_FAILURE,0,"Cannot allocate memory");
-
+        solution.array[i].realizations + solution.realization_words;
       solution.array[i].two_h_opt_biased_realizations =
-        malloc((solution.maximum_realizations)*sizeof(int));
-      if (!solution.array[i].two_h_opt_biased_realizations)
-        error(EXIT_FAILURE,0,"Cannot allocate memory");
+        solution.array[i].two_opt_biased_realizations + solution.realization_words;
 
 
     }
@@ -193,6 +221,12 @@ LS_solution_allocate_aux(int no_cities, int no_realizations,
   for (i=0; i<solution.maximum_realizations; i++)
     solution.realization_order[i]=i;
 
+  solution.block_order = malloc(solution.realization_words*sizeof(int));
+  if (!solution.block_order)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (i=0; i<solution.realization_words; i++)
+    solution.block_order[i]=i;
+
   return solution;
 }
 
@@ -229,6 +263,18 @@ LS_solution_set(LS_List *solPtr, const LS_SOLUTION_INT *apriori_solution)
     }
   (solPtr->array[apriori_solution[solPtr->no_cities-1]]).next =
     solPtr->first;
+  if (solPtr->two_level)
+    LST_tour_set(solPtr->two_level,solPtr->position_array);
+}
+
+
+void
+LS_solution_set_two_level(LS_List *solPtr)
+{
+  if (solPtr->two_level || solPtr->no_cities < LS_TWO_LEVEL_MIN_CITIES)
+    return;
+  solPtr->two_level = LST_tour_allocate(solPtr->no_cities);
+  LST_tour_set(solPtr->two_level,solPtr->position_array);
 }
 
 
@@ -244,13 +290,15 @@ LS_solution_add_realization(LS_List solution,
   //  assert(realization_number<solution.no_realizations);
   for (i=0;i<solution.no_cities;i++)
     {
-      solution.array[i].realizations[realization_number] = (ran_num[i]<=solution.array[i].probability);
-      //printf("%d\n",solution.array[i].realizations[realization_number]);
+      LS_REALIZATION_ASSIGN(solution.array[i].realizations,realization_number,
+                            (ran_num[i]<=solution.array[i].probability));
       if(solution.importance_sampling_flag>0)
         {
           //printf("%f\n",solution.array[i].deltaProbability);
-          solution.array[i].two_opt_biased_realizations[realization_number] = (ran_num[i]<=solution.array[i].deltaProbability);
-          solution.array[i].two_h_opt_biased_realizations[realization_number] = (ran_num[i]<=solution.array[i].deltaDashProbability);
+          LS_REALIZATION_ASSIGN(solution.array[i].two_opt_biased_realizations,realization_number,
+                                (ran_num[i]<=solution.array[i].deltaProbability));
+          LS_REALIZATION_ASSIGN(solution.array[i].two_h_opt_biased_realizations,realization_number,
+                                (ran_num[i]<=solution.array[i].deltaDashProbability));
         }
 
 
@@ -261,6 +309,47 @@ LS_solution_add_realization(LS_List solution,
 
 
 
+/* Change the version of the cities of the path from a to b */
+static void
+LS_path_versions(LS_List *solPtr, int a, int b)
+{
+  int c;
+
+  for (c = a; c != b; c = LS_NEXT(solPtr,c))
+    solPtr->array[c].version++;
+  solPtr->array[b].version++;
+}
+
+/* LS_2opt_move on the two-level list: the same path is reversed, so
+   that the tour and the positions are those of the array. The versions
+   of the cities inside the path are only needed for the moves
+   evaluated by several threads, and cost the length of the path. */
+static void
+LS_2opt_two_level_move(LS_List *solPtr, int h1, int h2, int h3, int h4)
+{
+  int n=solPtr->no_cities;
+
+  if ( LS_POSITION(solPtr,h3) - LS_POSITION(solPtr,h2) < n / 2 + 1)
+    {
+      LST_reverse(solPtr->two_level,h2,h3);
+      if (solPtr->evaluators)
+        LS_path_versions(solPtr,h3,h2);
+      else
+        solPtr->array[h2].version++;
+      solPtr->array[h4].version++;
+    }
+  else
+    {
+      LST_reverse(solPtr->two_level,h4,h1);
+      if (solPtr->evaluators)
+        LS_path_versions(solPtr,h1,h4);
+      else
+        solPtr->array[h4].version++;
+      solPtr->array[h2].version++;
+    }
+}
+
+
 void
 LS_2opt_move(LS_List *solPtr, double delta,
              int edge0fst, int edge0snd,
@@ -275,14 +364,14 @@ LS_2opt_move(LS_List *solPtr, double delta,
   //   printf("edge0snd: %d,pos: %d\n",edge0snd,solPtr->position_array[edge0snd]);
   //   printf("edge1fst: %d,pos: %d\n",edge1fst,solPtr->position_array[edge1fst]);
   //   printf("edge1snd: %d,pos: %d\n",edge1snd,solPtr->position_array[edge1snd]);
-  assert(!((solPtr->position_array[edge0fst]+1 )%n !=solPtr->position_array[edge0snd]));
+  assert(!((LS_POSITION(solPtr,edge0fst)+1 )%n !=LS_POSITION(solPtr,edge0snd)));
   //     if((solPtr->position_array[edge0fst]+1 )%n !=solPtr->position_array[edge0snd])
   //    {
   //  	  printf("check edge0fst: %d\n",(solPtr->position_array[edge0fst]+1)%n);
   //  	  printf("check edge0snd: %d\n",solPtr->position_array[edge0snd]);
   //  	  exit(0);
   //    }
-  assert(!((solPtr->position_array[edge1fst]+1)%n != solPtr->position_array[edge1snd]));
+  assert(!((LS_POSITION(solPtr,edge1fst)+1)%n != LS_POSITION(solPtr,edge1snd)));
   //   if((solPtr->position_array[edge1fst]+1)%n != solPtr->position_array[edge1snd])
   //    if((solPtr->position_array[edge1fst]+1)%n != solPtr->position_array[edge1snd])
   //    {
@@ -296,7 +385,7 @@ LS_2opt_move(LS_List *solPtr, double delta,
   h3 = edge1fst;
   h4 = edge1snd;
 
-  if ( solPtr->position_array[h3] < solPtr->position_array[h1] )
+  if ( LS_POSITION(solPtr,h3) < LS_POSITION(solPtr,h1) )
     {
       help = h1;
       h1 = h3;
@@ -306,6 +395,13 @@ LS_2opt_move(LS_List *solPtr, double delta,
       h4 = help;
     }
 
+  if (solPtr->two_level)
+    {
+      LS_2opt_two_level_move(solPtr,h1,h2,h3,h4);
+      solPtr->value += delta;
+      return;
+    }
+
   if ( solPtr->position_array[h3] - solPtr->position_array[h2] < n / 2 + 1)
     {
       /* reverse inner part from pos[h2] to pos[h3] */
@@ -317,6 +413,7 @@ LS_2opt_move(LS_List *solPtr, double delta,
         {
           this->next = this->prev;
           this->prev = prev;
+          this->version++;
           solPtr->position_array[this->city]=(++h_pos)%n;
           prev = this;
           //printf("moving inner %d\n",this->city);
@@ -326,6 +423,8 @@ LS_2opt_move(LS_List *solPtr, double delta,
       solPtr->array[h2].prev = prev;
       solPtr->array[h2].next = &solPtr->array[h4];
       solPtr->array[h4].prev = &solPtr->array[h2];
+      solPtr->array[h2].version++;
+      solPtr->array[h4].version++;
       solPtr->position_array[h2]=(++h_pos)%n;
       //printf("moving inner %d\n",h2);
       //printf(" with rank -> %d\n",solPtr->position_array[h2]);
@@ -341,6 +440,7 @@ LS_2opt_move(LS_List *solPtr, double delta,
         {
           this->next = this->prev;
           this->prev = prev;
+          this->version++;
           solPtr->position_array[this->city]=(++h_pos)%n;
           prev = this;
           //printf("moving outer %d\n",this->city);
@@ -350,6 +450,8 @@ LS_2opt_move(LS_List *solPtr, double delta,
       solPtr->array[h4].prev = prev;
       solPtr->array[h4].next = &solPtr->array[h2];
       solPtr->array[h2].prev = &solPtr->array[h4];
+      solPtr->array[h2].version++;
+      solPtr->array[h4].version++;
       solPtr->position_array[h4]=(++h_pos)%n;
       //printf("moving outer %d\n",h4);
       //printf(" with rank -> %d\n",solPtr->position_array[h4]);
@@ -363,43 +465,119 @@ LS_2opt_move(LS_List *solPtr, double delta,
 }
 
 
+/* The function evaluating the moves with the given type of sampling */
+static LSA_delta_function
+LS_delta_evaluation(int sampling_type)
+{
+  switch (sampling_type)
+    {
+    case 0:
+      return LS_delta;
+    case 1:
+      return LSA_delta_adaptive_sample;
+    case 2:
+      return LSA_delta_adaptive_sample_block;
+    case LSX_SAMPLING_TYPE:
+      return LSX_delta;
+    default:
+      error(EXIT_FAILURE,0,"Illegal type of sampling");
+      return NULL;
+    }
+}
+
+
+/* The cities whose don't look bit is not set are kept in a binary
+   heap on their rank, so that a step finds the first of them in the
+   order without going through those before it, and looks at them in
+   the same order as a scan of the order would. */
+static void
+LS_active_push(LS_List *solPtr, int city)
+{
+  int k, parent;
+
+  for (k=solPtr->no_active++; k>0; k=parent)
+    {
+      parent = (k-1)/2;
+      if (solPtr->rank[solPtr->active[parent]] < solPtr->rank[city])
+        break;
+      solPtr->active[k] = solPtr->active[parent];
+    }
+  solPtr->active[k] = city;
+}
+
+/* Remove the first active city from the heap, leaving its don't look
+   bit as it is */
+static int
+LS_active_pop(LS_List *solPtr)
+{
+  int city = solPtr->active[0];
+  int last = solPtr->active[--solPtr->no_active];
+  int k, child;
+
+  for (k=0; (child=2*k+1) < solPtr->no_active; k=child)
+    {
+      if (child+1 < solPtr->no_active &&
+          solPtr->rank[solPtr->active[child+1]] < solPtr->rank[solPtr->active[child]])
+        child++;
+      if (solPtr->rank[last] < solPtr->rank[solPtr->active[child]])
+        break;
+      solPtr->active[k] = solPtr->active[child];
+    }
+  solPtr->active[k] = last;
+  return city;
+}
+
+/* Reset the don't look bit of a city changed by a move */
+static inline void
+LS_activate(LS_List *solPtr, int city)
+{
+  if (solPtr->array[city].dlb)
+    {
+      solPtr->array[city].dlb = 0;
+      LS_active_push(solPtr,city);
+    }
+}
+
+/* The first city of the order whose don't look bit is not set, -1 if
+   there is none */
+static inline int
+LS_active_first(const LS_List *solPtr)
+{
+  return solPtr->no_active ? solPtr->active[0] : -1;
+}
+
+/* Set the don't look bit of the first active city, from which no
+   improving move was found */
+static inline void
+LS_deactivate_first(LS_List *solPtr)
+{
+  solPtr->array[LS_active_pop(solPtr)].dlb = 1;
+}
+
+
 double
-LS_2nndlbfls_step(LS_List *solPtr, const int *order, gsl_rng *r, int sampling_type)
+LS_2nndlbfls_step(LS_List *solPtr, gsl_rng *r, int sampling_type)
 {
   int edge0fst, edge0snd, edge1fst=-1, edge1snd=-1;
   int this_city;
-  const LS_DISTANCE **D = solPtr->distances;
   double delta;
-  int i, j;
+  int j;
   LS_DISTANCE radius;
-  int nn = solPtr->no_neighbors;
-  int n = solPtr->no_cities;
-
-  if(sampling_type==0)
-    delta_evaluation=LS_delta;
-  else if (sampling_type==1)
-    delta_evaluation=LSA_delta_adaptive_sample;
-  else if (sampling_type==2)
-    delta_evaluation=LSA_delta_adaptive_sample;
+  LSA_delta_function delta_evaluation = LS_delta_evaluation(sampling_type);
 
-  for (i=0; i<n; i++)
+  while ((this_city = LS_active_first(solPtr)) >= 0)
     {
-      this_city = order[i];
-
-      if (solPtr->array[this_city].dlb)
-        continue;
-
       edge0fst = this_city;
-      edge0snd = solPtr->array[this_city].next->city;
-      radius = D[edge0fst][edge0snd];
+      edge0snd = LS_NEXT(solPtr,this_city);
+      radius = LS_DIST(solPtr,edge0fst,edge0snd);
       /* The loop starts from 1 because
       position 0 is the current city itself */
-      for (j=1; j<nn; j++)
+      for (j=1; j<solPtr->array[edge0fst].no_neighbors; j++)
         {
           edge1fst = solPtr->array[edge0fst].neighbors[j];
-          if (radius>D[edge0fst][edge1fst])
+          if (radius>solPtr->array[edge0fst].neighbor_distances[j])
             {
-              edge1snd = solPtr->array[edge1fst].next->city;
+              edge1snd = LS_NEXT(solPtr,edge1fst);
 
               if ( edge1fst==edge0snd || edge0fst==edge1snd )
                 continue;
@@ -409,10 +587,10 @@ LS_2nndlbfls_step(LS_List *solPtr, const int *order, gsl_rng *r, int sampling_ty
                 {
                   LS_2opt_move(solPtr,delta,
                                edge0fst,edge0snd,edge1fst,edge1snd);
-                  solPtr->array[edge0fst].dlb = 0;
-                  solPtr->array[edge0snd].dlb = 0;
-                  solPtr->array[edge1fst].dlb = 0;
-                  solPtr->array[edge1snd].dlb = 0;
+                  LS_activate(solPtr,edge0fst);
+                  LS_activate(solPtr,edge0snd);
+                  LS_activate(solPtr,edge1fst);
+                  LS_activate(solPtr,edge1snd);
                   return(delta);
                 }
             }
@@ -421,18 +599,18 @@ LS_2nndlbfls_step(LS_List *solPtr, const int *order, gsl_rng *r, int sampling_ty
         }
 
 
-      edge0fst = solPtr->array[this_city].prev->city;
+      edge0fst = LS_PREV(solPtr,this_city);
       edge0snd = this_city;
-      radius = D[edge0fst][edge0snd];
+      radius = LS_DIST(solPtr,edge0fst,edge0snd);
 
       /* The loop starts from 1 because
       position 0 is the current city itself */
-      for (j=1; j<nn; j++)
+      for (j=1; j<solPtr->array[edge0snd].no_neighbors; j++)
         {
           edge1snd = solPtr->array[edge0snd].neighbors[j];
-          if (radius>D[edge0snd][edge1snd])
+          if (radius>solPtr->array[edge0snd].neighbor_distances[j])
             {
-              edge1fst=solPtr->array[edge1snd].prev->city;
+              edge1fst=LS_PREV(solPtr,edge1snd);
 
               /* Seen in Thomas code but not fully understood...*/
               if ( edge1fst==edge0snd || edge0fst==edge1snd )
@@ -444,10 +622,10 @@ LS_2nndlbfls_step(LS_List *solPtr, const int *order, gsl_rng *r, int sampling_ty
                 {
                   LS_2opt_move(solPtr,delta,
                                edge0fst,edge0snd,edge1fst,edge1snd);
-                  solPtr->array[edge0fst].dlb = 0;
-                  solPtr->array[edge0snd].dlb = 0;
-                  solPtr->array[edge1fst].dlb = 0;
-                  solPtr->array[edge1snd].dlb = 0;
+                  LS_activate(solPtr,edge0fst);
+                  LS_activate(solPtr,edge0snd);
+                  LS_activate(solPtr,edge1fst);
+                  LS_activate(solPtr,edge1snd);
                   return(delta);
                 }
             }
@@ -457,7 +635,7 @@ LS_2nndlbfls_step(LS_List *solPtr, const int *order, gsl_rng *r, int sampling_ty
 
       /* If we are here, its because no improving neighboring
       solution was found starting from `this_city' */
-      solPtr->array[this_city].dlb = 1;
+      LS_deactivate_first(solPtr);
     }
 
 
@@ -485,21 +663,21 @@ LS_2hopt_move(LS_List *solPtr, double delta,
   //   printf("edge1fst: %d,pos: %d\n",edge1fst,solPtr->position_array[edge1fst]);
   //   printf("edge1snd: %d,pos: %d\n",edge1snd,solPtr->position_array[edge1snd]);
 
-  assert(!((solPtr->position_array[edge0fst]+1 )%n !=solPtr->position_array[edge0snd]));
+  assert(!((LS_POSITION(solPtr,edge0fst)+1 )%n !=LS_POSITION(solPtr,edge0snd)));
   //   if((solPtr->position_array[edge0fst]+1 )%n !=solPtr->position_array[edge0snd])
   //   {
   // 	  printf("check edge0fst: %d\n",(solPtr->position_array[edge0fst]+1)%n);
   // 	  printf("check edge0snd: %d\n",solPtr->position_array[edge0snd]);
   // 	  exit(0);
   //   }
-  assert(!((solPtr->position_array[edge1fst]+1)%n != solPtr->position_array[node]));
+  assert(!((LS_POSITION(solPtr,edge1fst)+1)%n != LS_POSITION(solPtr,node)));
   //   if((solPtr->position_array[edge1fst]+1)%n != solPtr->position_array[node])
   //   {
   // 	  printf("check edge1fst: %d\n",(solPtr->position_array[edge1fst]+1)%n);
   // 	  printf("check edge1snd: %d\n",solPtr->position_array[node]);
   // 	  exit(0);
   //   }
-  assert(!((solPtr->position_array[node]+1)%n != solPtr->position_array[edge1snd]));
+  assert(!((LS_POSITION(solPtr,node)+1)%n != LS_POSITION(solPtr,edge1snd)));
   //   if((solPtr->position_array[node]+1)%n != solPtr->position_array[edge1snd])
   //   {
   // 	  printf("check edge1fst: %d\n",(solPtr->position_array[edge1fst]+1)%n);
@@ -507,12 +685,39 @@ LS_2hopt_move(LS_List *solPtr, double delta,
   // 	  exit(0);
   //   }
 
+  if (solPtr->two_level)
+    {
+      /* Two reversals insert node, and leave the positions as below */
+      if ( LS_POSITION(solPtr,edge0fst) < LS_POSITION(solPtr,edge1fst) )
+        {
+          LST_reverse(solPtr->two_level,edge0snd,node);
+          LST_reverse(solPtr->two_level,edge1fst,edge0snd);
+        }
+      else
+        {
+          LST_reverse(solPtr->two_level,node,edge0fst);
+          LST_reverse(solPtr->two_level,edge0fst,edge1snd);
+        }
+      solPtr->array[edge0fst].version++;
+      solPtr->array[edge0snd].version++;
+      solPtr->array[node].version++;
+      solPtr->array[edge1fst].version++;
+      solPtr->array[edge1snd].version++;
+      solPtr->value += delta;
+      return;
+    }
+
   solPtr->array[edge0fst].next = &solPtr->array[node];
   solPtr->array[node].prev = &solPtr->array[edge0fst];
   solPtr->array[node].next = &solPtr->array[edge0snd];
   solPtr->array[edge0snd].prev = &solPtr->array[node];
   solPtr->array[edge1fst].next = &solPtr->array[edge1snd];
   solPtr->array[edge1snd].prev = &solPtr->array[edge1fst];
+  solPtr->array[edge0fst].version++;
+  solPtr->array[edge0snd].version++;
+  solPtr->array[node].version++;
+  solPtr->array[edge1fst].version++;
+  solPtr->array[edge1snd].version++;
   solPtr->value += delta;
 
 
@@ -552,298 +757,1334 @@ LS_2hopt_move(LS_List *solPtr, double delta,
 }
 
 
-double
-LS_2hnndlbfls_step(LS_List *solPtr, const int *order, gsl_rng *r, int sampling_type)
+/* An improving move found by LS_2hnndlbfls_scan: a 2-exchange of the
+   edges (edge0fst,edge0snd) and (edge1fst,edge1snd) if node is -1, the
+   insertion between edge0fst and edge0snd of the segment from node to
+   last otherwise, as given by opt (see LSA_delta_function). The
+   versions of the cities it changes are those they had when it was
+   evaluated. */
+struct LS_move
+  {
+    int edge0fst, edge0snd, node, last, edge1fst, edge1snd;
+    int opt;
+    int length;                      /* of the segment */
+    double delta;
+    unsigned int version[6];
+  };
+
+/* Store an improving move in move */
+static void
+LS_move_record(const LS_List *solPtr, struct LS_move *move,
+               int edge0fst, int edge0snd, int node, int last,
+               int edge1fst, int edge1snd, int opt, int length, double delta)
 {
-  int edge0fst, edge0snd, edge1fst=-1, edge1snd=-1, node=-1;
-  int this_city;
+  move->edge0fst = edge0fst;
+  move->edge0snd = edge0snd;
+  move->node = node;
+  move->last = last;
+  move->edge1fst = edge1fst;
+  move->edge1snd = edge1snd;
+  move->opt = opt;
+  move->length = length;
+  move->delta = delta;
+  move->version[0] = solPtr->array[edge0fst].version;
+  move->version[1] = solPtr->array[edge0snd].version;
+  move->version[2] = solPtr->array[edge1fst].version;
+  move->version[3] = solPtr->array[edge1snd].version;
+  move->version[4] = (node<0) ? 0 : solPtr->array[node].version;
+  move->version[5] = (last<0) ? 0 : solPtr->array[last].version;
+}
+
+/* The last city of the segment of length cities from node, -1 if
+   edge0fst or edge0snd is in it */
+static int
+LS_or_opt_segment(const LS_List *solPtr, int node, int length,
+                  int edge0fst, int edge0snd)
+{
+  int k, last = node;
 
-  const LS_DISTANCE **D = solPtr->distances;
+  for (k=0; k<length; k++)
+    {
+      if (k)
+        last = LS_NEXT(solPtr,last);
+      if (last == edge0fst || last == edge0snd)
+        return -1;
+    }
+  return last;
+}
 
+/* Look for an improving Or-opt move inserting between edge0fst and
+   edge0snd a segment of 2 to LS_OR_OPT_MAX_LENGTH cities, with city
+   at its end next to edge0fst if at_first, next to edge0snd otherwise:
+   the segment starting at city, or the one ending there reversed. The
+   first one found is stored in move. */
+static int
+LS_or_opt_scan(LS_List *solPtr, int edge0fst, int edge0snd, int city,
+               int at_first, LSA_delta_function delta_evaluation,
+               gsl_rng *r, struct LS_move *move)
+{
+  int length, k, from_city, node, last, edge1fst, edge1snd, opt;
   double delta;
-  int i, j;
-  LS_DISTANCE radius;
-  int nn = solPtr->no_neighbors;
-  int n = solPtr->no_cities;
 
-  if(sampling_type==0)
-    delta_evaluation=LS_delta;
-  else if (sampling_type==1)
-    delta_evaluation=LSA_delta_adaptive_sample;
-  else if (sampling_type==2)
-    delta_evaluation=LSA_delta_adaptive_sample;
+  for (length=2; length<=LS_OR_OPT_MAX_LENGTH; length++)
+    for (from_city=TRUE; from_city>=FALSE; from_city--)
+      {
+        node = city;
+        if (!from_city)
+          for (k=1; k<length; k++)
+            node = LS_PREV(solPtr,node);
+        last = LS_or_opt_segment(solPtr,node,length,edge0fst,edge0snd);
+        if (last < 0)
+          continue;
+        edge1fst = LS_PREV(solPtr,node);
+        edge1snd = LS_NEXT(solPtr,last);
+        /* The segment is already there, or makes the rest of the tour
+           with edge0fst and edge0snd */
+        if (edge1fst == edge0fst || (edge1fst == edge0snd && edge1snd == edge0fst))
+          continue;
+        opt = (from_city == at_first) ? LSA_OR_OPT : LSA_OR_OPT_REVERSED;
+        delta = delta_evaluation(solPtr,edge0fst,edge0snd,node,edge1fst,edge1snd,r,opt);
+        if (solPtr->move_status)
+          {
+            LS_move_record(solPtr,move,edge0fst,edge0snd,node,last,
+                           edge1fst,edge1snd,opt,length,delta);
+            return TRUE;
+          }
+      }
+  return FALSE;
+}
 
+/* Look for an improving Or-opt move next to this_city, with the
+   neighbors of this_city as LS_2hnndlbfls_scan does */
+static int
+LS_or_opt_neighbors(LS_List *solPtr, int this_city,
+                    LSA_delta_function delta_evaluation, gsl_rng *r,
+                    struct LS_move *move)
+{
+  int edge0fst, edge0snd, neighbor, j;
+  LS_DISTANCE radius;
 
-  for (i=0; i<n; i++)
+  edge0fst = this_city;
+  edge0snd = LS_NEXT(solPtr,this_city);
+  radius = LS_DIST(solPtr,edge0fst,edge0snd);
+  for (j=1; j<solPtr->array[edge0fst].no_neighbors &&
+         radius>solPtr->array[edge0fst].neighbor_distances[j]; j++)
     {
-      this_city = order[i];
+      neighbor = solPtr->array[edge0fst].neighbors[j];
+      if (neighbor != edge0snd &&
+          LS_or_opt_scan(solPtr,edge0fst,edge0snd,neighbor,TRUE,delta_evaluation,r,move))
+        return TRUE;
+    }
 
-      if (solPtr->array[this_city].dlb)
-        continue;
+  edge0fst = LS_PREV(solPtr,this_city);
+  edge0snd = this_city;
+  radius = LS_DIST(solPtr,edge0fst,edge0snd);
+  for (j=1; j<solPtr->array[edge0snd].no_neighbors &&
+         radius>solPtr->array[edge0snd].neighbor_distances[j]; j++)
+    {
+      neighbor = solPtr->array[edge0snd].neighbors[j];
+      if (neighbor != edge0fst &&
+          LS_or_opt_scan(solPtr,edge0fst,edge0snd,neighbor,FALSE,delta_evaluation,r,move))
+        return TRUE;
+    }
+  return FALSE;
+}
 
-      edge0fst = this_city;
-      edge0snd = solPtr->array[this_city].next->city;
-      radius = D[edge0fst][edge0snd];
+/* Search the neighborhood of this_city as a step of the 2.5-exchange
+   local search does, up to the first improving move, which is stored
+   in move but not made. The solution is only read, except for the
+   move status and the statistics of the evaluations. */
+static int
+LS_2hnndlbfls_scan(LS_List *solPtr, int this_city,
+                   LSA_delta_function delta_evaluation, gsl_rng *r,
+                   struct LS_move *move)
+{
+  int edge0fst, edge0snd, edge1fst=-1, edge1snd=-1, node=-1;
+  double delta;
+  int j;
+  LS_DISTANCE radius;
 
-      /* The loop starts from 1 because
-      position 0 is the current city itself */
-      for (j=1; j<nn; j++)
+  edge0fst = this_city;
+  edge0snd = LS_NEXT(solPtr,this_city);
+  radius = LS_DIST(solPtr,edge0fst,edge0snd);
+
+  /* The loop starts from 1 because
+  position 0 is the current city itself */
+  for (j=1; j<solPtr->array[edge0fst].no_neighbors; j++)
+    {
+      edge1fst = solPtr->array[edge0fst].neighbors[j];
+      if (radius>solPtr->array[edge0fst].neighbor_distances[j])
         {
-          edge1fst = solPtr->array[edge0fst].neighbors[j];
-          if (radius>D[edge0fst][edge1fst])
+          edge1snd = LS_NEXT(solPtr,edge1fst);
+          /* Seen in Thomas code but not fully understood...*/
+          if ( edge1fst==edge0snd || edge0fst==edge1snd )
+            continue;
+          //delta=LS_2opt_delta(solPtr,edge0fst,edge0snd,edge1fst,edge1snd,r);
+          delta=delta_evaluation(solPtr,edge0fst,edge0snd,-1,edge1fst,edge1snd,r,0);
+          if (solPtr->move_status)
             {
-              edge1snd = solPtr->array[edge1fst].next->city;
-              /* Seen in Thomas code but not fully understood...*/
-              if ( edge1fst==edge0snd || edge0fst==edge1snd )
-                continue;
-              //delta=LS_2opt_delta(solPtr,edge0fst,edge0snd,edge1fst,edge1snd,r);
-              delta=delta_evaluation(solPtr,edge0fst,edge0snd,-1,edge1fst,edge1snd,r,0);
-              if (solPtr->move_status)
-                {
-                  LS_2opt_move(solPtr,delta,
-                               edge0fst,edge0snd,edge1fst,edge1snd);
-                  solPtr->array[edge0fst].dlb = 0;
-                  solPtr->array[edge0snd].dlb = 0;
-                  solPtr->array[edge1fst].dlb = 0;
-                  solPtr->array[edge1snd].dlb = 0;
-                  return(delta);
-                }
-
-              node = edge1fst;
-              edge1fst = solPtr->array[node].prev->city;
-              //            delta=LS_2hopt_delta(solPtr,edge0fst,edge0snd,node,edge1fst,edge1snd,r);
-              delta=delta_evaluation(solPtr,edge0fst,edge0snd,node,edge1fst,edge1snd,r,1);
-              if (solPtr->move_status)
-                {
-                  LS_2hopt_move(solPtr,delta,edge0fst,edge0snd,
-                                node,edge1fst,edge1snd);
-                  solPtr->array[node].dlb = 0;
-                  solPtr->array[edge0fst].dlb = 0;
-                  solPtr->array[edge0snd].dlb = 0;
-                  solPtr->array[edge1fst].dlb = 0;
-                  solPtr->array[edge1snd].dlb = 0;
-                  return(delta);
-                }
+              node = -1;
+              goto found;
             }
-          else
-            break;
+
+          node = edge1fst;
+          edge1fst = LS_PREV(solPtr,node);
+          //            delta=LS_2hopt_delta(solPtr,edge0fst,edge0snd,node,edge1fst,edge1snd,r);
+          delta=delta_evaluation(solPtr,edge0fst,edge0snd,node,edge1fst,edge1snd,r,1);
+          if (solPtr->move_status)
+            goto found;
         }
+      else
+        break;
+    }
 
 
-      edge0fst = solPtr->array[this_city].prev->city;
-      edge0snd = this_city;
-      radius = D[edge0fst][edge0snd];
+  edge0fst = LS_PREV(solPtr,this_city);
+  edge0snd = this_city;
+  radius = LS_DIST(solPtr,edge0fst,edge0snd);
 
-      /* The loop starts from 1 because
-      position 0 is the current city itself */
-      for (j=1; j<nn; j++)
+  /* The loop starts from 1 because
+  position 0 is the current city itself */
+  for (j=1; j<solPtr->array[edge0snd].no_neighbors; j++)
+    {
+      edge1snd = solPtr->array[edge0snd].neighbors[j];
+      if (radius>solPtr->array[edge0snd].neighbor_distances[j])
         {
-          edge1snd = solPtr->array[edge0snd].neighbors[j];
-          if (radius>D[edge0snd][edge1snd])
-            {
-              edge1fst=solPtr->array[edge1snd].prev->city;
-
-              /* Seen in Thomas code but not fully understood...*/
-              if ( edge1fst==edge0snd || edge0fst==edge1snd )
-                continue;
+          edge1fst=LS_PREV(solPtr,edge1snd);
 
-              //delta=LS_2opt_delta(solPtr,edge0fst,edge0snd,edge1fst,edge1snd,r);
-              delta=delta_evaluation(solPtr,edge0fst,edge0snd,-1,edge1fst,edge1snd,r,0);
-              if (solPtr->move_status)
-                {
-                  LS_2opt_move(solPtr,delta,
-                               edge0fst,edge0snd,edge1fst,edge1snd);
-                  solPtr->array[edge0fst].dlb = 0;
-                  solPtr->array[edge0snd].dlb = 0;
-                  solPtr->array[edge1fst].dlb = 0;
-                  solPtr->array[edge1snd].dlb = 0;
-                  return(delta);
-                }
+          /* Seen in Thomas code but not fully understood...*/
+          if ( edge1fst==edge0snd || edge0fst==edge1snd )
+            continue;
 
-              node = edge1snd;
-              edge1snd = solPtr->array[node].next->city;
-              //            delta=LS_2hopt_delta(solPtr,edge0fst,edge0snd,node,edge1fst,edge1snd,r);
-              delta=delta_evaluation(solPtr,edge0fst,edge0snd,node,edge1fst,edge1snd,r,1);
-              if (solPtr->move_status)
-                {
-                  LS_2hopt_move(solPtr,delta,edge0fst,edge0snd,
-                                node,edge1fst,edge1snd);
-                  solPtr->array[node].dlb = 0;
-                  solPtr->array[edge0fst].dlb = 0;
-                  solPtr->array[edge0snd].dlb = 0;
-                  solPtr->array[edge1fst].dlb = 0;
-                  solPtr->array[edge1snd].dlb = 0;
-                  return(delta);
-                }
+          //delta=LS_2opt_delta(solPtr,edge0fst,edge0snd,edge1fst,edge1snd,r);
+          delta=delta_evaluation(solPtr,edge0fst,edge0snd,-1,edge1fst,edge1snd,r,0);
+          if (solPtr->move_status)
+            {
+              node = -1;
+              goto found;
             }
-          else
-            break;
-        }
 
-      /* If we are here, its because no improving neighboring
-      solution was found starting from `this_city' */
-      solPtr->array[this_city].dlb = 1;
+          node = edge1snd;
+          edge1snd = LS_NEXT(solPtr,node);
+          //            delta=LS_2hopt_delta(solPtr,edge0fst,edge0snd,node,edge1fst,edge1snd,r);
+          delta=delta_evaluation(solPtr,edge0fst,edge0snd,node,edge1fst,edge1snd,r,1);
+          if (solPtr->move_status)
+            goto found;
+        }
+      else
+        break;
     }
 
+  if (solPtr->or_opt)
+    return LS_or_opt_neighbors(solPtr,this_city,delta_evaluation,r,move);
+  return FALSE;
 
-  /* If we are here, its because no improving neighboring
-     solution was found starting from any city. We than report that
-     no improvement was made */
-  return 0.0;
+found:
+  LS_move_record(solPtr,move,edge0fst,edge0snd,node,node,edge1fst,edge1snd,
+                 (node<0) ? 0 : 1,(node<0) ? 0 : 1,delta);
+  return TRUE;
 }
 
+/* Whether none of the cities of the move has changed since it was
+   evaluated */
+static int
+LS_move_is_current(const LS_List *solPtr, const struct LS_move *move)
+{
+  return move->version[0] == solPtr->array[move->edge0fst].version &&
+         move->version[1] == solPtr->array[move->edge0snd].version &&
+         move->version[2] == solPtr->array[move->edge1fst].version &&
+         move->version[3] == solPtr->array[move->edge1snd].version &&
+         (move->node < 0 || (move->version[4] == solPtr->array[move->node].version &&
+                             move->version[5] == solPtr->array[move->last].version));
+}
 
-void
-LS_reset_dlb(LS_List *solPtr)
+/* The 2-exchange replacing the edges (a,b) and (c,d), in this order
+   along the tour in one direction or the other, with (a,c) and (b,d) */
+static void
+LS_2opt_exchange(LS_List *solPtr, double delta, int a, int b, int c, int d)
 {
-  int i;
-  for (i=0; i<solPtr->no_cities; i++)
-    solPtr->array[i].dlb=0;
+  if (LS_NEXT(solPtr,a) == b)
+    LS_2opt_move(solPtr,delta,a,b,c,d);
+  else
+    LS_2opt_move(solPtr,delta,d,c,b,a);
 }
 
+/* Move the segment from node to last, which is between edge1fst and
+   edge1snd, between edge0fst and edge0snd, reversed if so asked. The
+   segment is inserted reversed by two 2-exchanges, or by one when it is
+   next to edge0fst or edge0snd, and then turned around if need be; the
+   moves being those of LS_2opt_move, the positions of the cities stay
+   consistent with either representation of the tour. */
+static void
+LS_or_opt_move(LS_List *solPtr, double delta,
+               int edge0fst, int edge0snd, int node, int last,
+               int edge1fst, int edge1snd, int reversed)
+{
+  if (edge1snd == edge0fst)
+    LS_2opt_exchange(solPtr,delta,edge1fst,node,edge0fst,edge0snd);
+  else
+    {
+      LS_2opt_exchange(solPtr,delta,edge0fst,edge0snd,last,edge1snd);
+      if (edge1fst != edge0snd)
+        LS_2opt_exchange(solPtr,0.0,node,edge1fst,edge0snd,edge1snd);
+    }
+  /* edge0fst last ... node edge0snd */
+  if (!reversed)
+    LS_2opt_exchange(solPtr,0.0,edge0fst,last,node,edge0snd);
+}
 
+static void
+LS_make_move(LS_List *solPtr, const struct LS_move *move)
+{
+  if (move->node < 0)
+    LS_2opt_move(solPtr,move->delta,
+                 move->edge0fst,move->edge0snd,move->edge1fst,move->edge1snd);
+  else if (move->opt == 1)
+    {
+      LS_2hopt_move(solPtr,move->delta,move->edge0fst,move->edge0snd,
+                    move->node,move->edge1fst,move->edge1snd);
+      LS_activate(solPtr,move->node);
+    }
+  else
+    {
+      LS_or_opt_move(solPtr,move->delta,move->edge0fst,move->edge0snd,
+                     move->node,move->last,move->edge1fst,move->edge1snd,
+                     move->opt == LSA_OR_OPT_REVERSED);
+      LS_activate(solPtr,move->node);
+      LS_activate(solPtr,move->last);
+    }
+  LS_activate(solPtr,move->edge0fst);
+  LS_activate(solPtr,move->edge0snd);
+  LS_activate(solPtr,move->edge1fst);
+  LS_activate(solPtr,move->edge1snd);
+}
 
 
+/* Threads evaluating the neighborhoods of a window of cities at once,
+   see LS_solution_set_evaluation_threads. The calling thread is one of
+   them, and takes cities as the others do. */
+struct LS_evaluators
+  {
+    int no_threads;
+    int tolerance;
+    pthread_t *threads;
+    pthread_mutex_t lock;
+    pthread_cond_t start, done;
+    unsigned int generation;         /* of the window being evaluated */
+    int pending;                     /* threads still evaluating it */
+    int quit;
+
+    /* The window */
+    LSA_delta_function delta_evaluation;
+    gsl_rng *r;
+    int *city;
+    int no_cities;
+    int next;                        /* next city to be taken */
+    int first_found;                 /* first city with an improving move */
+    int *found;                      /* -1 if the city has not been evaluated */
+    struct LS_move *move;
+    LS_List *view;                   /* what each thread evaluates on */
+  };
+
+/* Cities of a window for each thread: more of them balance the work
+   better, but more are evaluated in vain once a move is found */
+#define LS_EVALUATION_WINDOW_PER_THREAD 2
+
+static void
+LS_evaluate_window(struct LS_evaluators *e, int t)
+{
+  int k, first;
 
+  while ((k = __sync_fetch_and_add(&e->next,1)) < e->no_cities)
+    {
+      /* Without tolerance, only the first improving move is made */
+      if (!e->tolerance && k > *(volatile int *)&e->first_found)
+        break;
+      e->found[k] = LS_2hnndlbfls_scan(&e->view[t],e->city[k],
+                                       e->delta_evaluation,e->r,&e->move[k]);
+      if (e->found[k])
+        do
+          first = *(volatile int *)&e->first_found;
+        while (k < first &&
+               !__sync_bool_compare_and_swap(&e->first_found,first,k));
+    }
+}
 
-void
-LS_solution_free(LS_List *solPtr)
+static void
+*LS_evaluator(void *arg)
 {
-  int i;
-  for (i=0; i<solPtr->no_cities; i++)
+  struct LS_evaluators *e = ((LS_List *)arg)->evaluators;
+  int t = (LS_List *)arg - e->view;
+  unsigned int generation = 0;
+
+  pthread_mutex_lock(&e->lock);
+  for (;;)
     {
-      free(solPtr->array[i].realizations);
-      free(solPtr->array[i].two_opt_biased_realizations);
-      free(solPtr->array[i].two_h_opt_biased_realizations);
-      solPtr->array[i].realizations = NULL;
-      if (solPtr->array[i].neighbors)
-        {
-          free(solPtr->array[i].neighbors);
-          solPtr->array[i].neighbors = NULL;
-        }
+      while (e->generation == generation && !e->quit)
+        pthread_cond_wait(&e->start,&e->lock);
+      if (e->quit)
+        break;
+      generation = e->generation;
+      pthread_mutex_unlock(&e->lock);
 
-      //free(solPtr->array[i].geometric_biased_realizations);
-      //solPtr->array[i].geometric_biased_realizations=NULL;
+      LS_evaluate_window(e,t);
 
+      pthread_mutex_lock(&e->lock);
+      if (--e->pending == 0)
+        pthread_cond_signal(&e->done);
     }
-  free(solPtr->array);
-  solPtr->array = NULL;
-  free(solPtr->position_array);
-  free(solPtr->delta);
-  free(solPtr->realization_order);
+  pthread_mutex_unlock(&e->lock);
+  return NULL;
 }
 
-
 void
-LS_solution_print_all(LS_List solution)
+LS_solution_set_evaluation_threads(LS_List *solPtr, int no_threads,
+                                   int tolerance)
 {
-  int i, j;
-  struct LS_city *this;
+  struct LS_evaluators *e;
+  int t, window = LS_EVALUATION_WINDOW_PER_THREAD*no_threads;
 
-  printf("---------------------------------------\n");
-  for (i=0,this=solution.first;i<solution.no_cities;i++,this=this->next)
+  assert(!solPtr->evaluators);
+  if (no_threads <= 1)
+    return;
+  e = malloc(sizeof(struct LS_evaluators));
+  if (!e)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  e->no_threads = 1;
+  e->tolerance = tolerance;
+  e->generation = 0;
+  e->pending = 0;
+  e->quit = FALSE;
+  e->threads = malloc(no_threads*sizeof(pthread_t));
+  e->city = malloc(window*sizeof(int));
+  e->found = malloc(window*sizeof(int));
+  e->move = malloc(window*sizeof(struct LS_move));
+  e->view = malloc(no_threads*sizeof(LS_List));
+  if (!e->threads || !e->city || !e->found || !e->move || !e->view)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  pthread_mutex_init(&e->lock,NULL);
+  pthread_cond_init(&e->start,NULL);
+  pthread_cond_init(&e->done,NULL);
+  solPtr->evaluators = e;
+  for (t=0; t<no_threads; t++)
+    e->view[t].evaluators = e;
+  /* With fewer threads than asked for, the windows are just smaller */
+  for (t=1; t<no_threads; t++)
     {
-      printf("City: %5d\tnext: %5d\tprev: %5d\n",
-             this->city,(this->next)->city,(this->prev)->city);
-      printf("\tRealizations:\n\t");
-      for (j=0; j<solution.maximum_realizations; j++)
-        printf("%2d",this->realizations[j]);
-      printf("\n");
-      if (this->neighbors)
-        {
-          printf("\tNeighbors:\n\t");
-          for (j=0; j<solution.no_neighbors; j++)
-            printf("%2d",this->neighbors[j]);
-          printf("\n");
-        }
+      if (pthread_create(&e->threads[t],NULL,LS_evaluator,&e->view[t]))
+        break;
+      e->no_threads++;
     }
 }
 
+static void
+LS_evaluators_free(struct LS_evaluators *e)
+{
+  int t;
+
+  pthread_mutex_lock(&e->lock);
+  e->quit = TRUE;
+  pthread_cond_broadcast(&e->start);
+  pthread_mutex_unlock(&e->lock);
+  for (t=1; t<e->no_threads; t++)
+    pthread_join(e->threads[t],NULL);
+  pthread_mutex_destroy(&e->lock);
+  pthread_cond_destroy(&e->start);
+  pthread_cond_destroy(&e->done);
+  free(e->threads);
+  free(e->city);
+  free(e->found);
+  free(e->move);
+  free(e->view);
+  free(e);
+}
 
-
-
-
-void
-LS_solution_print_aux(LS_List solution)
+#ifdef LS_EXTRA_STATS_OUTPUT
+/* Add to the solution the evaluations counted in a view of it made
+   when the solution was origin */
+static void
+LS_add_statistics(LS_List *solPtr, const LS_List *view, const LS_List *origin)
 {
-  int i;
-  struct LS_city *this;
-  this = solution.first;
-  for (i=0; i<solution.no_cities; i++,this=this->next)
-    printf("%5d",this->city);
+  solPtr->solutions_explored += view->solutions_explored - origin->solutions_explored;
+  solPtr->samples_used += view->samples_used - origin->samples_used;
+  solPtr->two_opt_scans_made += view->two_opt_scans_made - origin->two_opt_scans_made;
+  solPtr->two_h_opt_scans_made += view->two_h_opt_scans_made - origin->two_h_opt_scans_made;
 }
+#endif
 
-void
-LS_solution_print_aux1(LS_List solution)
+/* A step of the 2.5-exchange local search evaluating windows of
+   cities in parallel against the same tour. The cities of a window
+   before the first one with an improving move have none, as in the
+   serial step; that move is made, and so the step makes the move of
+   the serial step. With a tolerance, up to that many of the following
+   improving moves of the window are made as well, if none of their
+   cities has been changed by the moves made before them; the others
+   are discarded, their cities being looked at again. */
+static double
+LS_2hnndlbfls_parallel_step(LS_List *solPtr, gsl_rng *r, int sampling_type)
 {
+  struct LS_evaluators *e = solPtr->evaluators;
+  int k, t, no_moves, window = LS_EVALUATION_WINDOW_PER_THREAD*e->no_threads;
+  double delta;
+  struct LS_move *move;
+#ifdef LS_EXTRA_STATS_OUTPUT
+  LS_List origin;
+#endif
 
+  e->delta_evaluation = LS_delta_evaluation(sampling_type);
+  e->r = r;
+  for (;;)
+    {
+      /* The cities of the window are taken out of the heap while they
+         are evaluated */
+      for (e->no_cities=0; solPtr->no_active && e->no_cities<window; )
+        {
+          e->found[e->no_cities] = -1;
+          e->city[e->no_cities++] = LS_active_pop(solPtr);
+        }
+      if (!e->no_cities)
+        break;
 
-  int no_cities=solution.no_cities;
-  double expc = 0.0,partial=0.0;
-  int i,r,s;
-  double* prob_vec;
-  double** Q;
-  long int* t;
-  struct LS_city *this;
+      for (t=0; t<e->no_threads; t++)
+        {
+          e->view[t] = *solPtr;
+          e->view[t].evaluators = e;
+        }
+      e->next = 0;
+      e->first_found = e->no_cities;
+      pthread_mutex_lock(&e->lock);
+      e->generation++;
+      e->pending = e->no_threads-1;
+      pthread_cond_broadcast(&e->start);
+      pthread_mutex_unlock(&e->lock);
+      LS_evaluate_window(e,0);
+      pthread_mutex_lock(&e->lock);
+      while (e->pending)
+        pthread_cond_wait(&e->done,&e->lock);
+      pthread_mutex_unlock(&e->lock);
+#ifdef LS_EXTRA_STATS_OUTPUT
+      origin = *solPtr;
+      for (t=0; t<e->no_threads; t++)
+        LS_add_statistics(solPtr,&e->view[t],&origin);
+#endif
 
+      for (k=0; k<e->first_found; k++)
+        solPtr->array[e->city[k]].dlb = 1;
+      if (e->first_found == e->no_cities)
+        continue;
+      for (k=e->first_found; k<e->no_cities; k++)
+        LS_active_push(solPtr,e->city[k]);
 
-  t = (long int *) malloc(no_cities*sizeof(long int));
-  if (!t)
+      LS_make_move(solPtr,&e->move[e->first_found]);
+      delta = e->move[e->first_found].delta;
+      for (k=e->first_found+1, no_moves=0;
+           k<e->no_cities && no_moves<e->tolerance; k++)
+        {
+          move = &e->move[k];
+          if (e->found[k] != TRUE || !LS_move_is_current(solPtr,move))
+            continue;
+          /* The estimate may involve cities beyond those of the move,
+             which the moves made before may have changed */
+          move->delta = e->delta_evaluation(solPtr,move->edge0fst,move->edge0snd,
+                                            move->node,move->edge1fst,move->edge1snd,
+                                            r,move->opt);
+          if (!solPtr->move_status)
+            continue;
+          LS_make_move(solPtr,move);
+          delta += move->delta;
+          no_moves++;
+        }
+      solPtr->move_status = TRUE;
+      return delta;
+    }
+
+  solPtr->move_status = FALSE;
+  return 0.0;
+}
+
+
+/* The moves found in a sweep, see LS_solution_set_sweep */
+struct LS_sweep
+  {
+    int *city;                       /* from which each move was found */
+    struct LS_move *move;
+    int *skipped;                    /* cities left for the next step */
+    char *taken;                     /* whether a city is one of a move
+                                        found in the step */
+  };
+
+void
+LS_solution_set_sweep(LS_List *solPtr)
+{
+  struct LS_sweep *sweep;
+
+  if (solPtr->sweep)
+    return;
+  sweep = malloc(sizeof(struct LS_sweep));
+  if (!sweep)
     error(EXIT_FAILURE,0,"Cannot allocate memory");
+  sweep->city = malloc(solPtr->no_cities*sizeof(int));
+  sweep->move = malloc(solPtr->no_cities*sizeof(struct LS_move));
+  sweep->skipped = malloc(solPtr->no_cities*sizeof(int));
+  sweep->taken = calloc(solPtr->no_cities,sizeof(char));
+  if (!sweep->city || !sweep->move || !sweep->skipped || !sweep->taken)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  solPtr->sweep = sweep;
+}
 
-  this = solution.first;
-  for (i=0; i<solution.no_cities; i++,this=this->next)
+static void
+LS_sweep_free(struct LS_sweep *sweep)
+{
+  free(sweep->city);
+  free(sweep->move);
+  free(sweep->skipped);
+  free(sweep->taken);
+  free(sweep);
+}
+
+/* Whether the edges removed by a move are still those of the tour. If
+   they are all the other way round, as inside a path reversed by a
+   move made since, the move is turned around, which leaves the tour it
+   makes the same. */
+static int
+LS_move_is_in_tour(const LS_List *solPtr, struct LS_move *move)
+{
+  int help, last;
+
+  if (move->node < 0)
     {
-      t[i]=this->city;
+      if (LS_NEXT(solPtr,move->edge0fst) == move->edge0snd &&
+          LS_NEXT(solPtr,move->edge1fst) == move->edge1snd)
+        return TRUE;
+      if (LS_NEXT(solPtr,move->edge0snd) != move->edge0fst ||
+          LS_NEXT(solPtr,move->edge1snd) != move->edge1fst)
+        return FALSE;
+    }
+  else
+    {
+      /* The segment has to be the same, and to leave out edge0fst and
+         edge0snd */
+      if (LS_NEXT(solPtr,move->edge0fst) == move->edge0snd &&
+          LS_NEXT(solPtr,move->edge1fst) == move->node)
+        {
+          last = LS_or_opt_segment(solPtr,move->node,move->length,
+                                   move->edge0fst,move->edge0snd);
+          return last == move->last && LS_NEXT(solPtr,last) == move->edge1snd;
+        }
+      if (LS_NEXT(solPtr,move->edge0snd) != move->edge0fst ||
+          LS_NEXT(solPtr,move->edge1snd) != move->last)
+        return FALSE;
+      last = LS_or_opt_segment(solPtr,move->last,move->length,
+                               move->edge0fst,move->edge0snd);
+      if (last != move->node || LS_NEXT(solPtr,last) != move->edge1fst)
+        return FALSE;
+      move->node = move->last;
+      move->last = last;
+    }
+  help = move->edge0fst;
+  move->edge0fst = move->edge0snd;
+  move->edge0snd = help;
+  help = move->edge1fst;
+  move->edge1fst = move->edge1snd;
+  move->edge1snd = help;
+  return TRUE;
+}
+
+/* Mark the cities of a move found in a sweep as taken, or not */
+static void
+LS_sweep_take(const LS_List *solPtr, const struct LS_move *move, char taken)
+{
+  int k, city;
+
+  solPtr->sweep->taken[move->edge0fst] = taken;
+  solPtr->sweep->taken[move->edge0snd] = taken;
+  solPtr->sweep->taken[move->edge1fst] = taken;
+  solPtr->sweep->taken[move->edge1snd] = taken;
+  for (k=0, city=move->node; k<move->length; k++, city=LS_NEXT(solPtr,city))
+    solPtr->sweep->taken[city] = taken;
+}
+
+/* A step of the 2.5-exchange local search looking at all the active
+   cities against the same tour, and then making the improving moves
+   found in their order. The cities of a move found are not looked at
+   in the same step, a move from them being likely to remove the same
+   edges. The first move is made as found; each of the others is made
+   if the moves made before it have left its edges in the tour, and if
+   it is still improving on the tour they left. The cities of the moves
+   that are not made stay active. */
+static double
+LS_2hnndlbfls_sweep_step(LS_List *solPtr, gsl_rng *r, int sampling_type)
+{
+  struct LS_sweep *sweep = solPtr->sweep;
+  LSA_delta_function delta_evaluation = LS_delta_evaluation(sampling_type);
+  struct LS_move *move;
+  int k, this_city, no_found = 0, no_skipped = 0, no_moves = 0;
+  double delta = 0.0;
 
+  while (solPtr->no_active)
+    {
+      this_city = LS_active_pop(solPtr);
+      if (sweep->taken[this_city])
+        sweep->skipped[no_skipped++] = this_city;
+      else if (LS_2hnndlbfls_scan(solPtr,this_city,delta_evaluation,
+                                  r,&sweep->move[no_found]))
+        {
+          LS_sweep_take(solPtr,&sweep->move[no_found],1);
+          sweep->city[no_found++] = this_city;
+        }
+      else
+        solPtr->array[this_city].dlb = 1;
+    }
+  for (k=0; k<no_skipped; k++)
+    LS_active_push(solPtr,sweep->skipped[k]);
+  for (k=0; k<no_found; k++)
+    {
+      LS_active_push(solPtr,sweep->city[k]);
+      LS_sweep_take(solPtr,&sweep->move[k],0);
     }
 
-  prob_vec = (double *) malloc(no_cities*sizeof(double));
-  if (!prob_vec)
-    error(EXIT_FAILURE,0,"Cannot allocate memory");
-  for(i=0; i<no_cities; i++)
+  for (k=0; k<no_found; k++)
     {
-      prob_vec[i]= solution.array[i].probability;
+      move = &sweep->move[k];
+      if (no_moves)
+        {
+          if (!LS_move_is_in_tour(solPtr,move))
+            continue;
+          move->delta = delta_evaluation(solPtr,move->edge0fst,move->edge0snd,
+                                         move->node,move->edge1fst,move->edge1snd,
+                                         r,move->opt);
+          if (!solPtr->move_status)
+            continue;
+        }
+      LS_make_move(solPtr,move);
+      delta += move->delta;
+      no_moves++;
     }
+  solPtr->move_status = no_moves > 0;
+  return delta;
+}
+
 
-  Q = malloc(no_cities*sizeof(double *));
-  if(!Q)
+/* The breadth of the variable-depth search: the number of moves tried
+   at each level of the chain, 1 beyond those given */
+#define LS_LK_MAX_BREADTH 5
+static const int LS_lk_breadth[] = {LS_LK_MAX_BREADTH, 3};
+#define LS_LK_BREADTH_LEVELS ((int)(sizeof(LS_lk_breadth)/sizeof(LS_lk_breadth[0])))
+
+/* The chain of moves of a variable-depth search. Each move t removes
+   the edges (t[0],t[1]) and (t[3],t[2]) and adds (t[0],t[3]) and
+   (t[1],t[2]), t[0] being the first city of the chain. */
+struct LS_lk
+  {
+    int move[LS_LK_MAX_DEPTH][4];
+    int no_steps;
+    int sampling_type;
+    int no_realizations;             /* on which the chain is estimated */
+    int no_blocks;                   /* of them estimated so far */
+    int rejected;                    /* number of moves of the prefix of
+                                        the chain found not to improve,
+                                        0 if none */
+    int stride;
+    double *delta;                   /* of the first i moves of the
+                                        chain from delta+i*stride, see
+                                        LSA_2opt_chain_delta; only
+                                        delta[0] with the approximation */
+    double mean;                     /* of the chain made */
+  };
+
+void
+LS_solution_set_variable_depth(LS_List *solPtr)
+{
+  struct LS_lk *lk;
+
+  if (solPtr->lk)
+    return;
+  lk = malloc(sizeof(struct LS_lk));
+  if (!lk)
     error(EXIT_FAILURE,0,"Cannot allocate memory");
+  lk->stride = solPtr->realization_words*LS_REALIZATION_WORD_BITS;
+  lk->delta = malloc((LS_LK_MAX_DEPTH+1)*lk->stride*sizeof(double));
+  if (!lk->delta)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  solPtr->lk = lk;
+}
 
-  for(i=0; i < no_cities; i++)
+static void
+LS_lk_free(struct LS_lk *lk)
+{
+  free(lk->delta);
+  free(lk);
+}
+
+/* Make the move t of the chain, see struct LS_lk; t[1] is next to
+   t[0], and t[3] next to t[2] on the same side */
+static void
+LS_lk_exchange(LS_List *solPtr, int t0, int t1, int t2, int t3)
+{
+  if (LS_NEXT(solPtr,t0) == t1)
+    LS_2opt_move(solPtr,0.0,t0,t1,t3,t2);
+  else
+    LS_2opt_move(solPtr,0.0,t1,t0,t2,t3);
+}
+
+/* Estimate the move of the chain at level, before it is made, on the
+   blocks from from_block to to_block-1, adding its deltas to those of
+   the moves before it */
+static void
+LS_lk_estimate(LS_List *solPtr, struct LS_lk *lk, int level,
+               int from_block, int to_block)
+{
+  const int *t = lk->move[level];
+  const double *before = lk->delta + level*lk->stride;
+  double *delta = lk->delta + (level+1)*lk->stride;
+  int k;
+
+  if (lk->sampling_type == LSX_SAMPLING_TYPE)
     {
-      Q[i] = malloc(no_cities*sizeof(double));
-      if(!Q[i])
-        error(EXIT_FAILURE,0,"Cannot allocate memory");
+      if (LS_NEXT(solPtr,t[0]) == t[1])
+        delta[0] = before[0] + LSX_delta(solPtr,t[0],t[1],-1,t[3],t[2],NULL,0);
+      else
+        delta[0] = before[0] + LSX_delta(solPtr,t[1],t[0],-1,t[2],t[3],NULL,0);
+      return;
     }
-  for(i=0; i<no_cities; i++)
+  for (k=from_block*LS_REALIZATION_WORD_BITS; k<to_block*LS_REALIZATION_WORD_BITS; k++)
+    delta[k] = before[k];
+  if (LS_NEXT(solPtr,t[0]) == t[1])
+    LSA_2opt_chain_delta(solPtr,t[0],t[1],t[3],t[2],lk->no_realizations,
+                         from_block,to_block,delta);
+  else
+    LSA_2opt_chain_delta(solPtr,t[1],t[0],t[2],t[3],lk->no_realizations,
+                         from_block,to_block,delta);
+}
+
+/* Estimate and make one more move of the chain */
+static void
+LS_lk_push(LS_List *solPtr, struct LS_lk *lk, int t0, int t1, int t2, int t3)
+{
+  int *t = lk->move[lk->no_steps];
+
+  t[0] = t0;
+  t[1] = t1;
+  t[2] = t2;
+  t[3] = t3;
+  LS_lk_estimate(solPtr,lk,lk->no_steps,0,lk->no_blocks);
+  LS_lk_exchange(solPtr,t0,t1,t2,t3);
+  lk->no_steps++;
+}
+
+/* Undo the last move of the chain */
+static void
+LS_lk_pop(LS_List *solPtr, struct LS_lk *lk)
+{
+  const int *t = lk->move[--lk->no_steps];
+
+  LS_lk_exchange(solPtr,t[0],t[3],t[2],t[1]);
+  if (lk->rejected > lk->no_steps)
+    lk->rejected = 0;
+}
+
+/* Estimate the moves of the chain on the blocks up to no_blocks-1 as
+   well: the moves are undone, and made again from the first one, each
+   being estimated on the tour it was made on */
+static void
+LS_lk_more_blocks(LS_List *solPtr, struct LS_lk *lk, int no_blocks)
+{
+  const int *t;
+  int level;
+
+  for (level=lk->no_steps-1; level>=0; level--)
+    {
+      t = lk->move[level];
+      LS_lk_exchange(solPtr,t[0],t[3],t[2],t[1]);
+    }
+  for (level=0; level<lk->no_steps; level++)
+    {
+      t = lk->move[level];
+      LS_lk_estimate(solPtr,lk,level,lk->no_blocks,no_blocks);
+      LS_lk_exchange(solPtr,t[0],t[1],t[2],t[3]);
+    }
+  lk->no_blocks = no_blocks;
+}
+
+/* Mean delta of the first no_steps moves of the chain on the
+   realizations estimated so far */
+static double
+LS_lk_mean(const LS_List *solPtr, const struct LS_lk *lk, int no_steps)
+{
+  double mean;
+
+  if (lk->sampling_type == LSX_SAMPLING_TYPE)
+    return lk->delta[no_steps*lk->stride];
+  LSA_chain_test(solPtr,lk->delta+no_steps*lk->stride,lk->no_realizations,
+                 lk->no_blocks,FALSE,&mean);
+  return mean;
+}
+
+/* Whether the first no_steps moves of the chain improve the solution,
+   as the moves of the local search are evaluated with the type of
+   sampling: with the adaptive sampling, the chain is estimated on more
+   realizations until the t-test is significant */
+static int
+LS_lk_improves(LS_List *solPtr, struct LS_lk *lk, int no_steps)
+{
+  int improves;
+
+  if (lk->sampling_type == LSX_SAMPLING_TYPE)
+    {
+      lk->mean = lk->delta[no_steps*lk->stride];
+      return lk->mean < -LSX_MIN_IMPROVEMENT;
+    }
+  while ((improves = LSA_chain_test(solPtr,lk->delta+no_steps*lk->stride,
+                                    lk->no_realizations,lk->no_blocks,
+                                    lk->sampling_type != 0,&lk->mean)) < 0)
+    LS_lk_more_blocks(solPtr,lk,GSL_MIN(2*lk->no_blocks,
+                                        LS_REALIZATION_NO_WORDS(lk->no_realizations)));
+  return improves;
+}
+
+/* Whether the chain has added the edge (a,b), or has removed it if
+   removed. The last move of an Or-3opt step, the only one not from
+   t[0] of the first move, adds (t[0],t[3]) as well, see LS_lk_or3opt. */
+static int
+LS_lk_changed(const struct LS_lk *lk, int a, int b, int removed)
+{
+  const int *t;
+  int k, c, d;
+
+  for (k=0; k<lk->no_steps; k++)
+    {
+      t = lk->move[k];
+      c = removed ? t[3] : t[1];
+      d = t[2];
+      if ((c == a && d == b) || (c == b && d == a))
+        return TRUE;
+      if (!removed && t[0] != lk->move[0][0] &&
+          ((t[0] == a && t[3] == b) || (t[0] == b && t[3] == a)))
+        return TRUE;
+    }
+  t = lk->move[0];
+  return removed && lk->no_steps &&
+         ((t[0] == a && t[1] == b) || (t[0] == b && t[1] == a));
+}
+
+static int
+LS_lk_or3opt(LS_List *solPtr, struct LS_lk *lk, int t0, int t1, LS_DISTANCE gain);
+
+/* Extend the chain, whose last move has left t0 next to t1, with a
+   move removing (t0,t1) as the Lin-Kernighan heuristic does: t2 is a
+   neighbor of t1 closer to it than gain, the length of the edges
+   removed by the chain minus those added but (t0,t1), and t3 is next
+   to t2 on the side of t0 from t1. Edges added by the chain are not
+   removed, nor removed ones added back. The moves with the longest
+   (t2,t3) minus (t1,t2) are tried first, up to the breadth of the
+   level, and the chain is extended depth first up to LS_LK_MAX_DEPTH
+   moves. Where it cannot be extended, the best of its prefixes, that
+   of best moves with mean delta best_mean, is tested; if it improves
+   the solution, the chain is cut there and kept. If no chain from its
+   first move improves, an Or-3opt step is tried instead, see
+   LS_lk_or3opt. */
+static int
+LS_lk_extend(LS_List *solPtr, struct LS_lk *lk, int t0, int t1,
+             LS_DISTANCE gain, int best, double best_mean)
+{
+  int candidate[LS_LK_MAX_BREADTH][2];
+  LS_DISTANCE value[LS_LK_MAX_BREADTH], v;
+  int level = lk->no_steps;
+  int breadth = (level < LS_LK_BREADTH_LEVELS) ? LS_lk_breadth[level] : 1;
+  int forward = (LS_NEXT(solPtr,t0) == t1);
+  int no_candidates = 0, j, k, t2, t3;
+  double mean;
+
+  for (j=1; level<LS_LK_MAX_DEPTH && j<solPtr->array[t1].no_neighbors &&
+         solPtr->array[t1].neighbor_distances[j]<gain; j++)
     {
-      Q[t[i]][t[i]] = 0.0;
-      Q[t[i]][t[(i+1)%no_cities]]= 1.0;
-      for(s=2; s<no_cities; s++)
+      t2 = solPtr->array[t1].neighbors[j];
+      t3 = forward ? LS_PREV(solPtr,t2) : LS_NEXT(solPtr,t2);
+      if (t2 == t0 || t3 == t1 ||
+          LS_lk_changed(lk,t2,t3,FALSE) || LS_lk_changed(lk,t1,t2,TRUE))
+        continue;
+      v = LS_DIST(solPtr,t2,t3) - solPtr->array[t1].neighbor_distances[j];
+      if (no_candidates == breadth && value[breadth-1] >= v)
+        continue;
+      if (no_candidates < breadth)
+        no_candidates++;
+      for (k=no_candidates-1; k>0 && value[k-1]<v; k--)
         {
-          Q[t[i]][t[(i+s)%no_cities]] = Q[t[i]][t[(i+s-1)%no_cities]]*(1.0 - prob_vec[t[(i+s-1)%no_cities]]);
+          value[k] = value[k-1];
+          candidate[k][0] = candidate[k-1][0];
+          candidate[k][1] = candidate[k-1][1];
         }
+      value[k] = v;
+      candidate[k][0] = t2;
+      candidate[k][1] = t3;
     }
 
-  for (i=0; i<no_cities; i++)
+  for (k=0; k<no_candidates; k++)
+    {
+      t2 = candidate[k][0];
+      t3 = candidate[k][1];
+      LS_lk_push(solPtr,lk,t0,t1,t2,t3);
+      mean = LS_lk_mean(solPtr,lk,lk->no_steps);
+      if (mean < best_mean)
+        {
+          if (LS_lk_extend(solPtr,lk,t0,t3,gain-LS_DIST(solPtr,t1,t2)+LS_DIST(solPtr,t2,t3),
+                           lk->no_steps,mean))
+            return TRUE;
+        }
+      else if (LS_lk_extend(solPtr,lk,t0,t3,gain-LS_DIST(solPtr,t1,t2)+LS_DIST(solPtr,t2,t3),
+                            best,best_mean))
+        return TRUE;
+      LS_lk_pop(solPtr,lk);
+    }
+
+  if (level == 0)
+    return LS_lk_or3opt(solPtr,lk,t0,t1,gain);
+  if (no_candidates || !best || best == lk->rejected)
+    return FALSE;
+  if (!LS_lk_improves(solPtr,lk,best))
+    {
+      lk->rejected = best;
+      return FALSE;
+    }
+  while (lk->no_steps > best)
+    LS_lk_pop(solPtr,lk);
+  return TRUE;
+}
+
+/* The first step of a chain as the alternative of the Lin-Kernighan
+   heuristic: t2 is a neighbor of t1 as in LS_lk_extend, but t3 is next
+   to t2 on the other side, so that the 2-exchange would split the tour.
+   t4, a neighbor of t3 on the path from t1 to t2, and t5, next to it
+   towards t2, complete a sequential 3-exchange which moves the path
+   from t1 to t4 between t2 and t3, an Or-opt move if it is short:
+
+     t0 t1 ... t4 t5 ... t2 t3   becomes   t0 t5 ... t2 t1 ... t4 t3
+
+   It is made by three 2-exchanges, reversing the path from t1 to t2,
+   then that from t2 to t5, and then that from t4 to t1, the second one
+   being left out if t5 is t2 and the last one if t4 is t1. The first
+   two remove (t0,t1) and (t0,t2) as the moves of LS_lk_extend, so that
+   the chain is then extended from t5 as from any move; the deltas of
+   the three are added up on each realization as for the others. The
+   steps with the largest length of the edges removed minus those added
+   but (t0,t5) are tried first, up to the breadth of the first level. */
+static int
+LS_lk_or3opt(LS_List *solPtr, struct LS_lk *lk, int t0, int t1, LS_DISTANCE gain)
+{
+  int candidate[LS_LK_MAX_BREADTH][4];
+  LS_DISTANCE value[LS_LK_MAX_BREADTH], v, g;
+  int breadth = LS_lk_breadth[0];
+  int forward = (LS_NEXT(solPtr,t0) == t1);
+  int no_candidates = 0, no_moves, i, j, k, t2, t3, t4, t5;
+  double mean;
+
+  for (i=1; i<solPtr->array[t1].no_neighbors &&
+         solPtr->array[t1].neighbor_distances[i]<gain; i++)
     {
-      for(r=0; r< no_cities ; r++)
+      t2 = solPtr->array[t1].neighbors[i];
+      t3 = forward ? LS_NEXT(solPtr,t2) : LS_PREV(solPtr,t2);
+      if (t2 == t0 || t3 == t0)
+        continue;
+      g = gain - solPtr->array[t1].neighbor_distances[i] + LS_DIST(solPtr,t2,t3);
+      for (j=1; j<solPtr->array[t3].no_neighbors &&
+             solPtr->array[t3].neighbor_distances[j]<g; j++)
         {
-          if(i != r )
+          t4 = solPtr->array[t3].neighbors[j];
+          if (t4 == t2 || !(forward ? LS_BETWEEN(solPtr,t1,t4,t2)
+                                    : LS_BETWEEN(solPtr,t2,t4,t1)))
+            continue;
+          t5 = forward ? LS_NEXT(solPtr,t4) : LS_PREV(solPtr,t4);
+          v = g - solPtr->array[t3].neighbor_distances[j] + LS_DIST(solPtr,t4,t5);
+          if (no_candidates == breadth && value[breadth-1] >= v)
+            continue;
+          if (no_candidates < breadth)
+            no_candidates++;
+          for (k=no_candidates-1; k>0 && value[k-1]<v; k--)
             {
-              partial = solution.distances[t[i]][t[r]]
-                        * prob_vec[t[i]]
-                        * prob_vec[t[r]]
-                        * Q[t[i]][t[r]];
-              expc += partial;
+              value[k] = value[k-1];
+              candidate[k][0] = candidate[k-1][0];
+              candidate[k][1] = candidate[k-1][1];
+              candidate[k][2] = candidate[k-1][2];
+              candidate[k][3] = candidate[k-1][3];
             }
+          value[k] = v;
+          candidate[k][0] = t2;
+          candidate[k][1] = t3;
+          candidate[k][2] = t4;
+          candidate[k][3] = t5;
+        }
+    }
+
+  for (k=0; k<no_candidates; k++)
+    {
+      t2 = candidate[k][0];
+      t3 = candidate[k][1];
+      t4 = candidate[k][2];
+      t5 = candidate[k][3];
+      LS_lk_push(solPtr,lk,t0,t1,t3,t2);
+      no_moves = 1;
+      if (t5 != t2)
+        {
+          LS_lk_push(solPtr,lk,t0,t2,t4,t5);
+          no_moves++;
+        }
+      if (t4 != t1)
+        {
+          LS_lk_push(solPtr,lk,t2,t4,t3,t1);
+          no_moves++;
+        }
+      mean = LS_lk_mean(solPtr,lk,lk->no_steps);
+      if (mean < 0.0)
+        {
+          if (LS_lk_extend(solPtr,lk,t0,t5,value[k],lk->no_steps,mean))
+            return TRUE;
+        }
+      else if (LS_lk_extend(solPtr,lk,t0,t5,value[k],0,0.0))
+        return TRUE;
+      while (no_moves--)
+        LS_lk_pop(solPtr,lk);
+    }
+  return FALSE;
+}
+
+/* Look for an improving chain of moves from this_city, removing first
+   the edge to its successor and then to its predecessor; if one is
+   found, it is made and its mean delta stored in delta */
+static int
+LS_lk_search(LS_List *solPtr, int this_city, int sampling_type, double *delta)
+{
+  struct LS_lk *lk = solPtr->lk;
+  int k, j, t0;
+
+  lk->sampling_type = sampling_type;
+  if (sampling_type == 0)
+    lk->no_realizations = GSL_MIN(solPtr->no_realizations,solPtr->maximum_realizations);
+  else
+    lk->no_realizations = solPtr->maximum_realizations;
+  for (k=0; k<lk->stride; k++)
+    lk->delta[k] = 0.0;
+
+  for (k=0; k<2; k++)
+    {
+      t0 = k ? LS_PREV(solPtr,this_city) : LS_NEXT(solPtr,this_city);
+      /* With the adaptive sampling the chains are first estimated on
+         one block, otherwise on all the realizations */
+      lk->no_blocks = (sampling_type == 1 || sampling_type == 2)
+                      ? 1 : LS_REALIZATION_NO_WORDS(lk->no_realizations);
+      lk->no_steps = 0;
+      lk->rejected = 0;
+      if (LS_lk_extend(solPtr,lk,t0,this_city,LS_DIST(solPtr,t0,this_city),0,0.0))
+        {
+          for (j=0; j<lk->no_steps; j++)
+            {
+              LS_activate(solPtr,lk->move[j][0]);
+              LS_activate(solPtr,lk->move[j][1]);
+              LS_activate(solPtr,lk->move[j][2]);
+              LS_activate(solPtr,lk->move[j][3]);
+            }
+          solPtr->move_status = TRUE;
+          *delta = lk->mean;
+          return TRUE;
+        }
+    }
+  solPtr->move_status = FALSE;
+  return FALSE;
+}
+
+
+double
+LS_2hnndlbfls_step(LS_List *solPtr, gsl_rng *r, int sampling_type)
+{
+  LSA_delta_function delta_evaluation;
+  struct LS_move move;
+  int this_city;
+  double delta;
+
+  if (solPtr->evaluators)
+    return LS_2hnndlbfls_parallel_step(solPtr,r,sampling_type);
+  if (solPtr->sweep)
+    return LS_2hnndlbfls_sweep_step(solPtr,r,sampling_type);
+
+  delta_evaluation = LS_delta_evaluation(sampling_type);
+  while ((this_city = LS_active_first(solPtr)) >= 0)
+    {
+      if (LS_2hnndlbfls_scan(solPtr,this_city,delta_evaluation,r,&move))
+        {
+          LS_make_move(solPtr,&move);
+          return(move.delta);
+        }
+      if (solPtr->lk && LS_lk_search(solPtr,this_city,sampling_type,&delta))
+        return delta;
+
+      /* If we are here, its because no improving neighboring
+      solution was found starting from `this_city' */
+      LS_deactivate_first(solPtr);
+    }
+
+
+  /* If we are here, its because no improving neighboring
+     solution was found starting from any city. We than report that
+     no improvement was made */
+  return 0.0;
+}
+
+
+void
+LS_reset_dlb(LS_List *solPtr, const int *order)
+{
+  int i;
+
+  if (order)
+    for (i=0; i<solPtr->no_cities; i++)
+      solPtr->rank[order[i]] = i;
+  /* Sorted on the rank, the cities make a heap already */
+  for (i=0; i<solPtr->no_cities; i++)
+    {
+      solPtr->array[i].dlb=0;
+      solPtr->active[solPtr->rank[i]] = i;
+    }
+  solPtr->no_active = solPtr->no_cities;
+}
+
+
+
+
+
+
+void
+LS_solution_free(LS_List *solPtr)
+{
+  int i;
+  for (i=0; i<solPtr->no_cities; i++)
+    {
+      solPtr->array[i].realizations = NULL;
+      solPtr->array[i].two_opt_biased_realizations = NULL;
+      solPtr->array[i].two_h_opt_biased_realizations = NULL;
+      if (solPtr->array[i].neighbors && !solPtr->shared_neighbors)
+        free(solPtr->array[i].neighbors);
+      solPtr->array[i].neighbors = NULL;
+      if (!solPtr->shared_neighbors)
+        free(solPtr->array[i].neighbor_distances);
+      solPtr->array[i].neighbor_distances = NULL;
+
+      //free(solPtr->array[i].geometric_biased_realizations);
+      //solPtr->array[i].geometric_biased_realizations=NULL;
+
+    }
+  free(solPtr->array);
+  solPtr->array = NULL;
+  free(solPtr->realization_store);
+  solPtr->realization_store = NULL;
+  free(solPtr->position_array);
+  free(solPtr->active);
+  free(solPtr->rank);
+  free(solPtr->delta);
+  free(solPtr->realization_order);
+  free(solPtr->block_order);
+  if (solPtr->evaluators)
+    LS_evaluators_free(solPtr->evaluators);
+  solPtr->evaluators = NULL;
+  if (solPtr->sweep)
+    LS_sweep_free(solPtr->sweep);
+  solPtr->sweep = NULL;
+  if (solPtr->lk)
+    LS_lk_free(solPtr->lk);
+  solPtr->lk = NULL;
+  if (solPtr->realization_pool)
+    LSA_realization_pool_free(solPtr->realization_pool);
+  solPtr->realization_pool = NULL;
+  free(solPtr->absent_power);
+  solPtr->absent_power = NULL;
+  if (solPtr->two_level)
+    LST_tour_free(solPtr->two_level);
+  solPtr->two_level = NULL;
+}
+
+
+void
+LS_solution_print_all(LS_List solution)
+{
+  int i, j;
+  struct LS_city *this;
+
+  printf("---------------------------------------\n");
+  for (i=0,this=solution.first;i<solution.no_cities;i++,this=LS_NEXT_CITY(&solution,this))
+    {
+      printf("City: %5d\tnext: %5d\tprev: %5d\n",
+             this->city,LS_NEXT(&solution,this->city),LS_PREV(&solution,this->city));
+      printf("\tRealizations:\n\t");
+      for (j=0; j<solution.maximum_realizations; j++)
+        printf("%2d",LS_REALIZATION_TEST(this->realizations,j));
+      printf("\n");
+      if (this->neighbors)
+        {
+          printf("\tNeighbors:\n\t");
+          for (j=0; j<this->no_neighbors; j++)
+            printf("%2d",this->neighbors[j]);
+          printf("\n");
         }
     }
+}
+
+
+
+
+
+void
+LS_solution_print_aux(LS_List solution)
+{
+  int i;
+  struct LS_city *this;
+  this = solution.first;
+  for (i=0; i<solution.no_cities; i++,this=LS_NEXT_CITY(&solution,this))
+    printf("%5d",this->city);
+}
+
+/* Distances from city to the cities of the tour, for
+   PTSP_expected_cost */
+static void
+LS_distance_row(long int city, const long int *tour, long int no_cities,
+                double *distance, void *data)
+{
+  const LS_List *solPtr = data;
+  long int r;
+
+  for (r=0; r<no_cities; r++)
+    distance[r] = LS_DIST(solPtr,city,tour[r]);
+}
+
+void
+LS_solution_print_aux1(LS_List solution)
+{
+  int no_cities=solution.no_cities;
+  double expc;
+  int i;
+  double* prob_vec;
+  long int* t;
+  struct LS_city *this;
+
+
+  t = (long int *) malloc(no_cities*sizeof(long int));
+  if (!t)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+
+  this = solution.first;
+  for (i=0; i<solution.no_cities; i++,this=LS_NEXT_CITY(&solution,this))
+    {
+      t[i]=this->city;
+
+    }
+
+  prob_vec = (double *) malloc(no_cities*sizeof(double));
+  if (!prob_vec)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for(i=0; i<no_cities; i++)
+    {
+      prob_vec[i]= solution.array[i].probability;
+    }
+
+  expc = PTSP_expected_cost(no_cities,t,prob_vec,LS_distance_row,&solution);
 
-  for(i=0; i < no_cities; i++)
-    free(Q[i]);
-  free(Q);
   free(prob_vec);
   printf("cost=%lf\n", expc);
   free(t);
@@ -870,6 +2111,39 @@ LS_solution_log(LS_List solution, int i)
 }
 
 
+double
+LS_solution_estimate_cost(LS_List solution, gsl_rng *r, int no_realizations)
+{
+  int i, k;
+  double *ran_num, sum = 0.0;
+  struct LS_city *this, *first, *last;
+
+  ran_num = malloc(solution.no_cities*sizeof(double));
+  if (!ran_num)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+
+  for (k=0; k<no_realizations; k++)
+    {
+      for (i=0; i<solution.no_cities; i++)
+        ran_num[i]=gsl_rng_uniform(r);
+      first = last = NULL;
+      for (i=0,this=solution.first; i<solution.no_cities; i++,this=LS_NEXT_CITY(&solution,this))
+        if (ran_num[this->city]<=this->probability)
+          {
+            if (last)
+              sum += LS_DIST(&solution,last->city,this->city);
+            else
+              first = this;
+            last = this;
+          }
+      if (first)
+        sum += LS_DIST(&solution,last->city,first->city);
+    }
+  free(ran_num);
+  return sum/no_realizations;
+}
+
+
 void
 LS_resample_realizations(LS_List solution, gsl_rng *r, int sampling_type)
 {
@@ -904,18 +2178,25 @@ LS_resample_realizations(LS_List solution, gsl_rng *r, int sampling_type)
 declared as `extern inline' in the file sampleLS.h */
 LS_List
 LS_solution_allocate(int no_cities,int no_realizations,
-                     const double *prob_vec, LS_DISTANCE **D,
+                     const double *prob_vec, LS_DISTANCE *D,
                      double alpha, int importance_sampling,
                      float deltaProb, float deltaDashProb,
                      float window_size_percent,float nodes_percent)
 {
   return LS_solution_allocate_aux(no_cities,no_realizations, prob_vec,
-                                  (const LS_DISTANCE **) D, alpha,
+                                  (const LS_DISTANCE *) D, alpha,
                                   importance_sampling, (double) deltaProb, (double) deltaDashProb,
                                   window_size_percent,nodes_percent);
 }
 
 
+void
+LS_solution_set_instance(LS_List *solPtr, problem *insPtr)
+{
+  solPtr->instance = insPtr;
+}
+
+
 void
 LS_solution_set_with_given_value(LS_List *solPtr, double value,
                                  const LS_SOLUTION_INT *apriori_solution)
@@ -924,8 +2205,27 @@ LS_solution_set_with_given_value(LS_List *solPtr, double value,
   solPtr->value = value;
 }
 
+/* Order the blocks of realizations as realization_order first takes
+   one of their realizations, so that the chains of the variable-depth
+   search, estimated block by block, see the realizations in another
+   order at each step with the adaptive sampling of type 1 too */
+static void
+LS_block_order_from_realizations(LS_List *solPtr)
+{
+  int i, k, no_blocks = 0, block;
+
+  for (i=0; i<solPtr->maximum_realizations && no_blocks<solPtr->realization_words; i++)
+    {
+      block = solPtr->realization_order[i]/LS_REALIZATION_WORD_BITS;
+      for (k=0; k<no_blocks && solPtr->block_order[k]!=block; k++)
+        ;
+      if (k == no_blocks)
+        solPtr->block_order[no_blocks++] = block;
+    }
+}
+
 void
-LS_Xnndlbfls_times(double (*LSstep)(LS_List*, const int*, gsl_rng *r, int sampling_type),
+LS_Xnndlbfls_times(double (*LSstep)(LS_List*, gsl_rng *r, int sampling_type),
                    void (*LSresample)(LS_List,gsl_rng*, int),
                    int K, LS_List *solPtr, gsl_rng *r,
                    double time, int verbose, int sampling_type)
@@ -939,13 +2239,15 @@ LS_Xnndlbfls_times(double (*LSstep)(LS_List*, const int*, gsl_rng *r, int sampli
     order[i]=i;
   gsl_ran_shuffle(r,order,solPtr->no_cities,sizeof(int));
 
-  LS_reset_dlb(solPtr);
+  LS_reset_dlb(solPtr,order);
+  free(order);
 
-  for (i=1;  ((solPtr->move_status)||m<0) && (!K||i<K) ; i++)
+  for (i=1;  ((solPtr->move_status)||m<0) && (!K||i<K) &&
+       (time<=0.0 || stopwatch_read()<time) ; i++)
     {
       if (LSresample)
         (*LSresample)(*solPtr,r,sampling_type);
-      m = (*LSstep)(solPtr,order,r,sampling_type);
+      m = (*LSstep)(solPtr,r,sampling_type);
       solPtr->value=m;
       if ((stopwatch_read()>=0.0) && (solPtr->move_status))
         {
@@ -953,14 +2255,28 @@ LS_Xnndlbfls_times(double (*LSstep)(LS_List*, const int*, gsl_rng *r, int sampli
           //LS_solution_print_aux1(*solPtr);
         }
 
-      gsl_ran_shuffle(r,solPtr->realization_order,solPtr->maximum_realizations,sizeof(int));
+      if (sampling_type==2)
+        gsl_ran_shuffle(r,solPtr->block_order,solPtr->realization_words,sizeof(int));
+      else
+        {
+          gsl_ran_shuffle(r,solPtr->realization_order,solPtr->maximum_realizations,sizeof(int));
+          if (solPtr->lk && sampling_type==1)
+            LS_block_order_from_realizations(solPtr);
+        }
 
+      if (solPtr->report && (*solPtr->report)(solPtr->report_data,i))
+        {
+          i++;
+          break;
+        }
+    }
+  solPtr->no_steps=i;
+  if (!solPtr->quiet)
+    {
+      LS_solution_log(*solPtr,i);
+      LS_solution_log(*solPtr,i);
     }
-  LS_solution_log(*solPtr,i);
-  LS_solution_log(*solPtr,i);
   //LS_solution_print_aux1(*solPtr);
-
-  free(order);
 }
 
 
@@ -1032,169 +2348,163 @@ LS_solution_compute_and_set_value(LS_List *solPtr)
 
 
 
+void
+LS_solution_cache_neighbor_distances(LS_List *solPtr, int city, int length)
+{
+  int j;
+  struct LS_city *this = &solPtr->array[city];
+
+  this->neighbor_distances = malloc(length*sizeof(LS_DISTANCE));
+  if (!this->neighbor_distances)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  this->no_neighbors = length;
+  for (j=0; j<length; j++)
+    this->neighbor_distances[j] = LS_DIST(solPtr,city,this->neighbors[j]);
+}
+
+
 void
 LS_solution_sort_quad_neighbors(problem *insPtr, LS_List *solPtr,int nn)
 {
   int i;
-  solPtr->no_neighbors = nn;
+  int n = solPtr->no_cities;
+  int nn_quad = GSL_MIN(nn,n)/4;
+  int length = 1 + GSL_MIN(4*nn_quad,n-1);
+  KD_tree tree = KD_tree_build(insPtr);
 
-  for (i=0; i<solPtr->no_cities; i++)
-    solPtr->array[i].neighbors =
-      LS_allocate_sort_quad_neighbors(insPtr,solPtr->distances,i,solPtr->no_cities,nn);
+  solPtr->no_neighbors = length;
+  for (i=0; i<n; i++)
+    {
+      solPtr->array[i].neighbors =
+        LS_allocate_sort_quad_neighbors(&tree,i,nn_quad,length);
+      LS_solution_cache_neighbor_distances(solPtr,i,length);
+    }
+  KD_tree_free(&tree);
 }
 
-int*
-LS_allocate_sort_quad_neighbors(problem *insPtr,const LS_DISTANCE **d,int node,int no_cities,int nn)
+static int
+LS_compare_neighbors(const void *a, const void *b)
 {
+  const KD_neighbor *p = a, *q = b;
 
-  int i;
-  int no_in_quadrant[5];
-  double n_xx, n_yy, c_xx, c_yy;
-  int check_nn;
-  int *distance_vector;
-  int *help_vector;
-  int *chosen;
-  int ncities=no_cities;
-  int nn_ls=nn;
-  int nn_quad;
-  int *m_nnear;
-  /*    printf("\n computing nearest neighbor lists, "); */
-
+  if (p->distance != q->distance)
+    return (p->distance < q->distance) ? -1 : 1;
+  return p->city - q->city;
+}
 
-  nn_ls = GSL_MIN(nn_ls,ncities);
-  nn_quad=nn_ls/4;
+int*
+LS_allocate_sort_quad_neighbors(const KD_tree *tree, int node,
+                                int nn_quad, int length)
+{
+  int i, j, quadrant, found, no_chosen;
+  KD_neighbor *chosen, *nearest;
+  int *m_nnear;
 
-  m_nnear = malloc(nn_ls*sizeof(int));
-  if (!m_nnear)
+  m_nnear = malloc(length*sizeof(int));
+  chosen = malloc(length*sizeof(KD_neighbor));
+  nearest = malloc(length*sizeof(KD_neighbor));
+  if (!m_nnear || !chosen || !nearest)
     error(EXIT_FAILURE,0,"Cannot allocate memory");
 
-  distance_vector = malloc(ncities*sizeof(int));
-  help_vector = malloc(ncities*sizeof(int));
-  chosen = malloc(ncities*sizeof(int));
+  /* The nn_quad nearest cities of each quadrant */
+  no_chosen = 0;
+  for (quadrant = KD_QUADRANT_1; quadrant <= KD_QUADRANT_4; quadrant++)
+    no_chosen += KD_tree_nearest(tree,node,nn_quad,quadrant,
+                                 chosen + no_chosen);
 
-  /*    for ( node = 0 ; node < ncities ; node++ ) { */ /* compute cnd-sets for all node */
+  /* Quadrants with fewer cities are made up for by the nearest cities
+     not chosen yet */
+  if (no_chosen < length - 1)
+    {
+      found = KD_tree_nearest(tree,node,length,KD_ALL_QUADRANTS,nearest);
+      for (i = 0; i < found && no_chosen < length - 1; i++)
+        {
+          if (nearest[i].city == node)
+            continue;
+          for (j = 0; j < no_chosen; j++)
+            if (chosen[j].city == nearest[i].city)
+              break;
+          if (j == no_chosen)
+            chosen[no_chosen++] = nearest[i];
+        }
+    }
+  assert(no_chosen == length - 1);
 
-  /*	m_nnear[node] = (LS_SOLUTION_INT *)(m_nnear + ncities) + node * nn_ls;*/
+  /* The exploration stops at the first neighbor farther than the
+     radius, so the list is sorted by distance */
+  qsort(chosen,no_chosen,sizeof(KD_neighbor),LS_compare_neighbors);
+  m_nnear[0] = node;
+  for (i = 0; i < no_chosen; i++)
+    m_nnear[i+1] = chosen[i].city;
 
+  free(chosen);
+  free(nearest);
+  return m_nnear;
+}
 
-  for ( i = 0 ; i < ncities ; i++ )
-    {  /* Copy distances from nodes to the others */
-      distance_vector[i] = d[node][i];
-      help_vector[i] = i;
-      chosen[i] = FALSE;
-    }
 
-  distance_vector[node] = LONG_MAX;  /* city is not nearest neighbour */
-  LS_sort(distance_vector, help_vector, 0, ncities-1);
-  if(node<ncities-2)
-    {
-      n_xx = insPtr->nodeptr[node+1].x;
-      n_yy = insPtr->nodeptr[node+1].y;
-    }
-  else
-    {
-      n_xx = insPtr->nodeptr[0].x;
-      n_yy = insPtr->nodeptr[0].y;
-    }
-  no_in_quadrant[1] = 0;
-  no_in_quadrant[2] = 0;
-  no_in_quadrant[3] = 0;
-  no_in_quadrant[4] = 0;
-  check_nn = 0;
-  for ( i = 0 ; i < ncities ; i++ )
+int
+LS_solution_sort_delaunay_neighbors(problem *insPtr, LS_List *solPtr,
+                                    int second_order)
+{
+  int i, j, k, c, d, length;
+  int n = solPtr->no_cities;
+  int *seen;
+  KD_neighbor *list;
+  DT_graph graph;
+
+  if (!DT_graph_build(insPtr,&graph))
+    return 0;
+  seen = malloc(n*sizeof(int));
+  list = malloc(n*sizeof(KD_neighbor));
+  if (!seen || !list)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (i=0; i<n; i++)
+    seen[i] = -1;
+
+  solPtr->no_neighbors = 0;
+  for (i=0; i<n; i++)
     {
-      if((help_vector[i]+1)==ncities)
-        {
-          c_xx = insPtr->nodeptr[0].x;
-          c_yy = insPtr->nodeptr[0].y;
-        }
-      else
-        {
-          c_xx = insPtr->nodeptr[help_vector[i]+1].x;
-          c_yy = insPtr->nodeptr[help_vector[i]+1].y;
-        }
-      if ( c_xx > n_xx && c_yy >= n_yy )
+      seen[i] = i;
+      length = 0;
+      for (j=graph.first[i]; j<graph.first[i+1]; j++)
         {
-          /* 1. Quadrant */
-          if ( no_in_quadrant[1] < nn_quad )
+          c = graph.city[j];
+          if (seen[c] != i)
             {
-              no_in_quadrant[1] += 1;
-              chosen[i] = TRUE;
-              check_nn++;
+              seen[c] = i;
+              list[length++].city = c;
             }
-        }
-      else if ( c_xx >= n_xx && c_yy < n_yy )
-        {
-          /* 2. Quadrant */
-          if ( no_in_quadrant[2] < nn_quad )
+          if (!second_order)
+            continue;
+          for (k=graph.first[c]; k<graph.first[c+1]; k++)
             {
-              no_in_quadrant[2] += 1;
-              chosen[i] = TRUE;
-              check_nn++;
-            }
-        }
-      else if ( c_xx < n_xx && c_yy <= n_yy )
-        {
-          /* 3. Quadrant */
-          if ( no_in_quadrant[3] < nn_quad )
-            {
-              no_in_quadrant[3] += 1;
-              chosen[i] = TRUE;
-              check_nn++;
-            }
-        }
-      else if ( c_xx <= n_xx && c_yy > n_yy )
-        {
-          /* 4. Quadrant */
-          if ( no_in_quadrant[4] < nn_quad )
-            {
-              no_in_quadrant[4] += 1;
-              chosen[i] = TRUE;
-              check_nn++;
-            }
-        }
-    }
-  if ( check_nn < 4 * nn_quad )
-    {
-      for ( i = 0 ; i < ncities ; i++ )
-        {
-          if( chosen[i] == FALSE )
-            {
-              chosen[i] = TRUE;
-              /*  		    printf(" %d ",i); */
-              check_nn++;
+              d = graph.city[k];
+              if (seen[d] != i)
+                {
+                  seen[d] = i;
+                  list[length++].city = d;
+                }
             }
-          if ( check_nn == 4 * nn_quad )
-            break;
         }
-    }
-
-  if ( check_nn != 4 * nn_quad )
-    exit(0);
+      for (j=0; j<length; j++)
+        list[j].distance = LS_INSTANCE_DIST(insPtr,i,list[j].city);
+      qsort(list,length,sizeof(KD_neighbor),LS_compare_neighbors);
 
-  check_nn = 0;
-  i = 0;
-  while ( i < ncities )
-    {
-      if ( chosen[i] )
-        {
-          m_nnear[check_nn] = help_vector[i];
-          check_nn += 1;
-          /*    		printf(" %d ",i); */
-        }
-
-      i++;
-      if ( check_nn == 4 * nn_quad )
-        break;
+      solPtr->array[i].neighbors = malloc((length+1)*sizeof(int));
+      if (!solPtr->array[i].neighbors)
+        error(EXIT_FAILURE,0,"Cannot allocate memory");
+      solPtr->array[i].neighbors[0] = i;
+      for (j=0; j<length; j++)
+        solPtr->array[i].neighbors[j+1] = list[j].city;
+      LS_solution_cache_neighbor_distances(solPtr,i,length+1);
+      solPtr->no_neighbors = GSL_MAX(solPtr->no_neighbors,length+1);
     }
-  /*   	printf("\n"); */
-  /*  }*/
-  free(distance_vector);
-  free(help_vector);
-  free(chosen);
-  /*    printf("\n    .. done\n"); */
-  return m_nnear;
 
+  free(seen);
+  free(list);
+  DT_graph_free(&graph);
+  return 1;
 }
 
 
@@ -1284,33 +2594,168 @@ LS_move_check_position_index(LS_List *solPtr)
 void
 LS_solution_sort_neighbors(LS_List *solPtr, int nn)
 {
-  int i;
-  const LS_DISTANCE **D = solPtr->distances;
+  int i, j;
   int n = solPtr->no_cities;
+  LS_DISTANCE *row;
+  KD_tree tree;
+  KD_neighbor *nearest;
   nn = GSL_MIN(n,nn);
   solPtr->no_neighbors = nn;
 
+  if (solPtr->instance)
+    {
+      /* Only the cities around each one are looked at */
+      tree = KD_tree_build(solPtr->instance);
+      nearest = malloc(nn*sizeof(KD_neighbor));
+      if (!nearest)
+        error(EXIT_FAILURE,0,"Cannot allocate memory");
+      for (i=0; i<n; i++)
+        {
+          solPtr->array[i].neighbors =
+            LS_allocate_nearest_neighbors(&tree,i,nn,nearest);
+          LS_solution_cache_neighbor_distances(solPtr,i,nn);
+        }
+      free(nearest);
+      KD_tree_free(&tree);
+      return;
+    }
+
+  /* Rows are not stored contiguously: each one is gathered in turn */
+  row = malloc(n*sizeof(LS_DISTANCE));
+  if (!row)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+
   for (i=0; i<solPtr->no_cities; i++)
-    solPtr->array[i].neighbors = LS_allocate_sort_neighbors(D[i],n,nn);
+    {
+      for (j=0; j<n; j++)
+        row[j] = LS_DIST(solPtr,i,j);
+      solPtr->array[i].neighbors = LS_allocate_sort_neighbors(row,n,nn);
+      LS_solution_cache_neighbor_distances(solPtr,i,nn);
+    }
+  free(row);
 }
 int*
-LS_allocate_sort_neighbors(const LS_DISTANCE *d, int no_cities, int nn)
+LS_allocate_nearest_neighbors(const KD_tree *tree, int node, int nn,
+                              KD_neighbor *nearest)
 {
-  int *neighbours = malloc(nn*sizeof(LS_DISTANCE));
+  int j, k;
+  int *neighbours = malloc(nn*sizeof(int));
   if (!neighbours)
     error(EXIT_FAILURE,0,"Cannot allocate memory");
+
+  KD_tree_nearest(tree,node,nn,KD_ALL_QUADRANTS,nearest);
+  /* Cities at the same position may come before the city itself,
+     which must be in position 0 */
+  neighbours[0] = node;
+  for (j=0, k=1; k<nn; j++)
+    if (nearest[j].city != node)
+      neighbours[k++] = nearest[j].city;
+  return neighbours;
+}
+
+void
+LS_solution_copy_neighbors(LS_List *solPtr, const int *lists, int length)
+{
+  int i;
+
+  solPtr->no_neighbors = length;
+  for (i=0; i<solPtr->no_cities; i++)
+    {
+      solPtr->array[i].neighbors = malloc(length*sizeof(int));
+      if (!solPtr->array[i].neighbors)
+        error(EXIT_FAILURE,0,"Cannot allocate memory");
+      memcpy(solPtr->array[i].neighbors,lists + (size_t)i*length,
+             length*sizeof(int));
+      LS_solution_cache_neighbor_distances(solPtr,i,length);
+    }
+}
+
+LS_candidates
+LS_solution_save_neighbors(const LS_List *solPtr)
+{
+  LS_candidates candidates;
+  int i, n = solPtr->no_cities;
+  size_t total = 0;
+  const struct LS_city *this;
+
+  candidates.no_cities = n;
+  candidates.first = malloc((n+1)*sizeof(int));
+  if (!candidates.first)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (i=0; i<n; i++)
+    {
+      candidates.first[i] = total;
+      total += solPtr->array[i].no_neighbors;
+    }
+  candidates.first[n] = total;
+  candidates.city = malloc(total*sizeof(int));
+  candidates.distance = malloc(total*sizeof(LS_DISTANCE));
+  if (!candidates.city || !candidates.distance)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (i=0; i<n; i++)
+    {
+      this = &solPtr->array[i];
+      memcpy(candidates.city + candidates.first[i],this->neighbors,
+             this->no_neighbors*sizeof(int));
+      memcpy(candidates.distance + candidates.first[i],this->neighbor_distances,
+             this->no_neighbors*sizeof(LS_DISTANCE));
+    }
+  return candidates;
+}
+
+void
+LS_solution_share_neighbors(LS_List *solPtr, const LS_candidates *candidates)
+{
+  int i, length;
+  struct LS_city *this;
+
+  assert(candidates->no_cities == solPtr->no_cities);
+  solPtr->no_neighbors = 0;
+  solPtr->shared_neighbors = TRUE;
+  for (i=0; i<solPtr->no_cities; i++)
+    {
+      this = &solPtr->array[i];
+      length = candidates->first[i+1] - candidates->first[i];
+      this->neighbors = candidates->city + candidates->first[i];
+      this->neighbor_distances = candidates->distance + candidates->first[i];
+      this->no_neighbors = length;
+      solPtr->no_neighbors = GSL_MAX(solPtr->no_neighbors,length);
+    }
+}
+
+void
+LS_candidates_free(LS_candidates *candidates)
+{
+  free(candidates->first);
+  free(candidates->city);
+  free(candidates->distance);
+  candidates->first = candidates->city = NULL;
+  candidates->distance = NULL;
+}
+
+int*
+LS_allocate_sort_neighbors(const LS_DISTANCE *d, int no_cities, int nn)
+{
+  int j;
+  int *neighbours = malloc(nn*sizeof(int));
+  size_t *index = malloc(nn*sizeof(size_t));
+  if (!neighbours || !index)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
   assert(nn<=no_cities);
 #ifdef LS_DISTANCE_LONGINT
 
-  gsl_sort_long_smallest_index((size_t*)neighbours,nn,d,1,no_cities);
+  gsl_sort_long_smallest_index(index,nn,d,1,no_cities);
 #elif LS_DISTANCE_DOUBLE
 
-  gsl_sort_smallest_index((size_t*)neighbours,nn,d,1,no_cities);
+  gsl_sort_smallest_index(index,nn,d,1,no_cities);
 #else
 
-  gsl_sort_int_smallest_index((size_t*)neighbours,nn,d,1,no_cities);
+  gsl_sort_int_smallest_index(index,nn,d,1,no_cities);
 #endif
 
+  for (j=0; j<nn; j++)
+    neighbours[j] = index[j];
+  free(index);
   return neighbours;
 }
 
@@ -1321,7 +2766,7 @@ LS_solution_get(LS_List solution, LS_SOLUTION_INT *apriori_solution)
   int i;
   struct LS_city *this;
 
-  for (i=0,this=solution.first; i<solution.no_cities; i++,this=this->next)
+  for (i=0,this=solution.first; i<solution.no_cities; i++,this=LS_NEXT_CITY(&solution,this))
     apriori_solution[i] = this->city;
 
   /* See sampleLS.h for an explanation of next line: */
@@ -1341,7 +2786,6 @@ LS_solution_return_value(LS_List solution)
                     int start, pos;
                     long int tmp;
                     double value = 0.0;
-                    const LS_DISTANCE **D = solution.distances;
 
                     for (j=0; j<solution.no_realizations; j++)
                       {
@@ -1350,18 +2794,18 @@ LS_solution_return_value(LS_List solution)
                         this = solution.first;
                         for (i=0; i<solution.no_cities; i++)
                           {
-                            if (this->realizations[j])
+                            if (LS_REALIZATION_TEST(this->realizations,j))
                               {
                                 if (start == -1)
                                   start = this->city;
                                 else
-                                  tmp += D[pos][this->city];
+                                  tmp += LS_DIST(&solution,pos,this->city);
                                 pos = this->city;
                               }
-                            this = this->next;
+                            this = LS_NEXT_CITY(&solution,this);
                           }
                         if (start != -1)
-                          tmp += D[pos][start];
+                          tmp += LS_DIST(&solution,pos,start);
                         value += ((double)tmp)/((double)solution.no_realizations);
                       }
                     return(value);
@@ -44,6 +44,8 @@
 
 #include <gsl/gsl_rng.h>
 #include "problemdataStructures.h"
+#include "kdTree.h"
+#include "delaunay.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -80,23 +82,31 @@ extern "C"
 
     /* Allocate a data structure for a local search. The parameter D is
        the pointer to the matrix containing the distances between
-       cities. The matrix D IS_NOT modified: To insure this, it is
-       immediatelly casted to `const LS_DISTANCE'.  This function is
+       cities, stored as done by compute_distances (see
+       LS_DISTANCE_INDEX). The matrix D IS_NOT modified: To insure
+       this, it is immediatelly casted to `const LS_DISTANCE'. If D is
+       NULL, the distances are computed from the coordinates of the
+       instance given by LS_solution_set_instance.  This function is
        declared here as `extern inline'. A static version of the function
        is given in sampleLScommon.c for the cases in which the compiler
        does not inline. */
     extern inline LS_List
       LS_solution_allocate(int no_cities, int no_realizations,
-                           const double *prob_vec, LS_DISTANCE **D,
+                           const double *prob_vec, LS_DISTANCE *D,
                            double alpha, int importance_sampling,
                            float deltaProb, float deltaDashProb,
                            float window_size_percent,float nodes_percent)
       {
-        return LS_solution_allocate_aux(no_cities,no_realizations,prob_vec,(const LS_DISTANCE **) D,
+        return LS_solution_allocate_aux(no_cities,no_realizations,prob_vec,(const LS_DISTANCE *) D,
                                         alpha,importance_sampling,
                                         (double) deltaProb, (double) deltaDashProb,window_size_percent,nodes_percent);
       }
 
+    /* Give the instance from which the distances are computed when the
+       solution has been allocated without a distance matrix. */
+    void
+    LS_solution_set_instance(LS_List *solPtr, problem *insPtr);
+
 
     /* In the following, we assume that apriori_solution is a vector of
        integer (or long integers if LS_SOLUTION_LONGINT is defined)
@@ -126,9 +136,18 @@ extern "C"
 
 
     /* A single step of a 2-exchange first improvement local search with
-      nearest neighbor lists and don't look bits */
+      nearest neighbor lists and don't look bits, looking at the cities
+      whose bit is not set in the order given to LS_reset_dlb */
     double
-    LS_2nndlbfls_step(LS_List *solPtr, const int *order, gsl_rng *r, int sampling_type);
+    LS_2nndlbfls_step(LS_List *solPtr, gsl_rng *r, int sampling_type);
+
+    /* Estimate the expected cost of the solution as the average length
+       of its tour over no_realizations realizations of the cities,
+       drawn from r with the probabilities of the solution. The random
+       numbers are drawn city by city, so generators in the same state
+       give the same realizations to every solution of an instance. */
+    double
+    LS_solution_estimate_cost(LS_List solution, gsl_rng *r, int no_realizations);
 
     /* Iterate 2nndlbfls */
     void
@@ -141,9 +160,62 @@ extern "C"
 
 
     /* A single step of a 2.5-exchange first improvement local search with
-       nearest neighbor lists and don't look bits */
+       nearest neighbor lists and don't look bits, as LS_2nndlbfls_step */
     double
-    LS_2hnndlbfls_step(LS_List *solPtr, const int *order, gsl_rng *r, int sampling_type);
+    LS_2hnndlbfls_step(LS_List *solPtr, gsl_rng *r, int sampling_type);
+
+    /* Let the steps of the 2.5-exchange local search on the solution
+       evaluate the neighborhoods of several cities in parallel on
+       no_threads threads, the calling one included. A step still makes
+       the move the serial one would make; with a tolerance, it makes
+       also up to that many of the other improving moves found at the
+       same time, each reevaluated on the tour left by the moves before
+       it. The threads are stopped by LS_solution_free. */
+    void
+    LS_solution_set_evaluation_threads(LS_List *solPtr, int no_threads,
+                                       int tolerance);
+
+    /* Let each step of the 2.5-exchange local search on the solution
+       look at all the cities whose don't look bit is not set against
+       the same tour, and make the improving moves found whose edges
+       are left in the tour by those made before them and which still
+       improve on it. A step makes many moves at once, but the search
+       is not the same. The evaluation threads, if any, are used
+       instead. The moves are freed by LS_solution_free. */
+    void
+    LS_solution_set_sweep(LS_List *solPtr);
+
+    /* If or_opt is set in the solution, a step of the 2.5-exchange
+       local search that finds no improving move for a city then tries,
+       for each of its neighbors, to move between the city and its
+       successor or predecessor the segment of 2 up to this many cities
+       starting or ending at the neighbor, in either orientation. */
+#define LS_OR_OPT_MAX_LENGTH 3
+
+    /* Let each step of the 2.5-exchange local search on the solution,
+       where it finds no improving move for a city, look for a chain of
+       up to this many 2-exchange moves from it, built as by the
+       Lin-Kernighan heuristic on the candidate lists with a bounded
+       breadth; where no first move extends, the chain may start with
+       a sequential 3-exchange moving a segment, made of up to three
+       of those moves. The deltas of the moves on each realization are added
+       up along the chain, and the best of its prefixes is made if it
+       improves the solution, as a move would with the type of sampling:
+       with the adaptive sampling, by the t-test on these sums. The
+       sweep and the evaluation threads, if any, are used instead. The
+       chain is freed by LS_solution_free. */
+#define LS_LK_MAX_DEPTH 8
+    void
+    LS_solution_set_variable_depth(LS_List *solPtr);
+
+    /* Keep the tour of the solution in a two-level list from now on,
+       where a move costs O(sqrt(n)) instead of the length of the path
+       it reverses or shifts; the moves and positions are those of the
+       array, so that the search is the same. Below this many cities
+       the array is kept. */
+#define LS_TWO_LEVEL_MIN_CITIES 8
+    void
+    LS_solution_set_two_level(LS_List *solPtr);
 
     /* Iterate 2hnndlbfls */
     void
@@ -175,9 +247,11 @@ extern "C"
     LS_2hnndlbfls_times_resample(int K,LS_List *solPtr,
                                  gsl_rng *r, double time, int verbose,int sampling_type);
 
-    /* Reset don't look bits of a solution */
+    /* Reset don't look bits of a solution. The steps look at the cities
+       in the given order from now on, or in the last one given if order
+       is NULL. */
     void
-    LS_reset_dlb(LS_List *solPtr);
+    LS_reset_dlb(LS_List *solPtr, const int *order);
 
     /* Compute the value of the apriori solution */
     double
@@ -214,11 +288,60 @@ extern "C"
     void
     LS_solution_sort_neighbors(LS_List *solPtr, int nn);
 
+    /* Sort neighbors of each city choosing the nn/4 nearest ones in
+       each quadrant around it, the nearest cities making up for the
+       quadrants with fewer. As above, the city itself is in position
+       0, so that the list has 1+4*(nn/4) cities (all of them, for
+       small instances). */
     void
     LS_solution_sort_quad_neighbors(problem *insPtr, LS_List *solPtr,int nn);
 
+    /* Allocate the list of the nn nearest neighbors of node, node
+       itself first; nearest is a buffer of nn entries. */
+    int*
+    LS_allocate_nearest_neighbors(const KD_tree *tree, int node, int nn,
+                                  KD_neighbor *nearest);
+
+    /* Set the neighbors of each city from the lists of `length' cities
+       stored one after the other, as in an instance cache. */
+    void
+    LS_solution_copy_neighbors(LS_List *solPtr, const int *lists, int length);
+
+    /* Save the neighbor lists of the solution, with their distances. */
+    LS_candidates
+    LS_solution_save_neighbors(const LS_List *solPtr);
+
+    /* Point the neighbor lists of the solution to the saved ones,
+       without copying them: the solution only reads its lists, so
+       several solutions, also on different threads, can share the
+       same candidates, which have to outlive them. */
+    void
+    LS_solution_share_neighbors(LS_List *solPtr, const LS_candidates *candidates);
+
+    void
+    LS_candidates_free(LS_candidates *candidates);
+
+    /* Allocate the list of `length' cities described above for node,
+       with nn_quad cities in each quadrant. */
     int*
-    LS_allocate_sort_quad_neighbors(problem *insPtr,const LS_DISTANCE **d,int node,int no_cities,int nn);
+    LS_allocate_sort_quad_neighbors(const KD_tree *tree, int node,
+                                    int nn_quad, int length);
+
+    /* Sort neighbors of each city choosing the cities adjacent to it
+       in the Delaunay triangulation and, if second_order, the cities
+       adjacent to those. The city itself is in position 0; lists have
+       different lengths, solPtr->no_neighbors being the longest.
+       Returns 0, without setting any list, if the cities cannot be
+       triangulated. */
+    int
+    LS_solution_sort_delaunay_neighbors(problem *insPtr, LS_List *solPtr,
+                                        int second_order);
+
+    /* Set the length of the neighbor list of city, and store the
+       distance from city to each of its entries, so that the
+       exploration of the neighborhood does not look them up again. */
+    void
+    LS_solution_cache_neighbor_distances(LS_List *solPtr, int city, int length);
 
     void
     LS_swap(int v[], int v2[], int i, int j);
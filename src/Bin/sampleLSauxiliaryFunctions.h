@@ -48,7 +48,7 @@ int* LS_allocate_sort_neighbors(const LS_DISTANCE *d,
 
 LS_List LS_solution_allocate_aux(int no_cities,int no_realizations,
                                  const double *prob_vec,
-                                 const LS_DISTANCE **D,
+                                 const LS_DISTANCE *D,
                                  double chebyshev_k_type, int importance_sampling,
                                  float deltaProb,
                                  float deltaDashProb,
@@ -45,18 +45,54 @@
 #ifndef LS_DATA_STRUCTURES
 #define LS_DATA_STRUCTURES
 
+#include <stdint.h>
+#include "twoLevelList.h"
+
+/* Realizations are stored as bitsets: bit j of the store of a city
+   is set if the city requires being visited in realization j */
+typedef uint64_t LS_REALIZATION_WORD;
+
+#define LS_REALIZATION_WORD_BITS 64
+#define LS_REALIZATION_WORD_SHIFT 6
+#define LS_REALIZATION_WORD_MASK (LS_REALIZATION_WORD_BITS-1)
+
+/* Number of words needed for storing r realizations */
+#define LS_REALIZATION_NO_WORDS(r) \
+  (((r)+LS_REALIZATION_WORD_BITS-1)>>LS_REALIZATION_WORD_SHIFT)
+
+/* Value (0 or 1) of realization j in the store v */
+#define LS_REALIZATION_TEST(v,j) \
+  ((int)(((v)[(j)>>LS_REALIZATION_WORD_SHIFT]>>((j)&LS_REALIZATION_WORD_MASK))&1))
+
+/* Set realization j in the store v to b, where b is 0 or 1 */
+#define LS_REALIZATION_ASSIGN(v,j,b) \
+  ((v)[(j)>>LS_REALIZATION_WORD_SHIFT] = \
+     ((v)[(j)>>LS_REALIZATION_WORD_SHIFT] \
+      & ~(((LS_REALIZATION_WORD)1)<<((j)&LS_REALIZATION_WORD_MASK))) \
+     | (((LS_REALIZATION_WORD)(b))<<((j)&LS_REALIZATION_WORD_MASK)))
+
+/* Distance between cities a and b of the solution pointed by solPtr,
+   read from the matrix (see LS_DISTANCE_INDEX) or, if there is no
+   matrix, computed from the coordinates of the instance */
+#define LS_DIST(solPtr,a,b) \
+  ((solPtr)->distance_matrix \
+   ? (solPtr)->distance_matrix[LS_DISTANCE_INDEX((a),(b),(solPtr)->no_cities)] \
+   : (solPtr)->instance->distance_function((a),(b),(solPtr)->instance))
+
 
 /* Structure describing each city in an apriori solution */
 struct LS_city
   {
     int city;
     int dlb;
+    unsigned int version;            /* changed whenever a move changes
+                                        the neighbors of the city */
     double probability;
     double deltaProbability;
     double deltaDashProbability;
-    int *realizations;
-    int *two_opt_biased_realizations;
-    int *two_h_opt_biased_realizations;
+    LS_REALIZATION_WORD *realizations;
+    LS_REALIZATION_WORD *two_opt_biased_realizations;
+    LS_REALIZATION_WORD *two_h_opt_biased_realizations;
     double correction_two_opt[2];
     double correction_two_h_opt;
 
@@ -66,6 +102,8 @@ struct LS_city
 
 
     int *neighbors;
+    LS_DISTANCE *neighbor_distances; /* distance to each of the neighbors */
+    int no_neighbors;                /* length of the two lists above */
     int num_of_zeros;
     int num_of_ones;
     int window_end_node;
@@ -81,18 +119,63 @@ typedef struct
     struct LS_city *array;
     struct LS_city *first;
     int *position_array;
+    LST_tour *two_level;             /* if not NULL, the tour is kept
+                                        there instead of prev, next and
+                                        position_array, see
+                                        LS_solution_set_two_level */
     int no_cities;
     int no_realizations;
-    int no_neighbors;
+    int no_neighbors;                /* length of the longest neighbor list */
+    int shared_neighbors;            /* whether the lists are those of an
+                                        LS_candidates, not to be freed */
     double value;
-    const LS_DISTANCE **distances;
+    const LS_DISTANCE *distance_matrix;
+    problem *instance;
     int generated_realizations;
     int minimum_realizations;
     int maximum_realizations;
+    int realization_words;
+    LS_REALIZATION_WORD *realization_store;
     double *delta;
     int *realization_order;
+    int *block_order;
     double alpha;
+    int depth;                       /* of the approximation, see LSX_delta */
+    double *absent_power;            /* powers of 1-p if all the probabilities
+                                        are p, see
+                                        LSX_solution_set_homogeneous */
+    int *active;                     /* heap of the cities whose don't
+                                        look bit is not set, the first
+                                        of the order first */
+    int no_active;
+    int *rank;                       /* of each city in that order, see
+                                        LS_reset_dlb */
     int move_status;
+    int no_steps;                    /* steps made by the last search */
+    int quiet;                       /* whether the search logs nothing */
+    int (*report)(void *data, int step);
+                                     /* called after each step of a search
+                                        if not NULL, with report_data; a
+                                        nonzero value stops the search */
+    void *report_data;
+    struct LS_evaluators *evaluators;
+                                     /* threads evaluating the steps of
+                                        the 2.5-exchange local search, see
+                                        LS_solution_set_evaluation_threads */
+    struct LS_sweep *sweep;          /* if not NULL, those steps make
+                                        the moves found in a pass over
+                                        the active cities, see
+                                        LS_solution_set_sweep */
+    int or_opt;                      /* whether those steps look for
+                                        Or-opt moves as well, see
+                                        LS_OR_OPT_MAX_LENGTH */
+    struct LS_lk *lk;                /* if not NULL, they look for
+                                        chains of moves as well, see
+                                        LS_solution_set_variable_depth */
+    struct LSA_realization_pool *realization_pool;
+                                     /* threads computing the deltas of a
+                                        move on several realizations, see
+                                        LSA_solution_set_realization_threads */
     double sum_avg_delta;
     double mean_avg_delta;
     /*importance sampling*/
@@ -112,4 +195,44 @@ typedef struct
   }
 LS_List;
 
+/* City after and before c along the tour of the solution pointed by
+   solPtr, and position of c; the same for the struct LS_city this */
+#define LS_NEXT(solPtr,c) \
+  ((solPtr)->two_level ? LST_next((solPtr)->two_level,(c)) \
+   : (solPtr)->array[c].next->city)
+#define LS_PREV(solPtr,c) \
+  ((solPtr)->two_level ? LST_prev((solPtr)->two_level,(c)) \
+   : (solPtr)->array[c].prev->city)
+#define LS_POSITION(solPtr,c) \
+  ((solPtr)->two_level ? LST_position((solPtr)->two_level,(c)) \
+   : (solPtr)->position_array[c])
+/* Whether b is on the path from a to c following LS_NEXT, ends
+   included */
+#define LS_BETWEEN(solPtr,a,b,c) \
+  ((solPtr)->two_level ? LST_between((solPtr)->two_level,(a),(b),(c)) \
+   : (((solPtr)->position_array[b] - (solPtr)->position_array[a] + (solPtr)->no_cities) \
+      % (solPtr)->no_cities \
+      <= ((solPtr)->position_array[c] - (solPtr)->position_array[a] + (solPtr)->no_cities) \
+      % (solPtr)->no_cities))
+#define LS_NEXT_CITY(solPtr,this) \
+  ((solPtr)->two_level \
+   ? &(solPtr)->array[LST_next((solPtr)->two_level,(this)->city)] \
+   : (this)->next)
+#define LS_PREV_CITY(solPtr,this) \
+  ((solPtr)->two_level \
+   ? &(solPtr)->array[LST_prev((solPtr)->two_level,(this)->city)] \
+   : (this)->prev)
+
+/* Neighbor lists of all the cities, kept for building the lists of
+   other solutions of the same instance: those of city c are
+   city[first[c]..first[c+1]-1], with the distances to c alongside */
+typedef struct
+  {
+    int no_cities;
+    int *first;
+    int *city;
+    LS_DISTANCE *distance;
+  }
+LS_candidates;
+
 #endif /* LS_DATA_STRUCTURES */
@@ -45,38 +45,29 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <error.h>
-#include <sys/time.h>
+#include <time.h>
 
-#define MAX_TIME 36000
+/* Processor time of the process when the stopwatch was started. It is
+   read from the clock instead of a profiling timer, whose expiry would
+   kill the process: the searches check their time limit themselves,
+   and may run for any time, on any number of threads. */
+static struct timespec start;
 
 void
-stopwatch_start(double total_time)
+stopwatch_start()
 {
-  struct itimerval time;
-
-  if ((total_time>MAX_TIME)||(total_time<0))
-    error(EXIT_FAILURE,0,"stopwatch: Invalid time");
-
-  total_time = (total_time==0)?MAX_TIME:total_time;
-
-  time.it_value.tv_sec = time.it_interval.tv_sec =
-                           (long int)(total_time);
-  time.it_value.tv_usec = time.it_interval.tv_usec =
-                            (long int)(1e6*(time.it_value.tv_sec-total_time));
-
-  if (setitimer(ITIMER_PROF, &time, 0))
-    error(EXIT_FAILURE,errno,"stopwatch: error while setting the timer");
+  if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID,&start))
+    error(EXIT_FAILURE,errno,"stopwatch: error while reading the clock");
 }
 
 double
 stopwatch_read()
 {
-  struct itimerval time;
+  struct timespec now;
 
-  if(getitimer(ITIMER_PROF,&time))
-    error(EXIT_FAILURE,errno,"stopwatch: error while reading the timer");
+  if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID,&now))
+    error(EXIT_FAILURE,errno,"stopwatch: error while reading the clock");
 
-  return 0.00001+time.it_interval.tv_sec - time.it_value.tv_sec +
-         ((double)(time.it_interval.tv_usec - time.it_value.tv_usec))/1e6;
+  return 0.00001+now.tv_sec - start.tv_sec +
+         ((double)(now.tv_nsec - start.tv_nsec))/1e9;
 }
-
@@ -51,7 +51,7 @@ extern "C"
 #ifndef STOPWATCH
 # define STOPWATCH
 
-    void stopwatch_start(double total_time);
+    void stopwatch_start();
 
     double stopwatch_read();
 
@@ -0,0 +1,67 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    triangularIndex.h
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Layout of the distance matrix shared with the evaluator
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#ifndef LS_TRIANGULAR_INDEX
+#define LS_TRIANGULAR_INDEX
+
+#include <stddef.h>
+
+/* Distances are symmetric: only the lower triangle of the matrix,
+   diagonal included, is stored row after row. Instance caches store it
+   so, and the evaluator reads them, hence this header of its own. */
+
+/* Index of (i,j) in the packed lower triangle, without branches:
+   m is i-j if i<j and 0 otherwise, so that i-m is the larger index
+   and j+m the smaller one */
+static inline size_t
+LS_triangular_index(long int i, long int j)
+{
+  long int d = i - j;
+  long int m = d & (d >> (8*sizeof(long int)-1));
+  long int hi = i - m;
+
+  return (size_t)hi*(hi+1)/2 + (size_t)(j + m);
+}
+
+#endif /* LS_TRIANGULAR_INDEX */
@@ -0,0 +1,394 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    twoLevelList.c
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Tour kept as a two-level doubly-linked list
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#include <stdlib.h>
+#include <error.h>
+#include <math.h>
+
+#include "twoLevelList.h"
+
+/* Segments are built again once one of them is this many times larger
+   than when they were built */
+#define LST_MAX_GROWTH 4
+
+
+LST_tour *
+LST_tour_allocate(int n)
+{
+  LST_tour *tour = malloc(sizeof(LST_tour));
+
+  if (!tour)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  tour->no_cities = n;
+  tour->group = (int)ceil(sqrt((double)n));
+  if (tour->group < 1)
+    tour->group = 1;
+  tour->no_segments = (n + tour->group - 1)/tour->group;
+  tour->unbalanced = 0;
+  tour->segment = malloc(tour->no_segments*sizeof(struct LST_segment));
+  tour->parent = malloc(n*sizeof(int));
+  tour->rank = malloc(n*sizeof(int));
+  tour->succ = malloc(n*sizeof(int));
+  tour->pred = malloc(n*sizeof(int));
+  tour->buffer = malloc(n*sizeof(int));
+  if (!tour->segment || !tour->parent || !tour->rank ||
+      !tour->succ || !tour->pred || !tour->buffer)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  return tour;
+}
+
+
+void
+LST_tour_free(LST_tour *tour)
+{
+  free(tour->segment);
+  free(tour->parent);
+  free(tour->rank);
+  free(tour->succ);
+  free(tour->pred);
+  free(tour->buffer);
+  free(tour);
+}
+
+
+void
+LST_tour_set(LST_tour *tour, const int *position)
+{
+  int n = tour->no_cities, *city = tour->buffer;
+  int c, p, s;
+
+  for (c = 0; c < n; c++)
+    city[position[c]] = c;
+
+  /* Segment s holds the positions from s*group on */
+  for (s = 0; s < tour->no_segments; s++)
+    {
+      struct LST_segment *segment = &tour->segment[s];
+
+      segment->reversed = 0;
+      segment->position = s*tour->group;
+      segment->size = (s < tour->no_segments-1) ? tour->group : n - s*tour->group;
+      segment->first = city[segment->position];
+      segment->last = city[segment->position + segment->size - 1];
+      segment->next = (s + 1) % tour->no_segments;
+      segment->prev = (s + tour->no_segments - 1) % tour->no_segments;
+    }
+  for (p = 0; p < n; p++)
+    {
+      c = city[p];
+      s = p / tour->group;
+      tour->parent[c] = s;
+      tour->rank[c] = p - s*tour->group;
+      tour->pred[c] = (c == tour->segment[s].first) ? -1 : city[p-1];
+      tour->succ[c] = (c == tour->segment[s].last) ? -1 : city[p+1];
+    }
+  tour->unbalanced = 0;
+}
+
+
+/* Build the segments again from the positions of the cities */
+static void
+LST_tour_balance(LST_tour *tour)
+{
+  int *position = malloc(tour->no_cities*sizeof(int));
+  int c;
+
+  if (!position)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (c = 0; c < tour->no_cities; c++)
+    position[c] = LST_position(tour,c);
+  LST_tour_set(tour,position);
+  free(position);
+}
+
+
+/* Add city c at the end of segment s along the tour, or at its start */
+static void
+LST_append(LST_tour *tour, int s, int c)
+{
+  struct LST_segment *segment = &tour->segment[s];
+
+  tour->parent[c] = s;
+  if (!segment->reversed)
+    {
+      tour->rank[c] = tour->rank[segment->last] + 1;
+      tour->pred[c] = segment->last;
+      tour->succ[c] = -1;
+      tour->succ[segment->last] = c;
+      segment->last = c;
+    }
+  else
+    {
+      tour->rank[c] = tour->rank[segment->first] - 1;
+      tour->succ[c] = segment->first;
+      tour->pred[c] = -1;
+      tour->pred[segment->first] = c;
+      segment->first = c;
+    }
+  segment->size++;
+}
+
+static void
+LST_prepend(LST_tour *tour, int s, int c)
+{
+  struct LST_segment *segment = &tour->segment[s];
+
+  tour->parent[c] = s;
+  if (!segment->reversed)
+    {
+      tour->rank[c] = tour->rank[segment->first] - 1;
+      tour->succ[c] = segment->first;
+      tour->pred[c] = -1;
+      tour->pred[segment->first] = c;
+      segment->first = c;
+    }
+  else
+    {
+      tour->rank[c] = tour->rank[segment->last] + 1;
+      tour->pred[c] = segment->last;
+      tour->succ[c] = -1;
+      tour->succ[segment->last] = c;
+      segment->last = c;
+    }
+  segment->position = (segment->position + tour->no_cities - 1) % tour->no_cities;
+  segment->size++;
+}
+
+/* Move the first k cities of segment s along the tour at the end of the
+   previous segment, or the last k ones at the start of the next one;
+   neither move changes the position of a city */
+static void
+LST_move_head(LST_tour *tour, int s, int k)
+{
+  struct LST_segment *segment = &tour->segment[s];
+  int i, c, next;
+
+  for (i = 0, c = LST_head(tour,s); i < k; i++, c = next)
+    {
+      next = segment->reversed ? tour->pred[c] : tour->succ[c];
+      LST_append(tour,segment->prev,c);
+    }
+  /* c is now the first city left in s */
+  if (!segment->reversed)
+    {
+      tour->pred[c] = -1;
+      segment->first = c;
+    }
+  else
+    {
+      tour->succ[c] = -1;
+      segment->last = c;
+    }
+  segment->position = (segment->position + k) % tour->no_cities;
+  segment->size -= k;
+  if (tour->segment[segment->prev].size > LST_MAX_GROWTH*tour->group)
+    tour->unbalanced = 1;
+}
+
+static void
+LST_move_tail(LST_tour *tour, int s, int k)
+{
+  struct LST_segment *segment = &tour->segment[s];
+  int i, c, prev;
+
+  for (i = 0, c = LST_tail(tour,s); i < k; i++, c = prev)
+    {
+      prev = segment->reversed ? tour->succ[c] : tour->pred[c];
+      LST_prepend(tour,segment->next,c);
+    }
+  if (!segment->reversed)
+    {
+      tour->succ[c] = -1;
+      segment->last = c;
+    }
+  else
+    {
+      tour->pred[c] = -1;
+      segment->first = c;
+    }
+  segment->size -= k;
+  if (tour->segment[segment->next].size > LST_MAX_GROWTH*tour->group)
+    tour->unbalanced = 1;
+}
+
+/* Make city a the start of a segment, moving the fewest cities */
+static void
+LST_split_before(LST_tour *tour, int a)
+{
+  int s = tour->parent[a], k = LST_offset(tour,a);
+
+  if (k == 0)
+    return;
+  if (k <= tour->segment[s].size - k)
+    LST_move_head(tour,s,k);
+  else
+    LST_move_tail(tour,s,tour->segment[s].size - k);
+}
+
+/* Make city b the end of a segment, keeping the start of segment keep */
+static void
+LST_split_after(LST_tour *tour, int b, int keep)
+{
+  int s = tour->parent[b], k = LST_offset(tour,b) + 1;
+
+  if (k == tour->segment[s].size)
+    return;
+  if (k <= tour->segment[s].size - k || tour->segment[s].next == keep)
+    LST_move_head(tour,s,k);
+  else
+    LST_move_tail(tour,s,tour->segment[s].size - k);
+}
+
+/* Reverse the path from a to b inside their segment, which the path
+   does not leave */
+static void
+LST_reverse_inside(LST_tour *tour, int a, int b)
+{
+  int s = tour->parent[a];
+  struct LST_segment *segment = &tour->segment[s];
+  int *city = tour->buffer;
+  int lo, hi, before, after, rank, l, j, c;
+
+  lo = segment->reversed ? b : a;
+  hi = segment->reversed ? a : b;
+  if (lo == segment->first && hi == segment->last)
+    {
+      segment->reversed = !segment->reversed;
+      return;
+    }
+
+  for (l = 0, c = lo; c != hi; c = tour->succ[c])
+    city[l++] = c;
+  city[l++] = hi;
+  before = tour->pred[lo];
+  after = tour->succ[hi];
+  rank = tour->rank[lo];
+
+  /* The same ranks, in the opposite order */
+  for (j = 0; j < l; j++)
+    {
+      c = city[l-1-j];
+      tour->rank[c] = rank + j;
+      tour->pred[c] = (j == 0) ? before : city[l-j];
+      tour->succ[c] = (j == l-1) ? after : city[l-2-j];
+    }
+  if (before < 0)
+    segment->first = hi;
+  else
+    tour->succ[before] = hi;
+  if (after < 0)
+    segment->last = lo;
+  else
+    tour->pred[after] = lo;
+}
+
+/* Reverse the path of whole segments from segment sa to segment sb */
+static void
+LST_reverse_segments(LST_tour *tour, int sa, int sb)
+{
+  struct LST_segment *segment = tour->segment;
+  int *sequence = tour->buffer;
+  int before = segment[sa].prev, after = segment[sb].next;
+  int k, j, s, position = segment[sa].position;
+
+  for (k = 0, s = sa; ; s = segment[s].next)
+    {
+      sequence[k++] = s;
+      if (s == sb)
+        break;
+    }
+
+  if (k == tour->no_segments)
+    /* The whole tour */
+    for (j = 0; j < k; j++)
+      {
+        s = segment[sequence[j]].next;
+        segment[sequence[j]].next = segment[sequence[j]].prev;
+        segment[sequence[j]].prev = s;
+      }
+  else
+    {
+      segment[before].next = sequence[k-1];
+      segment[sequence[k-1]].prev = before;
+      for (j = k-1; j > 0; j--)
+        {
+          segment[sequence[j]].next = sequence[j-1];
+          segment[sequence[j-1]].prev = sequence[j];
+        }
+      segment[sequence[0]].next = after;
+      segment[after].prev = sequence[0];
+    }
+
+  for (j = k-1; j >= 0; j--)
+    {
+      s = sequence[j];
+      segment[s].reversed = !segment[s].reversed;
+      segment[s].position = position;
+      position = (position + segment[s].size) % tour->no_cities;
+    }
+}
+
+
+void
+LST_reverse(LST_tour *tour, int a, int b)
+{
+  if (a == b)
+    return;
+  if (tour->parent[a] == tour->parent[b] &&
+      LST_offset(tour,a) <= LST_offset(tour,b))
+    LST_reverse_inside(tour,a,b);
+  else
+    {
+      LST_split_before(tour,a);
+      if (tour->parent[a] == tour->parent[b])
+        LST_reverse_inside(tour,a,b);
+      else
+        {
+          LST_split_after(tour,b,tour->parent[a]);
+          LST_reverse_segments(tour,tour->parent[a],tour->parent[b]);
+        }
+    }
+  if (tour->unbalanced)
+    LST_tour_balance(tour);
+}
@@ -0,0 +1,161 @@
+/*
+#####################################################################
+##########    Estimation-based Local Search for the PTSP    #########
+#####################################################################
+
+      Version: 1.0
+      File:    twoLevelList.h
+      Authors: Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+      Purpose: Tour kept as a two-level doubly-linked list
+      Check:   README and gpl.txt
+      Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+*/
+
+/*************************************************************************************
+
+    Program's name: els-ptsp
+
+    Estimation-based Local Search for the PTSP
+
+	Copyright (C) 2008 Prasanna Balaprakash, Mauro Birattari, and Thomas Stuetzle
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Email: {pbalapra,mbiro,stuetzle}@ulb.ac.be
+    Mail address:	Prasanna Balaprakash,
+					IRIDIA, Universite Libre de Bruxelles
+					50, Av. F. Roosevelt, CP 194/6
+					B-1050 Brussels, Belgium
+					http://iridia.ulb.ac.be/~prasanna
+
+*****************************************************************************************/
+
+#ifndef LS_TWO_LEVEL_LIST
+#define LS_TWO_LEVEL_LIST
+
+/* A tour split into about sqrt(n) segments of consecutive cities. The
+   cities of a segment are linked in the order of their ranks, and the
+   segments along the tour. A segment is run through from its last city
+   to its first one if it is reversed, so that reversing a path made of
+   whole segments only flips their bits and reverses their order: a
+   path is reversed in O(sqrt(n)) time, and the city after or before
+   another one, or its position, is found in O(1). Positions are kept
+   as with an array: the cities of a reversed path take the positions
+   the path had, in the opposite order. */
+
+struct LST_segment
+  {
+    int reversed;
+    int first, last;                 /* ends, first having the lowest rank */
+    int size;
+    int position;                    /* of the city at the start of the
+                                        segment along the tour */
+    int next, prev;                  /* segments along the tour */
+  };
+
+typedef struct
+  {
+    int no_cities;
+    int no_segments;
+    int group;                       /* size of the segments when built */
+    int unbalanced;                  /* whether a segment has grown beyond
+                                        LST_MAX_GROWTH times group */
+    struct LST_segment *segment;
+    int *parent;                     /* segment of each city */
+    int *rank;
+    int *succ, *pred;                /* cities of higher and lower rank
+                                        in the segment, -1 past the ends */
+    int *buffer;                     /* no_cities cities, for the moves */
+  }
+LST_tour;
+
+/* City at the start and at the end of segment s along the tour */
+static inline int
+LST_head(const LST_tour *tour, int s)
+{
+  return tour->segment[s].reversed ? tour->segment[s].last : tour->segment[s].first;
+}
+
+static inline int
+LST_tail(const LST_tour *tour, int s)
+{
+  return tour->segment[s].reversed ? tour->segment[s].first : tour->segment[s].last;
+}
+
+static inline int
+LST_next(const LST_tour *tour, int c)
+{
+  const struct LST_segment *s = &tour->segment[tour->parent[c]];
+
+  if (!s->reversed)
+    return (c != s->last) ? tour->succ[c] : LST_head(tour,s->next);
+  return (c != s->first) ? tour->pred[c] : LST_head(tour,s->next);
+}
+
+static inline int
+LST_prev(const LST_tour *tour, int c)
+{
+  const struct LST_segment *s = &tour->segment[tour->parent[c]];
+
+  if (!s->reversed)
+    return (c != s->first) ? tour->pred[c] : LST_tail(tour,s->prev);
+  return (c != s->last) ? tour->succ[c] : LST_tail(tour,s->prev);
+}
+
+/* Number of cities before c in its segment along the tour */
+static inline int
+LST_offset(const LST_tour *tour, int c)
+{
+  const struct LST_segment *s = &tour->segment[tour->parent[c]];
+
+  return s->reversed ? tour->rank[s->last] - tour->rank[c]
+                     : tour->rank[c] - tour->rank[s->first];
+}
+
+static inline int
+LST_position(const LST_tour *tour, int c)
+{
+  int p = tour->segment[tour->parent[c]].position + LST_offset(tour,c);
+
+  return (p >= tour->no_cities) ? p - tour->no_cities : p;
+}
+
+/* Whether b is on the path from a to c following LST_next, ends
+   included */
+static inline int
+LST_between(const LST_tour *tour, int a, int b, int c)
+{
+  int n = tour->no_cities, pa = LST_position(tour,a);
+
+  return (LST_position(tour,b) - pa + n) % n <= (LST_position(tour,c) - pa + n) % n;
+}
+
+/* A tour of n cities, to be given its cities by LST_tour_set */
+LST_tour *
+LST_tour_allocate(int n);
+
+void
+LST_tour_free(LST_tour *tour);
+
+/* Set the tour to the one in which city c is at position[c], position
+   being a permutation of 0 to n-1 */
+void
+LST_tour_set(LST_tour *tour, const int *position);
+
+/* Reverse the path from city a to city b following LST_next */
+void
+LST_reverse(LST_tour *tour, int a, int b);
+
+#endif /* LS_TWO_LEVEL_LIST */
@@ -54,12 +54,21 @@
 #include <time.h>
 #include <stddef.h>
 #include <error.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "evaluate.h"
+#include "ptspParser.h"
+#include "expectedCost.h"
+#include "instanceCacheFile.h"
 #include <gsl/gsl_math.h>
 
 
 struct problem instance;
 
+/* Largest number of threads evaluating the solutions */
+#define MAX_THREADS 1024
+
+
 
 static double
 dtrunc (double x)
@@ -178,301 +187,128 @@ att_distance (long int i, long int j)
 }
 
 
+static void
+set_distance(const char *edge_weight_type)
+/*
+      FUNCTION: set the pointer to the distance function
+      INPUT:    EDGE_WEIGHT_TYPE of the instance
+      OUTPUT:   none
+      COMMENTS: has to be one of EUC_2D, CEIL_2D, GEO, or ATT, everything
+                else fails
+*/
+{
+  if ( strcmp("EUC_2D", edge_weight_type) == 0 )
+    distance = round_distance;
+  else if ( strcmp("CEIL_2D", edge_weight_type) == 0 )
+    distance = ceil_distance;
+  else if ( strcmp("GEO", edge_weight_type) == 0 )
+    distance = geo_distance;
+  else if ( strcmp("ATT", edge_weight_type) == 0 )
+    distance = att_distance;
+  else
+    error(EXIT_FAILURE,0,"EDGE_WEIGHT_TYPE %s not implemented",
+          edge_weight_type);
+}
+
+
 struct point
       *read_ptsp(const char *ptsp_file_name)
       /*
             FUNCTION: parse and read instance file
             INPUT:    instance name
             OUTPUT:   list of coordinates for all nodes
-            COMMENTS: Instance files have to be in PTSPLIB format, otherwise procedure fails
+            COMMENTS: Instance files have to be in PTSPLIB format, possibly
+                      compressed with gzip, otherwise procedure fails; the
+                      parser is shared with ptspls, see ../Bin/ptspParser.h
       */
   {
-    FILE         *ptsp_file;
-    char         buf[LINE_BUF_LEN];
-    long int     i, j;
-    struct point *nodeptr;
-
-
-    ptsp_file = fopen(ptsp_file_name, "r");
-    if ( ptsp_file == NULL )
-      {
-        fprintf(stderr,"No instance file specified, abort\n");
-        exit(1);
-      }
-    assert(ptsp_file != NULL);
-    /*printf("\nreading tsp-file %s ... \n\n", tsp_file_name);*/
-
-    fscanf(ptsp_file,"%s", buf);
-    while ( strcmp("NODE_COORD_SECTION", buf) != 0 )
-      {
-        if ( strcmp("NAME", buf) == 0 )
-          {
-            fscanf(ptsp_file, "%s", buf);
-            TRACE ( printf("%s ", buf); )
-            fscanf(ptsp_file, "%s", buf);
-            strcpy(instance.name, buf);
-            TRACE ( printf("%s \n", instance.name); )
-            buf[0]=0;
-          }
-        else if ( strcmp("NAME:", buf) == 0 )
-          {
-            fscanf(ptsp_file, "%s", buf);
-            strcpy(instance.name, buf);
-            TRACE ( printf("%s \n", instance.name); )
-            buf[0]=0;
-          }
-        else if ( strcmp("COMMENT", buf) == 0 )
-          {
-            fgets(buf, LINE_BUF_LEN, ptsp_file);
-            TRACE ( printf("%s", buf); )
-            buf[0]=0;
-          }
-        else if ( strcmp("COMMENT:", buf) == 0 )
-          {
-            fgets(buf, LINE_BUF_LEN, ptsp_file);
-            TRACE ( printf("%s", buf); )
-            buf[0]=0;
-          }
-        else if ( strcmp("TYPE", buf) == 0 )
-          {
-            fscanf(ptsp_file, "%s", buf);
-            TRACE ( printf("%s ", buf); )
-            fscanf(ptsp_file, "%s", buf);
-            TRACE ( printf("%s\n", buf); )
-            if( strcmp("PTSP", buf) != 0 )
-              {
-                fprintf(stderr,"\n Not a TSP or PTSP instance in TSPLIB format !!\n");
-                exit(1);
-              }
-            buf[0]=0;
-          }
-        else if ( strcmp("TYPE:", buf) == 0 )
-          {
-            fscanf(ptsp_file, "%s", buf);
-            TRACE ( printf("%s\n", buf); )
-            if( strcmp("PTSP", buf) != 0 )
-              {
-                fprintf(stderr,"\n Not a TSP or PTSP instance in TSPLIB format !!\n");
-                exit(1);
-              }
-            buf[0]=0;
-          }
-        else if( strcmp("DIMENSION", buf) == 0 )
-          {
-            fscanf(ptsp_file, "%s", buf);
-            TRACE ( printf("%s ", buf); );
-            fscanf(ptsp_file, "%ld", &n);
-            instance.n = n;
-
-            TRACE ( printf("%ld\n", n); );
-            assert ( n > 2 && n < 20000);
-            buf[0]=0;
-          }
-        else if ( strcmp("DIMENSION:", buf) == 0 )
-          {
-            fscanf(ptsp_file, "%ld", &n);
-            instance.n = n;
-            TRACE ( printf("%ld\n", n); );
-            assert ( n > 2 && n < 6000);
-            buf[0]=0;
-          }
-        else if( strcmp("DISPLAY_DATA_TYPE", buf) == 0 )
-          {
-            fgets(buf, LINE_BUF_LEN, ptsp_file);
-            TRACE ( printf("%s", buf); );
-            buf[0]=0;
-          }
-        else if ( strcmp("DISPLAY_DATA_TYPE:", buf) == 0 )
-          {
-            fgets(buf, LINE_BUF_LEN, ptsp_file);
-            TRACE ( printf("%s", buf); );
-            buf[0]=0;
-          }
-        else if( strcmp("EDGE_WEIGHT_TYPE", buf) == 0 )
-          {
-            buf[0]=0;
-            fscanf(ptsp_file, "%s", buf);
-            TRACE ( printf("%s ", buf); );
-            buf[0]=0;
-            fscanf(ptsp_file, "%s", buf);
-            TRACE ( printf("%s\n", buf); );
-            if ( strcmp("EUC_2D", buf) == 0 )
-              {
-                distance = round_distance;
-              }
-            else if ( strcmp("CEIL_2D", buf) == 0 )
-              {
-                distance = ceil_distance;
-              }
-            else if ( strcmp("GEO", buf) == 0 )
-              {
-                distance = geo_distance;
-              }
-            else if ( strcmp("ATT", buf) == 0 )
-              {
-                distance = att_distance;
-              }
-            else
-              fprintf(stderr,"EDGE_WEIGHT_TYPE %s not implemented\n",buf);
-            strcpy(instance.edge_weight_type, buf);
-            buf[0]=0;
-          }
-        else if( strcmp("EDGE_WEIGHT_TYPE:", buf) == 0 )
-          {
-            /* set pointer to appropriate distance function; has to be one of
-               EUC_2D, CEIL_2D, GEO, or ATT. Everything else fails */
-            buf[0]=0;
-            fscanf(ptsp_file, "%s", buf);
-            TRACE ( printf("%s\n", buf); )
-            /*printf("%s\n", buf);
-            printf("%s\n", buf);*/
-            if ( strcmp("EUC_2D", buf) == 0 )
-              {
-                distance = round_distance;
-              }
-            else if ( strcmp("CEIL_2D", buf) == 0 )
-              {
-                distance = ceil_distance;
-              }
-            else if ( strcmp("GEO", buf) == 0 )
-              {
-                distance = geo_distance;
-              }
-            else if ( strcmp("ATT", buf) == 0 )
-              {
-                distance = att_distance;
-              }
-            else
-              {
-                fprintf(stderr,"EDGE_WEIGHT_TYPE %s not implemented\n",buf);
-                exit(1);
-              }
-            strcpy(instance.edge_weight_type, buf);
-            buf[0]=0;
-          }
-        buf[0]=0;
-        fscanf(ptsp_file,"%s", buf);
-      }
-
-
-    if( strcmp("NODE_COORD_SECTION", buf) == 0 )
-      {
-        TRACE ( printf("found section contaning the node coordinates\n"); )
-      }
-    else
-      {
-        fprintf(stderr,"\n\nSome error ocurred finding start of coordinates from tsp file !!\n");
-        exit(1);
-      }
-
-    if( (nodeptr = malloc(sizeof(struct point) * n)) == NULL )
-      exit(EXIT_FAILURE);
-    else
-      {
-        for ( i = 0 ; i < n ; i++ )
-          {
-            fscanf(ptsp_file,"%ld %lf %lf %lf", &j, &nodeptr[i].x, &nodeptr[i].y, &nodeptr[i].p);
-          }
-      }
-
-    rewind(ptsp_file);
-    fclose(ptsp_file);
-
-    return (nodeptr);
+    PTSP_instance ptsp;
+
+    PTSP_read(ptsp_file_name, &ptsp);
+    strcpy(instance.name, ptsp.name);
+    strcpy(instance.edge_weight_type, ptsp.edge_weight_type);
+    n = instance.n = ptsp.n;
+    set_distance(ptsp.edge_weight_type);
+
+    /* The nodes are stored as an array of struct point */
+    return ((struct point *)ptsp.nodes);
 
   }
 
 
 
-long
-int ** compute_distances(void)
+/* Instance cache mapped by read_cache, if any */
+static const LS_cache_header *cache;
+
+
+int
+read_cache(const char *cache_file_name)
 /*
-      FUNCTION: computes the matrix of all intercity distances
-      INPUT:    none
-      OUTPUT:   pointer to distance matrix, has to be freed when program stops
+      FUNCTION: map an instance cache built by ptspcache
+      INPUT:    cache file name
+      OUTPUT:   1 if the file is an instance cache, 0 otherwise
+      COMMENTS: the coordinates, and the distance matrix if it has the
+                layout of LS_triangular_index, are used in place without
+                copies; they must not be freed
 */
 {
-  long int     i, j;
-  long int     **matrix;
+  const LS_cache_header *header = LS_cache_map_file(cache_file_name);
+
+  if (!header)
+    return 0;
+  cache = header;
+  if (LS_cache_file_is_stale(header))
+    error(EXIT_FAILURE,0,"Instance cache %s is out of date with respect to %s",
+          cache_file_name,LS_cache_file_source(header));
+
+  n = instance.n = header->n;
+  instance.nodeptr = (struct point *)((char *)header + header->points_offset);
+  strcpy(instance.edge_weight_type, header->edge_weight_type);
+  set_distance(instance.edge_weight_type);
+
+  instance.distance = NULL;
+  if (header->distance_offset &&
+      header->distance_size == sizeof(long int) &&
+      header->distance_flags == LS_CACHE_INTEGER_DISTANCE)
+    instance.distance = (long int *)((char *)header + header->distance_offset);
+  return 1;
+}
 
-  if((matrix = malloc(sizeof(long int) * n * n +
-                      sizeof(long int *) * n	 )) == NULL)
-    {
-      fprintf(stderr,"Out of memory, exit.");
-      exit(1);
-    }
 
-  for ( i = 0 ; i < n ; i++ )
-    {
-      matrix[i] = (long int *)(matrix + n) + i*n;
-      for ( j = 0  ; j < n ; j++ )
-        {
-          matrix[i][j] = distance(i,j);
-          /*printf("\n the Distance between %d and %d = %d \n",i,j,matrix[i][j]);*/
-        }
-    }
-  return matrix;
+/* Distances from city to the cities of the tour, for
+   PTSP_expected_cost */
+static void
+distance_row(long int city, const long int *tour, long int no_cities,
+             double *row, void *data)
+{
+  long int r;
+
+  if (instance.distance)
+    for (r=0; r<no_cities; r++)
+      row[r] = instance.distance[LS_triangular_index(city,tour[r])];
+  else
+    /* As the matrix, with the larger index first */
+    for (r=0; r<no_cities; r++)
+      row[r] = (city >= tour[r]) ? distance(city,tour[r]) : distance(tour[r],city);
 }
 
 
 long int
 compute_expected_cost(long int *t)
 {
-  int no_cities = instance.n,s;
-  double expc = 0.0,partial=0.0;
-  double *prob_vec=NULL;
-  double **Q=NULL;
-  int i,r;
-  
-      prob_vec = (double *) calloc(no_cities,sizeof(double));
-      if (!prob_vec)
-        error(EXIT_FAILURE,0,"Cannot allocate memory");
-      for(i=0; i<no_cities; i++)
-        {
-          prob_vec[i]= instance.nodeptr[i].p;
-        }
-
-      Q = calloc(no_cities,sizeof(double *));
-      if(!Q)
-        error(EXIT_FAILURE,0,"Cannot allocate memory");
-      for(i=0; i < no_cities; i++)
-        {
-          Q[i] = calloc(no_cities, sizeof(double));
-          if(!Q[i])
-            error(EXIT_FAILURE,0,"Cannot allocate memory");
-        }
+  double *prob_vec;
+  double expc;
+  long int i;
 
-      for(i=0; i<no_cities; i++)
-        {
-          Q[t[i]][t[i]] = 0.0;
-          Q[t[i]][t[(i+1)%no_cities]]= 1.0;
-		for(s=2; s<no_cities; s++)
-                {
-                  Q[t[i]][t[(i+s)%no_cities]] = Q[t[i]][t[(i+s-1)%no_cities]]*(1.0 - prob_vec[t[(i+s-1)%no_cities]]);
-		  }
-        }
-
-      for (i=0; i<n; i++)
-        {
-          for(r=0; r< n ; r++)
-            {
-              if(i != r )
-                {
-                  partial = instance.distance[t[i]][t[r]]
-                            * prob_vec[t[i]]
-                            * prob_vec[t[r]]
-                            * Q[t[i]][t[r]];
-                            
-                  expc += partial;
-                  }
-              }
-        }
+  prob_vec = malloc(n*sizeof(double));
+  if (!prob_vec)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (i=0; i<n; i++)
+    prob_vec[i] = instance.nodeptr[i].p;
 
-      for(i=0; i < no_cities; i++)
-        free(Q[i]);
-      free(Q);
-      free(prob_vec);
+  expc = PTSP_expected_cost(n,t,prob_vec,distance_row,NULL);
 
+  free(prob_vec);
   return (long int)expc;
 }
 
@@ -495,6 +331,101 @@ printTour( long int *t )
 
 
 
+/* The solutions of a result file, evaluated by several threads */
+struct evaluation
+  {
+    long int no_tours;
+    long int *tours;              /* n cities for each solution */
+    double *times;
+    long int *costs;
+    double *probability;
+    long int block;               /* solutions evaluated one after the other */
+    long int next;                /* next block to be evaluated */
+  };
+
+/* Solutions evaluated from scratch, at least, so that the rounding
+   errors of the changes of the cost do not add up over a long block */
+#define FULL_EVALUATION_PERIOD 100
+
+/* Consecutive solutions of a trajectory usually differ by a move: each
+   one but the first of a block is evaluated from the change of the cost
+   with respect to the previous one, unless they differ too much or it is
+   the turn of a full evaluation */
+static void
+*evaluate_tours(void *arg)
+{
+  struct evaluation *evaluation = arg;
+  long int b, k, end;
+  double cost = 0.0, change;
+
+  while ((b = __sync_fetch_and_add(&evaluation->next,1))*evaluation->block
+         < evaluation->no_tours)
+    {
+      end = GSL_MIN((b+1)*evaluation->block,evaluation->no_tours);
+      for (k=b*evaluation->block; k<end; k++)
+        {
+          if ((k - b*evaluation->block) % FULL_EVALUATION_PERIOD != 0 &&
+              PTSP_expected_cost_change(n,evaluation->tours + (k-1)*n,
+                                        evaluation->tours + k*n,
+                                        evaluation->probability,
+                                        distance_row,NULL,&change))
+            cost += change;
+          else
+            cost = PTSP_expected_cost(n,evaluation->tours + k*n,
+                                      evaluation->probability,
+                                      distance_row,NULL);
+          evaluation->costs[k] = (long int)cost;
+        }
+    }
+  return NULL;
+}
+
+/* Read the solutions logged in result_file up to the given time */
+static void
+read_tours(FILE *result_file, double time, struct evaluation *evaluation)
+{
+  char round_str[20];
+  int round,j;
+  char total_time_str[20];
+  double total_time;
+  char tour_str[20];
+  long int *tour, size = 0;
+
+  evaluation->no_tours = 0;
+  evaluation->tours = NULL;
+  evaluation->times = NULL;
+  while(!feof(result_file))
+    {
+
+      fscanf(result_file,"%s %d %s %lf %s",round_str,&round,total_time_str,&total_time,tour_str);
+
+
+      if(feof(result_file) || (strcmp("Step", round_str)!=0) || (total_time > time))
+        break;
+
+      if (evaluation->no_tours == size)
+        {
+          size = size ? 2*size : 16;
+          evaluation->tours = realloc(evaluation->tours,size*n*sizeof(long int));
+          evaluation->times = realloc(evaluation->times,size*sizeof(double));
+          if (!evaluation->tours || !evaluation->times)
+            error(EXIT_FAILURE,0,"Cannot allocate memory");
+        }
+      tour = evaluation->tours + evaluation->no_tours*n;
+      for( j = 0 ; j < instance.n ; j++ )
+        {
+          fscanf(result_file,"%ld",&tour[j]);
+          if (feof(result_file))
+            break;
+        }
+
+      if (feof(result_file))
+        break;
+      evaluation->times[evaluation->no_tours++] = total_time;
+    }
+}
+
+
 const char *argp_program_version = "Evaluator for the PTSP solutions version 1.0";
 const char *argp_program_bug_address ="<prasannaprakash@gmail.com>";
 
@@ -508,6 +439,15 @@ static struct argp_option options[] =
     {
       {"time", 't', "TIME",0, "Time up to which the solution cost needs to be computed."
       },
+      {"threads", 'j', "N",0, "Number of solutions evaluated at once [default: the number of processors]. "
+       "The costs are printed in the order of the solutions anyway."
+      },
+      {"full", 'f', 0,0, "Evaluate every solution from scratch, and not from the change "
+       "of the cost with respect to the previous one. The cost computed from the "
+       "change differs from that computed from scratch by rounding only, less than "
+       "1e-12 of it, a full evaluation being made every 100 solutions; the printed "
+       "cost, truncated, may then differ by one."
+      },
       { 0 }
     };
 
@@ -516,6 +456,8 @@ struct arguments
   {
     char *args[2];                /* ARG1 & ARG2 */
     double time;
+    int threads;
+    int full;
   };
 
 /* Parse a single option. */
@@ -531,6 +473,14 @@ parse_opt (int key, char *arg, struct argp_state *state)
     case 't':
       arguments->time = atof(arg);
       break;
+    case 'j':
+      arguments->threads = atoi(arg);
+      if (arguments->threads < 1 || arguments->threads > MAX_THREADS)
+        argp_error(state,"Illegal number of threads");
+      break;
+    case 'f':
+      arguments->full = 1;
+      break;
     case ARGP_KEY_ARG:
       if (state->arg_num >= 2)
         /* Too many arguments. */
@@ -561,16 +511,16 @@ int main (int argc, char **argv)
   struct arguments arguments;
   char *instance_file_name;
   char *result_file_name;
-  char round_str[20];
-  int round,j;
-  char total_time_str[20];
-  double total_time;
-  char tour_str[20];
-  long int *tour;
   FILE  *result_file;
+  struct evaluation evaluation;
+  pthread_t *threads;
+  long int k;
+  int t, no_threads;
 
   /* Default value. */
   arguments.time = 0.0;
+  arguments.threads = 0;
+  arguments.full = 0;
 
 
   /* Parse arguments; */
@@ -579,8 +529,8 @@ int main (int argc, char **argv)
   instance_file_name=arguments.args[0];
   result_file_name=arguments.args[1];
 
-  instance.nodeptr=read_ptsp(instance_file_name);
-  instance.distance=compute_distances();
+  if (!read_cache(instance_file_name))
+    instance.nodeptr=read_ptsp(instance_file_name);
 
 
 
@@ -589,11 +539,6 @@ int main (int argc, char **argv)
     arguments.time=DBL_MAX;
 
 
-  tour = (long int *) calloc(instance.n,sizeof(long int));
-  if (!tour)
-    error(EXIT_FAILURE,0,"Cannot allocate memory");
-
-
   result_file = fopen(result_file_name, "r");
   if (result_file == NULL)
     {
@@ -601,34 +546,57 @@ int main (int argc, char **argv)
       exit(1);
     }
 
-  while(!feof(result_file))
-    {
-
-      fscanf(result_file,"%s %d %s %lf %s",round_str,&round,total_time_str,&total_time,tour_str);
-
-
-      if(feof(result_file) || (strcmp("Step", round_str)!=0) || (total_time > arguments.time))
-        break;
-
-      for( j = 0 ; j < instance.n ; j++ )
-        {
-          fscanf(result_file,"%ld",&tour[j]);
-          if (feof(result_file))
-            break;
-        }
-
-      if (feof(result_file))
-        break;
-      printf("%lf\t%ld\n",total_time,compute_expected_cost(tour));
+  read_tours(result_file,arguments.time,&evaluation);
+  evaluation.costs = malloc((evaluation.no_tours+1)*sizeof(long int));
+  if (!evaluation.costs)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  evaluation.probability = malloc(n*sizeof(double));
+  if (!evaluation.probability)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (k=0; k<n; k++)
+    evaluation.probability[k] = instance.nodeptr[k].p;
+  evaluation.next = 0;
+
+  /* The calling thread is one of them; the solutions left by the
+     threads that could not be created are evaluated by the others. Each
+     thread evaluates a block of consecutive solutions. */
+  no_threads = arguments.threads ? arguments.threads : sysconf(_SC_NPROCESSORS_ONLN);
+  no_threads = GSL_MAX(GSL_MIN(no_threads,evaluation.no_tours),1);
+  evaluation.block = arguments.full ? 1 : (evaluation.no_tours+no_threads-1)/no_threads;
+  threads = malloc(no_threads*sizeof(pthread_t));
+  if (!threads)
+    error(EXIT_FAILURE,0,"Cannot allocate memory");
+  for (t=1; t<no_threads; t++)
+    if (pthread_create(&threads[t],NULL,evaluate_tours,&evaluation))
+      break;
+  no_threads = t;
+  evaluate_tours(&evaluation);
+  for (t=1; t<no_threads; t++)
+    pthread_join(threads[t],NULL);
 
-    }
+  for (k=0; k<evaluation.no_tours; k++)
+    printf("%lf\t%ld\n",evaluation.times[k],evaluation.costs[k]);
 
 
   rewind(result_file);
   fclose(result_file);
-  free(tour);
-  free(instance.distance);
-  free(instance.nodeptr);
+  free(threads);
+  free(evaluation.tours);
+  free(evaluation.times);
+  free(evaluation.costs);
+  free(evaluation.probability);
+  if (cache)
+    {
+      if ((char *)instance.distance < (char *)cache ||
+          (char *)instance.distance >= (char *)cache + cache->file_size)
+        free(instance.distance);
+      LS_cache_unmap_file(cache);
+    }
+  else
+    {
+      free(instance.distance);
+      free(instance.nodeptr);
+    }
 
   exit(0);
 }
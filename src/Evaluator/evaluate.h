@@ -44,6 +44,8 @@
 
 *****************************************************************************************/
 
+#include "triangularIndex.h"
+
 #define LINE_BUF_LEN 100
 #define TRACE( x )
 #define IA 16807
@@ -68,11 +70,12 @@ struct problem
     char          edge_weight_type[LINE_BUF_LEN];  /* selfexplanatory */
     long int      n;                      /* number of cities */
     struct point  *nodeptr;               /* array of structs containing coordinates of nodes */
-    long int      **distance;	        	/* distance matrix: distance[i][j] gives distance
-    								   between city i und j */
+    long int      *distance;	        	/* distance matrix: distance[LS_triangular_index(i,j)]
+    								   gives distance between city i und j; only
+    								   from an instance cache, NULL otherwise */
   };
-extern struct problem instance;
 
+extern struct problem instance;
 
 long int n;
 long int *currentnodeptr;
@@ -96,8 +99,8 @@ att_distance (long int i, long int j);
 struct point
       *read_ptsp(const char *ptsp_file_name);
 
-long int
-** compute_distances(void);
+int
+read_cache(const char *cache_file_name);
 
 long int
 compute_expected_cost(long int *t);